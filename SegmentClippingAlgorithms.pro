@@ -8,12 +8,57 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# счётчики и таймеры отсечения в строке состояния (clipcore/clipstats.h)
+#DEFINES += CLIP_ENABLE_STATS
+
 SOURCES += \
+    clipcore/batchclipper.cpp \
+    clipcore/binaryformat.cpp \
+    clipcore/bufferedwriter.cpp \
+    clipcore/clipio.cpp \
+    clipcore/clipstats.cpp \
+    clipcore/convexwindow.cpp \
+    clipcore/gridindex.cpp \
+    clipcore/incrementalclipper.cpp \
+    clipcore/polygonbatch.cpp \
+    clipcore/polygonclipper.cpp \
+    clipcore/polylineclipper.cpp \
+    clipcore/parallelclipper.cpp \
+    clipcore/pointhash.cpp \
+    clipcore/resultexport.cpp \
+    clipcore/segmentclipper.cpp \
+    clipcore/segmentengine.cpp \
+    clipcore/streamclipper.cpp \
+    clipcore/textparser.cpp \
+    clipcore/threadpool.cpp \
+    clipcore/tileclipper.cpp \
     clippingcanvas.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    clipcore/batchclipper.h \
+    clipcore/binaryformat.h \
+    clipcore/bufferedwriter.h \
+    clipcore/clipio.h \
+    clipcore/clipstats.h \
+    clipcore/convexwindow.h \
+    clipcore/genericclipper.h \
+    clipcore/gridindex.h \
+    clipcore/incrementalclipper.h \
+    clipcore/polygonbatch.h \
+    clipcore/polygonclipper.h \
+    clipcore/polylineclipper.h \
+    clipcore/parallelclipper.h \
+    clipcore/pointhash.h \
+    clipcore/qtpointtraits.h \
+    clipcore/resultexport.h \
+    clipcore/segmentclipper.h \
+    clipcore/segmentengine.h \
+    clipcore/streamclipper.h \
+    clipcore/textparser.h \
+    clipcore/threadpool.h \
+    clipcore/tileclipper.h \
     clippingcanvas.h \
     mainwindow.h
 
@@ -0,0 +1,284 @@
+#include "batchclipper.h"
+#include "segmentclipper.h"
+#include <algorithm>
+#include <limits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  define CLIP_X86_SIMD 1
+#  include <immintrin.h>
+#endif
+
+namespace clip {
+
+void SegmentArrays::resize(qsizetype n)
+{
+    x1.resize(n);
+    y1.resize(n);
+    x2.resize(n);
+    y2.resize(n);
+}
+
+SegmentColumns SegmentArrays::columns() const
+{
+    SegmentColumns c;
+    c.x1 = x1.constData();
+    c.y1 = y1.constData();
+    c.x2 = x2.constData();
+    c.y2 = y2.constData();
+    c.count = size();
+    return c;
+}
+
+SegmentArrays SegmentArrays::fromLines(const QVector<QLineF> &lines)
+{
+    return fromLines(lines.constData(), lines.size());
+}
+
+SegmentArrays SegmentArrays::fromLines(const QLineF *lines, qsizetype count)
+{
+    SegmentArrays a;
+    a.resize(count);
+    for (qsizetype i = 0; i < count; ++i) {
+        a.x1[i] = lines[i].x1();
+        a.y1[i] = lines[i].y1();
+        a.x2[i] = lines[i].x2();
+        a.y2[i] = lines[i].y2();
+    }
+    return a;
+}
+
+BatchKernel detectBatchKernel()
+{
+#ifdef CLIP_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return BatchKernel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return BatchKernel::SSE2;
+#endif
+    return BatchKernel::Scalar;
+}
+
+QString batchKernelName(BatchKernel kernel)
+{
+    switch (kernel) {
+    case BatchKernel::Scalar: return "scalar";
+    case BatchKernel::SSE2:   return "sse2";
+    case BatchKernel::AVX2:   return "avx2";
+    }
+    return QString();
+}
+
+namespace {
+
+struct Bounds
+{
+    double xmin, ymin, xmax, ymax;
+};
+
+using Output = SegmentOutputColumns;
+
+// ---------- скалярное ядро (и хвост для SIMD) ----------
+
+void clipScalar(const SegmentColumns &in, const Bounds &w,
+                const Output &out, qsizetype begin)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+
+    for (qsizetype i = begin; i < in.count; ++i) {
+        const double x1 = in.x1[i], y1 = in.y1[i];
+        const double dx = in.x2[i] - x1;
+        const double dy = in.y2[i] - y1;
+
+        bool reject = dx * dx + dy * dy < kMinLength2;
+        double t0 = 0.0, t1 = 1.0;
+
+        const double p[4] = { 0.0 - dx, dx, 0.0 - dy, dy };
+        const double q[4] = { x1 - w.xmin, w.xmax - x1,
+                              y1 - w.ymin, w.ymax - y1 };
+        for (int k = 0; k < 4; ++k) {
+            const double r = q[k] / p[k];
+            reject |= (p[k] == 0.0) & (q[k] < 0.0);
+            t0 = std::max(t0, p[k] < 0.0 ? r : -inf);
+            t1 = std::min(t1, p[k] > 0.0 ? r : inf);
+        }
+
+        const double ox1 = x1 + t0 * dx, oy1 = y1 + t0 * dy;
+        const double ox2 = x1 + t1 * dx, oy2 = y1 + t1 * dy;
+        const double ex = ox2 - ox1, ey = oy2 - oy1;
+
+        out.x1[i] = ox1;
+        out.y1[i] = oy1;
+        out.x2[i] = ox2;
+        out.y2[i] = oy2;
+        out.mask[i] = !reject && t0 <= t1 && ex * ex + ey * ey >= kMinLength2;
+    }
+}
+
+#ifdef CLIP_X86_SIMD
+
+// ---------- SSE2: по 2 отрезка ----------
+
+inline __m128d select128(__m128d m, __m128d a, __m128d b)
+{
+    return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+}
+
+qsizetype clipSse2(const SegmentColumns &in, const Bounds &w, const Output &out)
+{
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one  = _mm_set1_pd(1.0);
+    const __m128d pinf = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    const __m128d ninf = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m128d minLen2 = _mm_set1_pd(kMinLength2);
+    const __m128d xmin = _mm_set1_pd(w.xmin), xmax = _mm_set1_pd(w.xmax);
+    const __m128d ymin = _mm_set1_pd(w.ymin), ymax = _mm_set1_pd(w.ymax);
+
+    qsizetype i = 0;
+    for (; i + 2 <= in.count; i += 2) {
+        const __m128d x1 = _mm_loadu_pd(in.x1 + i);
+        const __m128d y1 = _mm_loadu_pd(in.y1 + i);
+        const __m128d dx = _mm_sub_pd(_mm_loadu_pd(in.x2 + i), x1);
+        const __m128d dy = _mm_sub_pd(_mm_loadu_pd(in.y2 + i), y1);
+
+        __m128d reject = _mm_cmplt_pd(
+            _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), minLen2);
+        __m128d t0 = zero, t1 = one;
+
+        const __m128d p[4] = { _mm_sub_pd(zero, dx), dx, _mm_sub_pd(zero, dy), dy };
+        const __m128d q[4] = { _mm_sub_pd(x1, xmin), _mm_sub_pd(xmax, x1),
+                               _mm_sub_pd(y1, ymin), _mm_sub_pd(ymax, y1) };
+        for (int k = 0; k < 4; ++k) {
+            const __m128d r = _mm_div_pd(q[k], p[k]);
+            reject = _mm_or_pd(reject, _mm_and_pd(_mm_cmpeq_pd(p[k], zero),
+                                                  _mm_cmplt_pd(q[k], zero)));
+            t0 = _mm_max_pd(t0, select128(_mm_cmplt_pd(p[k], zero), r, ninf));
+            t1 = _mm_min_pd(t1, select128(_mm_cmpgt_pd(p[k], zero), r, pinf));
+        }
+
+        const __m128d ox1 = _mm_add_pd(x1, _mm_mul_pd(t0, dx));
+        const __m128d oy1 = _mm_add_pd(y1, _mm_mul_pd(t0, dy));
+        const __m128d ox2 = _mm_add_pd(x1, _mm_mul_pd(t1, dx));
+        const __m128d oy2 = _mm_add_pd(y1, _mm_mul_pd(t1, dy));
+        const __m128d ex = _mm_sub_pd(ox2, ox1), ey = _mm_sub_pd(oy2, oy1);
+
+        const __m128d visible = _mm_andnot_pd(reject, _mm_and_pd(
+            _mm_cmple_pd(t0, t1),
+            _mm_cmpge_pd(_mm_add_pd(_mm_mul_pd(ex, ex), _mm_mul_pd(ey, ey)), minLen2)));
+
+        _mm_storeu_pd(out.x1 + i, ox1);
+        _mm_storeu_pd(out.y1 + i, oy1);
+        _mm_storeu_pd(out.x2 + i, ox2);
+        _mm_storeu_pd(out.y2 + i, oy2);
+
+        const int bits = _mm_movemask_pd(visible);
+        out.mask[i]     = bits & 1;
+        out.mask[i + 1] = (bits >> 1) & 1;
+    }
+    return i;
+}
+
+// ---------- AVX2: по 4 отрезка ----------
+
+__attribute__((target("avx2")))
+qsizetype clipAvx2(const SegmentColumns &in, const Bounds &w, const Output &out)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one  = _mm256_set1_pd(1.0);
+    const __m256d pinf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    const __m256d ninf = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+    const __m256d minLen2 = _mm256_set1_pd(kMinLength2);
+    const __m256d xmin = _mm256_set1_pd(w.xmin), xmax = _mm256_set1_pd(w.xmax);
+    const __m256d ymin = _mm256_set1_pd(w.ymin), ymax = _mm256_set1_pd(w.ymax);
+
+    qsizetype i = 0;
+    for (; i + 4 <= in.count; i += 4) {
+        const __m256d x1 = _mm256_loadu_pd(in.x1 + i);
+        const __m256d y1 = _mm256_loadu_pd(in.y1 + i);
+        const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(in.x2 + i), x1);
+        const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(in.y2 + i), y1);
+
+        __m256d reject = _mm256_cmp_pd(
+            _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+            minLen2, _CMP_LT_OQ);
+        __m256d t0 = zero, t1 = one;
+
+        const __m256d p[4] = { _mm256_sub_pd(zero, dx), dx,
+                               _mm256_sub_pd(zero, dy), dy };
+        const __m256d q[4] = { _mm256_sub_pd(x1, xmin), _mm256_sub_pd(xmax, x1),
+                               _mm256_sub_pd(y1, ymin), _mm256_sub_pd(ymax, y1) };
+        for (int k = 0; k < 4; ++k) {
+            const __m256d r = _mm256_div_pd(q[k], p[k]);
+            reject = _mm256_or_pd(reject, _mm256_and_pd(
+                _mm256_cmp_pd(p[k], zero, _CMP_EQ_OQ),
+                _mm256_cmp_pd(q[k], zero, _CMP_LT_OQ)));
+            t0 = _mm256_max_pd(t0, _mm256_blendv_pd(
+                ninf, r, _mm256_cmp_pd(p[k], zero, _CMP_LT_OQ)));
+            t1 = _mm256_min_pd(t1, _mm256_blendv_pd(
+                pinf, r, _mm256_cmp_pd(p[k], zero, _CMP_GT_OQ)));
+        }
+
+        const __m256d ox1 = _mm256_add_pd(x1, _mm256_mul_pd(t0, dx));
+        const __m256d oy1 = _mm256_add_pd(y1, _mm256_mul_pd(t0, dy));
+        const __m256d ox2 = _mm256_add_pd(x1, _mm256_mul_pd(t1, dx));
+        const __m256d oy2 = _mm256_add_pd(y1, _mm256_mul_pd(t1, dy));
+        const __m256d ex = _mm256_sub_pd(ox2, ox1), ey = _mm256_sub_pd(oy2, oy1);
+
+        const __m256d visible = _mm256_andnot_pd(reject, _mm256_and_pd(
+            _mm256_cmp_pd(t0, t1, _CMP_LE_OQ),
+            _mm256_cmp_pd(_mm256_add_pd(_mm256_mul_pd(ex, ex), _mm256_mul_pd(ey, ey)),
+                          minLen2, _CMP_GE_OQ)));
+
+        _mm256_storeu_pd(out.x1 + i, ox1);
+        _mm256_storeu_pd(out.y1 + i, oy1);
+        _mm256_storeu_pd(out.x2 + i, ox2);
+        _mm256_storeu_pd(out.y2 + i, oy2);
+
+        const int bits = _mm256_movemask_pd(visible);
+        out.mask[i]     = bits & 1;
+        out.mask[i + 1] = (bits >> 1) & 1;
+        out.mask[i + 2] = (bits >> 2) & 1;
+        out.mask[i + 3] = (bits >> 3) & 1;
+    }
+    return i;
+}
+
+#endif // CLIP_X86_SIMD
+
+} // namespace
+
+void clipLiangBarskyBatch(const SegmentColumns &in,
+                          const QRectF &window,
+                          SegmentArrays &out,
+                          QVector<quint8> &mask,
+                          BatchKernel kernel)
+{
+    out.resize(in.count);
+    mask.resize(in.count);
+
+    clipLiangBarskyBatch(in, window,
+                         Output { out.x1.data(), out.y1.data(), out.x2.data(),
+                                  out.y2.data(), mask.data() },
+                         kernel);
+}
+
+void clipLiangBarskyBatch(const SegmentColumns &in,
+                          const QRectF &window,
+                          const SegmentOutputColumns &out,
+                          BatchKernel kernel)
+{
+    const Bounds w { window.left(), window.top(), window.right(), window.bottom() };
+
+    qsizetype done = 0;
+#ifdef CLIP_X86_SIMD
+    if (kernel == BatchKernel::AVX2)
+        done = clipAvx2(in, w, out);
+    else if (kernel == BatchKernel::SSE2)
+        done = clipSse2(in, w, out);
+#else
+    Q_UNUSED(kernel);
+#endif
+    clipScalar(in, w, out, done);
+}
+
+} // namespace clip
@@ -0,0 +1,62 @@
+#pragma once
+#include <QVector>
+#include <QLineF>
+#include <QRectF>
+#include <QString>
+
+namespace clip {
+
+// Концы отрезков как структура массивов (x1[], y1[], x2[], y2[]) —
+// представление без владения, удобно и для QVector, и для отображённых файлов.
+struct SegmentColumns
+{
+    const double *x1 = nullptr;
+    const double *y1 = nullptr;
+    const double *x2 = nullptr;
+    const double *y2 = nullptr;
+    qsizetype count = 0;
+};
+
+// то же самое, но с собственным хранилищем
+struct SegmentArrays
+{
+    QVector<double> x1, y1, x2, y2;
+
+    qsizetype size() const { return x1.size(); }
+    void resize(qsizetype n);
+    SegmentColumns columns() const;
+
+    static SegmentArrays fromLines(const QVector<QLineF> &lines);
+    static SegmentArrays fromLines(const QLineF *lines, qsizetype count);
+};
+
+// куда писать результат пакетного ядра (массивы по count элементов)
+struct SegmentOutputColumns
+{
+    double *x1, *y1, *x2, *y2;
+    quint8 *mask;
+};
+
+// реализация пакетного ядра; выбирается во время работы по возможностям CPU
+enum class BatchKernel { Scalar, SSE2, AVX2 };
+
+BatchKernel detectBatchKernel();
+QString batchKernelName(BatchKernel kernel);
+
+// Пакетный Лианг–Барски без ветвлений: AVX2 — 4 отрезка за инструкцию,
+// SSE2 — 2, остаток и прочие платформы — скалярно. Результат совпадает с
+// clipLiangBarsky(): out[i] — видимая часть i-го отрезка, mask[i] != 0,
+// если она есть (для невидимых содержимое out[i] не определено).
+void clipLiangBarskyBatch(const SegmentColumns &in,
+                          const QRectF &window,
+                          SegmentArrays &out,
+                          QVector<quint8> &mask,
+                          BatchKernel kernel = detectBatchKernel());
+
+// то же с записью в готовые массивы (например, в часть большого буфера)
+void clipLiangBarskyBatch(const SegmentColumns &in,
+                          const QRectF &window,
+                          const SegmentOutputColumns &out,
+                          BatchKernel kernel = detectBatchKernel());
+
+} // namespace clip
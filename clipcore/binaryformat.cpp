@@ -0,0 +1,406 @@
+#include "binaryformat.h"
+#include "bufferedwriter.h"
+#include "clipstats.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clip {
+
+namespace {
+
+// части для параллельного отсечения и блок преобразования float32
+constexpr qsizetype kMappedPartSize = 1 << 16;
+constexpr qsizetype kFloatBlockSize = 1024;
+
+qint64 alignUp(qint64 v)
+{
+    return (v + kBinaryAlignment - 1) / kBinaryAlignment * kBinaryAlignment;
+}
+
+bool fail(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+BinaryHeader makeHeader(SceneKind kind, ColumnPrecision precision,
+                        qsizetype count, int columns, const QRectF &window)
+{
+    BinaryHeader h {};
+    std::memcpy(h.magic, kBinaryMagic, sizeof h.magic);
+    h.version = kBinaryVersion;
+    h.endianTag = kBinaryEndianTag;
+    h.kind = quint32(kind);
+    h.precision = quint32(precision);
+    h.count = quint64(count);
+    h.window[0] = window.left();
+    h.window[1] = window.top();
+    h.window[2] = window.right();
+    h.window[3] = window.bottom();
+    h.columnCount = quint32(columns);
+
+    const qint64 columnBytes = qint64(count) * qint64(precision);
+    qint64 offset = alignUp(sizeof(BinaryHeader));
+    for (int i = 0; i < columns; ++i) {
+        h.columnOffset[i] = quint64(offset);
+        offset = alignUp(offset + columnBytes);
+    }
+    return h;
+}
+
+// запись столбцов; get(col, i) — значение i-го элемента столбца col.
+// Значения переводятся прямо в буфер записи, блоками по kMappedPartSize.
+template<class Get>
+bool writeColumns(const QString &fileName, const BinaryHeader &h,
+                  const std::atomic_bool *cancel, Get get)
+{
+    BufferedWriter out;
+    out.setCancelFlag(cancel);
+    if (!out.open(fileName))
+        return false;
+
+    out.write(reinterpret_cast<const char *>(&h), qsizetype(sizeof h));
+
+    const bool single = h.precision == quint32(ColumnPrecision::Float32);
+    const qsizetype n = qsizetype(h.count);
+
+    for (quint32 col = 0; col < h.columnCount && out.ok(); ++col) {
+        // выравнивание до начала столбца
+        const qint64 pad = qint64(h.columnOffset[col]) - out.pos();
+        if (pad > 0) {
+            char *p = out.reserve(pad);
+            std::memset(p, 0, size_t(pad));
+            out.commit(p + pad);
+        }
+
+        for (qsizetype begin = 0; begin < n && out.ok(); begin += kMappedPartSize) {
+            const qsizetype len = std::min(kMappedPartSize, n - begin);
+            char *p = out.reserve(len * qsizetype(h.precision));
+            for (qsizetype i = 0; i < len; ++i) {
+                const double v = get(int(col), begin + i);
+                if (single) {
+                    const float fv = float(v);
+                    std::memcpy(p, &fv, 4);
+                    p += 4;
+                } else {
+                    std::memcpy(p, &v, 8);
+                    p += 8;
+                }
+            }
+            out.commit(p);
+        }
+    }
+    return out.finish();
+}
+
+// столбцы отрезка: x1, y1, x2, y2
+inline double lineColumn(const QLineF &s, int col)
+{
+    switch (col) {
+    case 0:  return s.x1();
+    case 1:  return s.y1();
+    case 2:  return s.x2();
+    default: return s.y2();
+    }
+}
+
+} // namespace
+
+bool isBinarySceneFile(const QString &fileName)
+{
+    QFile f(fileName);
+    char magic[sizeof kBinaryMagic];
+    return f.open(QIODevice::ReadOnly) &&
+           f.read(magic, sizeof magic) == qint64(sizeof magic) &&
+           std::memcmp(magic, kBinaryMagic, sizeof magic) == 0;
+}
+
+bool readBinaryHeader(QFile &file, BinaryHeader &header, QString *error)
+{
+    const qint64 size = file.size();
+    if (!file.seek(0) ||
+        file.read(reinterpret_cast<char *>(&header), sizeof header) != qint64(sizeof header))
+        return fail(error, "файл короче заголовка");
+
+    if (std::memcmp(header.magic, kBinaryMagic, sizeof header.magic) != 0)
+        return fail(error, "нет сигнатуры двоичного формата");
+    if (header.version != kBinaryVersion)
+        return fail(error, QString("неподдерживаемая версия %1").arg(header.version));
+    if (header.endianTag != kBinaryEndianTag)
+        return fail(error, "другой порядок байтов");
+
+    const bool segments = header.kind == quint32(SceneKind::Segments);
+    const bool polygon  = header.kind == quint32(SceneKind::Polygon);
+    if ((!segments && !polygon) ||
+        header.columnCount != (segments ? 4u : 2u) ||
+        (header.precision != quint32(ColumnPrecision::Float32) &&
+         header.precision != quint32(ColumnPrecision::Float64)))
+        return fail(error, "повреждённый заголовок");
+
+    // столбцы целиком внутри файла и выровнены; count проверяется до
+    // умножения — иначе огромный count даёт переполнение и малый размер
+    if (header.count > quint64(size) / header.precision)
+        return fail(error, "столбцы выходят за пределы файла");
+    const quint64 columnBytes = header.count * header.precision;
+    for (quint32 i = 0; i < header.columnCount; ++i) {
+        if (header.columnOffset[i] % kBinaryAlignment != 0 ||
+            header.columnOffset[i] > quint64(size) ||
+            columnBytes > quint64(size) - header.columnOffset[i])
+            return fail(error, "столбцы выходят за пределы файла");
+    }
+    return true;
+}
+
+// ---------- MappedScene ----------
+
+bool MappedScene::open(const QString &fileName, QString *error)
+{
+    CLIP_STAT_TIMER(Parse);
+    close();
+
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail(error, "не удалось открыть файл");
+
+    if (!readBinaryHeader(file, header, error))
+        return false;
+
+    base = file.map(0, file.size());
+    if (!base)
+        return fail(error, "не удалось отобразить файл в память");
+    return true;
+}
+
+void MappedScene::close()
+{
+    if (base)
+        file.unmap(const_cast<uchar *>(base));
+    base = nullptr;
+    file.close();
+    header = BinaryHeader {};
+}
+
+QRectF MappedScene::window() const
+{
+    return QRectF(QPointF(header.window[0], header.window[1]),
+                  QPointF(header.window[2], header.window[3]));
+}
+
+double MappedScene::value(int col, qsizetype i) const
+{
+    return precision() == ColumnPrecision::Float64 ? value<double>(col, i)
+                                                   : value<float>(col, i);
+}
+
+SegmentColumns MappedScene::segmentColumns() const
+{
+    SegmentColumns c;
+    if (kind() != SceneKind::Segments || precision() != ColumnPrecision::Float64)
+        return c;
+
+    c.x1 = static_cast<const double *>(column(0));
+    c.y1 = static_cast<const double *>(column(1));
+    c.x2 = static_cast<const double *>(column(2));
+    c.y2 = static_cast<const double *>(column(3));
+    c.count = count();
+    return c;
+}
+
+QVector<QLineF> MappedScene::segments() const
+{
+    QVector<QLineF> lines;
+    if (kind() != SceneKind::Segments)
+        return lines;
+
+    lines.resize(count());
+    for (qsizetype i = 0; i < count(); ++i)
+        lines[i] = segment(i);
+    return lines;
+}
+
+QVector<QPointF> MappedScene::polygon() const
+{
+    QVector<QPointF> points;
+    if (kind() != SceneKind::Polygon)
+        return points;
+
+    points.resize(count());
+    for (qsizetype i = 0; i < count(); ++i)
+        points[i] = QPointF(value(0, i), value(1, i));
+    return points;
+}
+
+// ---------- отсечение по отображённым столбцам ----------
+
+void clipMappedSegments(const MappedScene &scene,
+                        SegmentArrays &out,
+                        QVector<quint8> &mask,
+                        WorkStealingPool &pool)
+{
+    CLIP_STAT_TIMER(Clip);
+    const qsizetype n = scene.kind() == SceneKind::Segments ? scene.count() : 0;
+    out.resize(n);
+    mask.resize(n);
+
+    const QRectF window = scene.window();
+    const BatchKernel kernel = detectBatchKernel();
+    const SegmentOutputColumns o { out.x1.data(), out.y1.data(), out.x2.data(),
+                                   out.y2.data(), mask.data() };
+    const qsizetype parts = (n + kMappedPartSize - 1) / kMappedPartSize;
+
+    if (scene.precision() == ColumnPrecision::Float64) {
+        const SegmentColumns in = scene.segmentColumns();
+        pool.run(parts, [&](qsizetype part, int) {
+            const qsizetype begin = part * kMappedPartSize;
+            const SegmentColumns piece { in.x1 + begin, in.y1 + begin,
+                                         in.x2 + begin, in.y2 + begin,
+                                         std::min(kMappedPartSize, n - begin) };
+            clipLiangBarskyBatch(piece, window,
+                                 SegmentOutputColumns { o.x1 + begin, o.y1 + begin,
+                                                        o.x2 + begin, o.y2 + begin,
+                                                        o.mask + begin },
+                                 kernel);
+        });
+        return;
+    }
+
+    const float *cols[4];
+    for (int c = 0; c < 4; ++c)
+        cols[c] = static_cast<const float *>(scene.column(c));
+
+    pool.run(parts, [&](qsizetype part, int) {
+        double block[4][kFloatBlockSize];
+        const qsizetype partEnd = std::min((part + 1) * kMappedPartSize, n);
+        for (qsizetype begin = part * kMappedPartSize; begin < partEnd;
+             begin += kFloatBlockSize) {
+            const qsizetype len = std::min(kFloatBlockSize, partEnd - begin);
+            for (int c = 0; c < 4; ++c)
+                std::copy(cols[c] + begin, cols[c] + begin + len, block[c]);
+
+            clipLiangBarskyBatch(SegmentColumns { block[0], block[1], block[2], block[3], len },
+                                 window,
+                                 SegmentOutputColumns { o.x1 + begin, o.y1 + begin,
+                                                        o.x2 + begin, o.y2 + begin,
+                                                        o.mask + begin },
+                                 kernel);
+        }
+    });
+}
+
+// ---------- запись ----------
+
+bool writeBinarySegments(const QString &fileName,
+                         const SegmentColumns &segments,
+                         const QRectF &window,
+                         ColumnPrecision precision,
+                         const std::atomic_bool *cancel)
+{
+    const BinaryHeader h = makeHeader(SceneKind::Segments, precision,
+                                      segments.count, 4, window);
+    const double *cols[4] = { segments.x1, segments.y1, segments.x2, segments.y2 };
+    return writeColumns(fileName, h, cancel, [&](int col, qsizetype i) {
+        return cols[col][i];
+    });
+}
+
+bool writeBinarySegments(const QString &fileName,
+                         const QLineF *segments,
+                         qsizetype count,
+                         const QRectF &window,
+                         ColumnPrecision precision,
+                         const std::atomic_bool *cancel)
+{
+    const BinaryHeader h = makeHeader(SceneKind::Segments, precision,
+                                      count, 4, window);
+    return writeColumns(fileName, h, cancel, [&](int col, qsizetype i) {
+        return lineColumn(segments[i], col);
+    });
+}
+
+bool writeBinarySegments(const QString &fileName,
+                         const QLineF *segments,
+                         const quint32 *ids,
+                         qsizetype count,
+                         const QRectF &window,
+                         ColumnPrecision precision,
+                         const std::atomic_bool *cancel)
+{
+    const BinaryHeader h = makeHeader(SceneKind::Segments, precision,
+                                      count, 4, window);
+    return writeColumns(fileName, h, cancel, [&](int col, qsizetype i) {
+        return lineColumn(segments[ids[i]], col);
+    });
+}
+
+bool writeBinaryPolygon(const QString &fileName,
+                        const QVector<QPointF> &polygon,
+                        const QRectF &window,
+                        ColumnPrecision precision,
+                        const std::atomic_bool *cancel)
+{
+    return writeBinaryPolygon(fileName, polygon.constData(), polygon.size(),
+                              window, precision, cancel);
+}
+
+bool writeBinaryPolygon(const QString &fileName,
+                        const QPointF *vertices,
+                        qsizetype count,
+                        const QRectF &window,
+                        ColumnPrecision precision,
+                        const std::atomic_bool *cancel)
+{
+    const BinaryHeader h = makeHeader(SceneKind::Polygon, precision,
+                                      count, 2, window);
+    return writeColumns(fileName, h, cancel, [&](int col, qsizetype i) {
+        return col == 0 ? vertices[i].x() : vertices[i].y();
+    });
+}
+
+bool convertTextToBinary(const QString &textFile,
+                         const QString &binaryFile,
+                         ColumnPrecision precision,
+                         QString *error)
+{
+    NumberText text;
+    ParseError parseError;
+    if (!parseNumbersFile(textFile, text, parseError))
+        return fail(error, parseError.toString(textFile));
+
+    bool ok = false;
+    switch (detectSceneKind(text)) {
+    case SceneKind::Segments: {
+        SegmentScene scene;
+        if (!segmentSceneFromNumbers(text, scene, parseError))
+            return fail(error, parseError.toString(textFile));
+        if (!scene.windowPolygon.isEmpty())
+            return fail(error, textFile + ": окно-многоугольник в двоичном формате не хранится");
+        const SegmentArrays columns = SegmentArrays::fromLines(scene.segments);
+        ok = writeBinarySegments(binaryFile, columns.columns(), scene.window, precision);
+        break;
+    }
+    case SceneKind::Polygon: {
+        PolygonScene scene;
+        if (!polygonSceneFromNumbers(text, scene, parseError))
+            return fail(error, parseError.toString(textFile));
+        if (!scene.windowPolygon.isEmpty())
+            return fail(error, textFile + ": окно-многоугольник в двоичном формате не хранится");
+        ok = writeBinaryPolygon(binaryFile, scene.polygon, scene.window, precision);
+        break;
+    }
+    case SceneKind::MultiPolygon:
+        return fail(error, textFile + ": несколько многоугольников в двоичный "
+                                      "формат не переводятся");
+    case SceneKind::Polyline:
+        return fail(error, textFile + ": ломаные в двоичный формат не переводятся");
+    case SceneKind::Unknown:
+        return fail(error, textFile + ": количество чисел не подходит ни под "
+                                      "отрезки, ни под многоугольник");
+    }
+
+    if (!ok)
+        return fail(error, binaryFile + ": не удалось записать файл");
+    return true;
+}
+
+} // namespace clip
@@ -0,0 +1,134 @@
+#pragma once
+#include "batchclipper.h"
+#include "clipio.h"
+#include "threadpool.h"
+#include <QFile>
+#include <atomic>
+
+namespace clip {
+
+// Двоичный столбцовый формат (*.scb), версия 1.
+//
+//   заголовок 128 байт (BinaryHeader), затем столбцы, каждый с границы
+//   64 байт: у отрезков x1, y1, x2, y2, у многоугольника x, y;
+//   значения float64 или float32, порядок байтов — как у записавшей машины
+//   (проверяется по endianTag).
+//
+// Файл отображается в память и отсекается прямо по столбцам, без
+// копирования в QVector<QLineF>.
+
+constexpr char    kBinaryMagic[8]   = { 'S', 'C', 'L', 'I', 'P', 'C', 'O', 'L' };
+constexpr quint32 kBinaryVersion    = 1;
+constexpr quint32 kBinaryEndianTag  = 0x01020304;
+constexpr qint64  kBinaryAlignment  = 64;
+
+enum class ColumnPrecision : quint32 { Float32 = 4, Float64 = 8 };
+
+struct BinaryHeader
+{
+    char    magic[8];
+    quint32 version;
+    quint32 endianTag;
+    quint32 kind;           // SceneKind
+    quint32 precision;      // ColumnPrecision
+    quint64 count;          // отрезков или вершин
+    double  window[4];      // xmin ymin xmax ymax
+    quint64 columnOffset[4];
+    quint32 columnCount;
+    quint8  reserved[28];
+};
+static_assert(sizeof(BinaryHeader) == 128, "BinaryHeader must stay 128 bytes");
+
+// есть ли в начале файла сигнатура двоичного формата
+bool isBinarySceneFile(const QString &fileName);
+
+// чтение и проверка заголовка открытого файла (в том числе что столбцы
+// целиком помещаются в файл)
+bool readBinaryHeader(QFile &file, BinaryHeader &header, QString *error = nullptr);
+
+// Отображённый в память двоичный файл
+class MappedScene
+{
+public:
+    bool open(const QString &fileName, QString *error = nullptr);
+    void close();
+
+    SceneKind       kind() const      { return SceneKind(header.kind); }
+    ColumnPrecision precision() const { return ColumnPrecision(header.precision); }
+    qsizetype       count() const     { return qsizetype(header.count); }
+    QRectF          window() const;
+
+    // начало столбца i (тип элементов — по precision())
+    const void *column(int i) const { return base + header.columnOffset[i]; }
+
+    // столбцы отрезков; только для Float64
+    SegmentColumns segmentColumns() const;
+
+    // i-й отрезок (для Float32 — с преобразованием к double)
+    QLineF segment(qsizetype i) const
+    { return QLineF(value(0, i), value(1, i), value(2, i), value(3, i)); }
+
+    // копии для GUI и алгоритмов, работающих с QPointF/QLineF
+    QVector<QLineF>  segments() const;
+    QVector<QPointF> polygon() const;
+
+private:
+    template<class T> double value(int col, qsizetype i) const
+    { return double(static_cast<const T *>(column(col))[i]); }
+    double value(int col, qsizetype i) const;
+
+    QFile         file;
+    const uchar  *base = nullptr;
+    BinaryHeader  header {};
+};
+
+// Лианг–Барски по отображённым столбцам. Float64 идёт прямо в SIMD-ядро,
+// Float32 — блоками через небольшой буфер на стеке. Части обрабатываются
+// пулом параллельно; out и mask — по одному элементу на отрезок.
+void clipMappedSegments(const MappedScene &scene,
+                        SegmentArrays &out,
+                        QVector<quint8> &mask,
+                        WorkStealingPool &pool = WorkStealingPool::global());
+
+// Запись *.scb. cancel (если задан) прерывает запись: файл удаляется,
+// результат — false.
+bool writeBinarySegments(const QString &fileName,
+                         const SegmentColumns &segments,
+                         const QRectF &window,
+                         ColumnPrecision precision = ColumnPrecision::Float64,
+                         const std::atomic_bool *cancel = nullptr);
+bool writeBinaryPolygon(const QString &fileName,
+                        const QVector<QPointF> &polygon,
+                        const QRectF &window,
+                        ColumnPrecision precision = ColumnPrecision::Float64,
+                        const std::atomic_bool *cancel = nullptr);
+
+// то же прямо из буферов результата отсечения
+bool writeBinarySegments(const QString &fileName,
+                         const QLineF *segments,
+                         qsizetype count,
+                         const QRectF &window,
+                         ColumnPrecision precision = ColumnPrecision::Float64,
+                         const std::atomic_bool *cancel = nullptr);
+// выборка без копирования: i-й отрезок — segments[ids[i]]
+bool writeBinarySegments(const QString &fileName,
+                         const QLineF *segments,
+                         const quint32 *ids,
+                         qsizetype count,
+                         const QRectF &window,
+                         ColumnPrecision precision = ColumnPrecision::Float64,
+                         const std::atomic_bool *cancel = nullptr);
+bool writeBinaryPolygon(const QString &fileName,
+                        const QPointF *vertices,
+                        qsizetype count,
+                        const QRectF &window,
+                        ColumnPrecision precision = ColumnPrecision::Float64,
+                        const std::atomic_bool *cancel = nullptr);
+
+// преобразование текстового файла в двоичный
+bool convertTextToBinary(const QString &textFile,
+                         const QString &binaryFile,
+                         ColumnPrecision precision,
+                         QString *error = nullptr);
+
+} // namespace clip
@@ -0,0 +1,64 @@
+#include "bufferedwriter.h"
+#include <cstring>
+
+namespace clip {
+
+BufferedWriter::BufferedWriter(qsizetype capacity)
+{
+    buffer.resize(capacity);
+}
+
+bool BufferedWriter::open(const QString &fileName)
+{
+    file.setFileName(fileName);
+    used = 0;
+    written = 0;
+    good = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    return good;
+}
+
+void BufferedWriter::write(const char *data, qsizetype n)
+{
+    // крупный кусок идёт в файл мимо буфера
+    if (n > buffer.size() / 2) {
+        flush();
+        if (good && file.write(data, n) != n)
+            good = false;
+        written += n;
+        return;
+    }
+    std::memcpy(reserve(n), data, size_t(n));
+    used += n;
+}
+
+bool BufferedWriter::flush()
+{
+    if (cancelled())
+        good = false;
+    if (used > 0 && good && file.write(buffer.constData(), used) != used)
+        good = false;
+    written += used;
+    used = 0;
+    return good;
+}
+
+bool BufferedWriter::rewrite(qint64 at, const char *data, qsizetype n)
+{
+    if (!flush())
+        return false;
+    good = file.seek(at) && file.write(data, n) == n && file.seek(written);
+    return good;
+}
+
+bool BufferedWriter::finish()
+{
+    flush();
+    if (good)
+        good = file.flush();
+    file.close();
+    if (cancelled() && file.exists())
+        file.remove();
+    return good;
+}
+
+} // namespace clip
@@ -0,0 +1,82 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+
+namespace clip {
+
+// наибольшая длина числа, которое пишет writeNumber()
+constexpr int kNumberChars = 32;
+
+// формат как у saveSegmentScene/savePolygonScene: 12 значащих цифр
+inline char *writeNumber(char *p, double v)
+{
+    return std::to_chars(p, p + kNumberChars, v, std::chars_format::general, 12).ptr;
+}
+
+// Запись в файл через большой буфер. Мелкие записи (число, строка)
+// копятся в памяти и уходят в файл блоками по capacity байт, так что
+// вызовов write() у QFile — единицы на мегабайты вывода. Первая ошибка
+// запоминается, дальнейшие записи пропускаются; итог — finish().
+// Запись можно прервать извне флагом setCancelFlag(): как только он
+// поднят, в файл больше ничего не уходит, а finish() удаляет файл.
+class BufferedWriter
+{
+public:
+    static constexpr qsizetype kDefaultCapacity = 8 << 20;
+
+    explicit BufferedWriter(qsizetype capacity = kDefaultCapacity);
+
+    bool open(const QString &fileName);
+
+    void setCancelFlag(const std::atomic_bool *flag) { cancel = flag; }
+    bool cancelled() const { return cancel && *cancel; }
+
+    // Место под n байт (n <= capacity) в конце буфера: вызывающий пишет
+    // туда сам и отдаёт конец записанного в commit().
+    char *reserve(qsizetype n)
+    {
+        if (buffer.size() - used < n)
+            flush();
+        return buffer.data() + used;
+    }
+    void commit(char *end) { used = end - buffer.constData(); }
+
+    void write(const char *data, qsizetype n);
+    void write(const char *text) { write(text, qsizetype(std::strlen(text))); }
+    void write(const QByteArray &data) { write(data.constData(), data.size()); }
+    void put(char c) { *reserve(1) = c; ++used; }
+    void putNumber(double v) { commit(writeNumber(reserve(kNumberChars), v)); }
+    void putInteger(qint64 v)
+    {
+        char *p = reserve(kNumberChars);
+        commit(std::to_chars(p, p + kNumberChars, v).ptr);
+    }
+
+    // позиция в файле с учётом ещё не записанного
+    qint64 pos() const { return written + used; }
+
+    // Переписать уже выведенные байты с позиции at (например, количество,
+    // под которое оставлено место); буфер перед этим сбрасывается.
+    bool rewrite(qint64 at, const char *data, qsizetype n);
+
+    bool flush();
+
+    // остаток буфера в файл; false — была ошибка записи или открытия,
+    // или запись прервана (тогда файл удалён)
+    bool finish();
+    bool ok() const { return good && !cancelled(); }
+
+private:
+    QFile      file;
+    QByteArray buffer;
+    qsizetype  used = 0;
+    qint64     written = 0;
+    bool       good = false;
+    const std::atomic_bool *cancel = nullptr;
+};
+
+} // namespace clip
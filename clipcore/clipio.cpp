@@ -0,0 +1,456 @@
+#include "clipio.h"
+#include "binaryformat.h"
+#include "clipstats.h"
+#include <QFile>
+#include <QTextStream>
+
+namespace clip {
+
+namespace {
+
+// первое число — количество элементов: целое, не меньше minimum;
+// метка формата должна быть tag
+bool readCount(const NumberText &text, qsizetype minimum, qsizetype &n,
+               ParseError &error, char tag = 0)
+{
+    if (text.tag != tag) {
+        error = ParseError { 1, 1, tag ? QString("ожидалась метка \"%1\"").arg(QChar(tag))
+                                       : QString("неожиданная метка \"%1\"").arg(QChar(text.tag)) };
+        return false;
+    }
+
+    if (text.numbers.isEmpty()) {
+        error = text.errorAtEnd("файл пуст");
+        return false;
+    }
+
+    const double v = text.numbers[0];
+    if (!isCount(v, minimum)) {
+        error = ParseError { 0, 0,
+            QString("первое число (%1) должно быть целым и не меньше %2")
+                .arg(v).arg(minimum) };
+        return false;
+    }
+
+    n = qsizetype(v);
+    return true;
+}
+
+// достаточно ли чисел: n элементов по perItem чисел и окно
+bool checkSize(const NumberText &text, qsizetype n, qsizetype perItem,
+               ParseError &error)
+{
+    const qsizetype need = 1 + n * perItem + 4;
+    if (text.numbers.size() < need) {
+        error = text.errorAtEnd(
+            QString("ожидалось %1 чисел, в файле %2").arg(need).arg(text.numbers.size()));
+        return false;
+    }
+    return true;
+}
+
+QRectF windowAt(const double *v)
+{
+    return QRectF(QPointF(v[0], v[1]), QPointF(v[2], v[3]));
+}
+
+// rest чисел с v — окно-многоугольник "k x1 y1 ... xk yk"
+bool isPolygonWindow(const double *v, qsizetype rest)
+{
+    const double k = v[0];
+    return rest > 4 && isCount(k, 3, rest) && rest == 1 + 2 * qsizetype(k);
+}
+
+// окно с позиции at (чисел там не меньше четырёх, см. checkSize)
+bool readWindow(const NumberText &text, qsizetype at, QRectF &window,
+                QVector<QPointF> &windowPolygon, ParseError &error)
+{
+    const double *v = text.numbers.constData() + at;
+    windowPolygon.clear();
+    if (!isPolygonWindow(v, text.numbers.size() - at)) {
+        window = windowAt(v);
+        return true;
+    }
+
+    const qsizetype k = qsizetype(v[0]);
+    windowPolygon.resize(k);
+    for (qsizetype i = 0; i < k; ++i)
+        windowPolygon[i] = QPointF(v[1 + 2 * i], v[2 + 2 * i]);
+
+    ConvexWindow convex;
+    QString message;
+    if (!convex.setPolygon(windowPolygon, &message)) {
+        error = ParseError { 0, 0, message };
+        return false;
+    }
+
+    // прямоугольник, заданный вершинами, хранится как обычное окно
+    window = convex.boundingRect();
+    if (convex.isRect())
+        windowPolygon.clear();
+    return true;
+}
+
+// двоичный файл (*.scb): ошибка без строки и столбца
+bool openBinary(const QString &fileName, MappedScene &mapped, SceneKind kind,
+                ParseError &error)
+{
+    QString message;
+    if (!mapped.open(fileName, &message)) {
+        error = ParseError { 0, 0, message };
+        return false;
+    }
+    if (mapped.kind() != kind) {
+        error = ParseError { 0, 0, kind == SceneKind::Segments
+                                       ? "в файле не отрезки"
+                                       : "в файле не многоугольник" };
+        return false;
+    }
+    return true;
+}
+
+// Метка tag, число наборов k, затем для каждого n (>= 0) и n пар "x y" —
+// в set; в at — позиция за ними (там окно, чисел не меньше четырёх).
+// item и items — «многоугольник» и «многоугольников» для сообщений.
+bool readPointSets(const NumberText &text, char tag, const char *item, const char *items,
+                   PolygonSet &set, qsizetype &at, ParseError &error)
+{
+    qsizetype k;
+    if (!readCount(text, 0, k, error, tag))
+        return false;
+
+    // первый проход — проверка длин и подсчёт вершин, второй — копирование
+    const double *v = text.numbers.constData();
+    const qsizetype total = text.numbers.size();
+    at = 1;
+    qsizetype vertices = 0;
+    for (qsizetype i = 0; i < k; ++i) {
+        const double n = at < total ? v[at] : -1;
+        if (!isCount(n, 0)) {
+            error = at < total
+                ? ParseError { 0, 0, QString("%1 %2: число вершин (%3) должно быть "
+                                             "целым и неотрицательным").arg(item).arg(i + 1).arg(n) }
+                : text.errorAtEnd(QString("ожидалось %1 %2, в файле %3")
+                                      .arg(k).arg(items).arg(i));
+            return false;
+        }
+        // вершины — в оставшихся числах; проверка до сдвига at, иначе
+        // огромное n переполнит at
+        if (n > double((total - at - 1) / 2)) {
+            error = text.errorAtEnd(QString("ожидалось %1 чисел, в файле %2")
+                                        .arg(at + 1 + 2 * qsizetype(n)).arg(total));
+            return false;
+        }
+        at += 1 + 2 * qsizetype(n);
+        vertices += qsizetype(n);
+    }
+    if (at + 4 > total) {
+        error = text.errorAtEnd(
+            QString("ожидалось %1 чисел, в файле %2").arg(at + 4).arg(total));
+        return false;
+    }
+
+    set.vertices.resize(vertices);
+    set.offsets.resize(k + 1);
+    set.offsets[0] = 0;
+    QPointF *out = set.vertices.data();
+    at = 1;
+    for (qsizetype i = 0; i < k; ++i) {
+        const qsizetype n = qsizetype(v[at++]);
+        for (qsizetype j = 0; j < n; ++j, at += 2)
+            *out++ = QPointF(v[at], v[at + 1]);
+        set.offsets[i + 1] = set.offsets[i] + n;
+    }
+
+    return true;
+}
+
+void writeWindow(QTextStream &out, const QRectF &window,
+                 const QVector<QPointF> &windowPolygon)
+{
+    if (windowPolygon.isEmpty()) {
+        out << window.left() << ' ' << window.top() << ' '
+            << window.right() << ' ' << window.bottom() << '\n';
+        return;
+    }
+
+    out << windowPolygon.size() << '\n';
+    for (const QPointF &p : windowPolygon)
+        out << p.x() << ' ' << p.y() << '\n';
+}
+
+// метка, число наборов, затем каждый набор: n и n строк "x y"
+void writePointSets(QTextStream &out, char tag, const PolygonSet &set)
+{
+    out << tag << ' ' << set.count() << '\n';
+    for (qsizetype i = 0; i < set.count(); ++i) {
+        const QPointF *p = set.polygon(i);
+        const qsizetype n = set.size(i);
+        out << n << '\n';
+        for (qsizetype j = 0; j < n; ++j)
+            out << p[j].x() << ' ' << p[j].y() << '\n';
+    }
+}
+
+} // namespace
+
+ConvexWindow sceneWindow(const QRectF &window, const QVector<QPointF> &windowPolygon)
+{
+    ConvexWindow convex(window);
+    if (!windowPolygon.isEmpty())
+        convex.setPolygon(windowPolygon);
+    return convex;
+}
+
+bool segmentSceneFromNumbers(const NumberText &text, SegmentScene &scene,
+                             ParseError &error)
+{
+    CLIP_STAT_TIMER(Parse);
+    qsizetype n;
+    if (!readCount(text, 0, n, error) || !checkSize(text, n, 4, error))
+        return false;
+
+    const double *v = text.numbers.constData() + 1;
+    scene.segments.resize(n);
+    QLineF *out = scene.segments.data();
+    for (qsizetype i = 0; i < n; ++i, v += 4)
+        out[i] = QLineF(v[0], v[1], v[2], v[3]);
+
+    return readWindow(text, 1 + 4 * n, scene.window, scene.windowPolygon, error);
+}
+
+bool polygonSceneFromNumbers(const NumberText &text, PolygonScene &scene,
+                             ParseError &error)
+{
+    CLIP_STAT_TIMER(Parse);
+    qsizetype n;
+    if (!readCount(text, 3, n, error) || !checkSize(text, n, 2, error))
+        return false;
+
+    const double *v = text.numbers.constData() + 1;
+    scene.polygon.resize(n);
+    QPointF *out = scene.polygon.data();
+    for (qsizetype i = 0; i < n; ++i, v += 2)
+        out[i] = QPointF(v[0], v[1]);
+
+    return readWindow(text, 1 + 2 * n, scene.window, scene.windowPolygon, error);
+}
+
+bool multiPolygonSceneFromNumbers(const NumberText &text, MultiPolygonScene &scene,
+                                  ParseError &error)
+{
+    CLIP_STAT_TIMER(Parse);
+    qsizetype at;
+    return readPointSets(text, 'P', "многоугольник", "многоугольников",
+                         scene.polygons, at, error) &&
+           readWindow(text, at, scene.window, scene.windowPolygon, error);
+}
+
+bool polylineSceneFromNumbers(const NumberText &text, PolylineScene &scene,
+                              ParseError &error)
+{
+    CLIP_STAT_TIMER(Parse);
+    qsizetype at;
+    return readPointSets(text, 'L', "ломаная", "ломаных", scene.chains, at, error) &&
+           readWindow(text, at, scene.window, scene.windowPolygon, error);
+}
+
+bool loadSegmentScene(const QString &fileName, SegmentScene &scene,
+                      ParseError *error)
+{
+    CLIP_STAT_TIMER(Parse);
+    NumberText text;
+    ParseError e;
+    bool ok;
+    if (isBinarySceneFile(fileName)) {
+        MappedScene mapped;
+        ok = openBinary(fileName, mapped, SceneKind::Segments, e);
+        if (ok) {
+            scene.segments = mapped.segments();
+            scene.window = mapped.window();
+            scene.windowPolygon.clear();
+        }
+    } else {
+        ok = parseNumbersFile(fileName, text, e) &&
+             segmentSceneFromNumbers(text, scene, e);
+    }
+    if (!ok && error)
+        *error = e;
+    return ok;
+}
+
+bool loadPolygonScene(const QString &fileName, PolygonScene &scene,
+                      ParseError *error)
+{
+    CLIP_STAT_TIMER(Parse);
+    NumberText text;
+    ParseError e;
+    bool ok;
+    if (isBinarySceneFile(fileName)) {
+        MappedScene mapped;
+        ok = openBinary(fileName, mapped, SceneKind::Polygon, e);
+        if (ok) {
+            scene.polygon = mapped.polygon();
+            scene.window = mapped.window();
+            scene.windowPolygon.clear();
+        }
+    } else {
+        ok = parseNumbersFile(fileName, text, e) &&
+             polygonSceneFromNumbers(text, scene, e);
+    }
+    if (!ok && error)
+        *error = e;
+    return ok;
+}
+
+bool loadMultiPolygonScene(const QString &fileName, MultiPolygonScene &scene,
+                           ParseError *error)
+{
+    CLIP_STAT_TIMER(Parse);
+    NumberText text;
+    ParseError e;
+    const bool ok = parseNumbersFile(fileName, text, e) &&
+                    multiPolygonSceneFromNumbers(text, scene, e);
+    if (!ok && error)
+        *error = e;
+    return ok;
+}
+
+bool loadPolylineScene(const QString &fileName, PolylineScene &scene,
+                       ParseError *error)
+{
+    CLIP_STAT_TIMER(Parse);
+    NumberText text;
+    ParseError e;
+    const bool ok = parseNumbersFile(fileName, text, e) &&
+                    polylineSceneFromNumbers(text, scene, e);
+    if (!ok && error)
+        *error = e;
+    return ok;
+}
+
+SceneKind detectSceneKind(const NumberText &text)
+{
+    if (text.tag == 'P')
+        return SceneKind::MultiPolygon;
+    if (text.tag == 'L')
+        return SceneKind::Polyline;
+    if (text.tag != 0 || text.numbers.isEmpty())
+        return SceneKind::Unknown;
+
+    // после n: 4n чисел у отрезков, 2n у многоугольника, затем окно —
+    // 4 числа или 1 + 2k у окна-многоугольника
+    const double v = text.numbers[0];
+    if (!isCount(v, 0))
+        return SceneKind::Unknown;
+
+    const qsizetype n = qsizetype(v);
+    const qsizetype count = text.numbers.size() - 1;
+    auto windowFits = [&](qsizetype at) {
+        const qsizetype rest = count + 1 - at;
+        return rest == 4 ||
+               (rest > 4 && isPolygonWindow(text.numbers.constData() + at, rest));
+    };
+    if (4 * n + 4 <= count && windowFits(1 + 4 * n))
+        return SceneKind::Segments;
+    if (n >= 3 && 2 * n + 4 <= count && windowFits(1 + 2 * n))
+        return SceneKind::Polygon;
+    return SceneKind::Unknown;
+}
+
+SceneKind detectSceneKind(const QString &fileName)
+{
+    if (isBinarySceneFile(fileName)) {
+        MappedScene mapped;
+        return mapped.open(fileName) ? mapped.kind() : SceneKind::Unknown;
+    }
+
+    NumberText text;
+    ParseError error;
+    if (!parseNumbersFile(fileName, text, error))
+        return SceneKind::Unknown;
+    return detectSceneKind(text);
+}
+
+bool saveSegmentScene(const QString &fileName,
+                      const QVector<QLineF> &segments,
+                      const QRectF &window,
+                      const QVector<QPointF> &windowPolygon)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out.setRealNumberPrecision(12);
+
+    out << segments.size() << '\n';
+    for (const QLineF &s : segments)
+        out << s.x1() << ' ' << s.y1() << "   "
+            << s.x2() << ' ' << s.y2() << '\n';
+    writeWindow(out, window, windowPolygon);
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool savePolygonScene(const QString &fileName,
+                      const QVector<QPointF> &polygon,
+                      const QRectF &window,
+                      const QVector<QPointF> &windowPolygon)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out.setRealNumberPrecision(12);
+
+    out << polygon.size() << '\n';
+    for (const QPointF &p : polygon)
+        out << p.x() << ' ' << p.y() << '\n';
+    writeWindow(out, window, windowPolygon);
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool saveMultiPolygonScene(const QString &fileName,
+                           const PolygonSet &polygons,
+                           const QRectF &window,
+                           const QVector<QPointF> &windowPolygon)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out.setRealNumberPrecision(12);
+
+    writePointSets(out, 'P', polygons);
+    writeWindow(out, window, windowPolygon);
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+bool savePolylineScene(const QString &fileName,
+                       const PolylineSet &chains,
+                       const QRectF &window,
+                       const QVector<QPointF> &windowPolygon)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out.setRealNumberPrecision(12);
+
+    writePointSets(out, 'L', chains);
+    writeWindow(out, window, windowPolygon);
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+} // namespace clip
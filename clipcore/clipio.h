@@ -0,0 +1,106 @@
+#pragma once
+#include "convexwindow.h"
+#include "polygonbatch.h"
+#include "polylineclipper.h"
+#include "textparser.h"
+#include <QString>
+#include <QVector>
+#include <QLineF>
+#include <QRectF>
+
+namespace clip {
+
+// Формат файлов (текст, числа через пробельные символы):
+//   отрезки:       n, затем n строк "x1 y1 x2 y2", затем окно "xmin ymin xmax ymax"
+//   многоугольник: n (>= 3), затем n строк "x y",   затем окно "xmin ymin xmax ymax"
+//   несколько многоугольников: метка "P", их число k, затем для каждого
+//                  n (>= 0) и n строк "x y", затем окно
+//   ломаные:       метка "L", их число k, затем для каждой n (>= 0) и
+//                  n строк "x y" (вершины по порядку, без замыкания), затем окно
+// Окно — "xmin ymin xmax ymax" или выпуклый многоугольник: k (>= 3), затем
+// k строк "x y" (чисел нечётное количество, так что виды не путаются).
+// Двоичные файлы (*.scb, см. binaryformat.h) распознаются по сигнатуре.
+
+// У окна-многоугольника window — его ограничивающий прямоугольник, а
+// вершины — в windowPolygon. Пустой windowPolygon — окно-прямоугольник
+// window (в том числе заданное в файле четырьмя вершинами).
+
+struct SegmentScene
+{
+    QVector<QLineF>  segments;
+    QRectF           window;
+    QVector<QPointF> windowPolygon;
+};
+
+struct PolygonScene
+{
+    QVector<QPointF> polygon;
+    QRectF           window;
+    QVector<QPointF> windowPolygon;
+};
+
+struct MultiPolygonScene
+{
+    PolygonSet       polygons;
+    QRectF           window;
+    QVector<QPointF> windowPolygon;
+};
+
+struct PolylineScene
+{
+    PolylineSet      chains;
+    QRectF           window;
+    QVector<QPointF> windowPolygon;
+};
+
+// окно сцены для отсечения
+ConvexWindow sceneWindow(const QRectF &window, const QVector<QPointF> &windowPolygon);
+
+// значения Segments и Polygon хранятся в заголовке двоичных файлов
+enum class SceneKind { Unknown, Segments, Polygon, MultiPolygon, Polyline };
+
+// загрузка через отображение файла в память и параллельный разбор;
+// при ошибке в error (если задан) — строка, столбец и причина
+bool loadSegmentScene(const QString &fileName, SegmentScene &scene,
+                      ParseError *error = nullptr);
+bool loadPolygonScene(const QString &fileName, PolygonScene &scene,
+                      ParseError *error = nullptr);
+bool loadMultiPolygonScene(const QString &fileName, MultiPolygonScene &scene,
+                           ParseError *error = nullptr);
+bool loadPolylineScene(const QString &fileName, PolylineScene &scene,
+                       ParseError *error = nullptr);
+
+// разбор уже прочитанных чисел
+bool segmentSceneFromNumbers(const NumberText &text, SegmentScene &scene,
+                             ParseError &error);
+bool polygonSceneFromNumbers(const NumberText &text, PolygonScene &scene,
+                             ParseError &error);
+bool multiPolygonSceneFromNumbers(const NumberText &text, MultiPolygonScene &scene,
+                                  ParseError &error);
+bool polylineSceneFromNumbers(const NumberText &text, PolylineScene &scene,
+                              ParseError &error);
+
+// определяет тип файла по метке или количеству чисел в нём
+SceneKind detectSceneKind(const NumberText &text);
+SceneKind detectSceneKind(const QString &fileName);
+
+// запись в том же текстовом формате, что и на входе; непустой
+// windowPolygon пишется вместо window
+bool saveSegmentScene(const QString &fileName,
+                      const QVector<QLineF> &segments,
+                      const QRectF &window,
+                      const QVector<QPointF> &windowPolygon = {});
+bool savePolygonScene(const QString &fileName,
+                      const QVector<QPointF> &polygon,
+                      const QRectF &window,
+                      const QVector<QPointF> &windowPolygon = {});
+bool saveMultiPolygonScene(const QString &fileName,
+                           const PolygonSet &polygons,
+                           const QRectF &window,
+                           const QVector<QPointF> &windowPolygon = {});
+bool savePolylineScene(const QString &fileName,
+                       const PolylineSet &chains,
+                       const QRectF &window,
+                       const QVector<QPointF> &windowPolygon = {});
+
+} // namespace clip
@@ -0,0 +1,205 @@
+#include "clipstats.h"
+#include <QJsonObject>
+#include <QStringList>
+
+#ifdef CLIP_ENABLE_STATS
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace clip {
+
+namespace {
+
+const char *const kCounterNames[kStatCounters] = {
+    "midpoint_calls",
+    "midpoint_splits",
+    "midpoint_max_depth",
+    "boundary_steps",
+    "trivial_rejects",
+    "trivial_accepts",
+    "fragments_emitted",
+    "intersection_tests",
+    "intersection_points",
+    "sh_left_in",
+    "sh_right_in",
+    "sh_bottom_in",
+    "sh_top_in",
+    "sh_out",
+    "sh_convex_in",
+};
+
+const char *const kTimerNames[kStatTimers] = { "parse", "clip", "paint" };
+
+#ifdef CLIP_ENABLE_STATS
+
+// складывает b в a; у MidpointMaxDepth — максимум
+void merge(StatsSnapshot &a, const StatsSnapshot &b)
+{
+    for (int c = 0; c < kStatCounters; ++c) {
+        if (StatCounter(c) == StatCounter::MidpointMaxDepth)
+            a.counters[c] = std::max(a.counters[c], b.counters[c]);
+        else
+            a.counters[c] += b.counters[c];
+    }
+    for (int t = 0; t < kStatTimers; ++t) {
+        a.timerNs[t] += b.timerNs[t];
+        a.timerCalls[t] += b.timerCalls[t];
+    }
+}
+
+// Блоки живых потоков и сумма по завершившимся. Не удаляется: потоки
+// глобального пула заканчиваются при разрушении статических объектов,
+// и их блоки ещё должны найти, куда себя сложить.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<detail::ThreadStats *> threads;
+    StatsSnapshot retired;
+};
+
+Registry &registry()
+{
+    static Registry *r = new Registry;
+    return *r;
+}
+
+StatsSnapshot read(const detail::ThreadStats &s)
+{
+    StatsSnapshot out;
+    for (int c = 0; c < kStatCounters; ++c)
+        out.counters[c] = s.counters[c].load(std::memory_order_relaxed);
+    for (int t = 0; t < kStatTimers; ++t) {
+        out.timerNs[t] = s.timerNs[t].load(std::memory_order_relaxed);
+        out.timerCalls[t] = s.timerCalls[t].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+#endif
+
+} // namespace
+
+#ifdef CLIP_ENABLE_STATS
+
+namespace detail {
+
+ThreadStats::ThreadStats()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+}
+
+ThreadStats::~ThreadStats()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    merge(r.retired, read(*this));
+    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+}
+
+ThreadStats &threadStats()
+{
+    thread_local ThreadStats stats;
+    return stats;
+}
+
+} // namespace detail
+
+StatsSnapshot statsSnapshot()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    StatsSnapshot total = r.retired;
+    for (const detail::ThreadStats *s : r.threads)
+        merge(total, read(*s));
+    return total;
+}
+
+void resetStats()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired = StatsSnapshot();
+    for (detail::ThreadStats *s : r.threads) {
+        for (auto &v : s->counters)
+            v.store(0, std::memory_order_relaxed);
+        for (int t = 0; t < kStatTimers; ++t) {
+            s->timerNs[t].store(0, std::memory_order_relaxed);
+            s->timerCalls[t].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+StatsSnapshot statsSnapshot()
+{
+    return StatsSnapshot();
+}
+
+void resetStats()
+{
+}
+
+#endif
+
+const char *statName(StatCounter c)
+{
+    return kCounterNames[int(c)];
+}
+
+const char *statName(StatTimer t)
+{
+    return kTimerNames[int(t)];
+}
+
+QJsonObject statsToJson(const StatsSnapshot &s)
+{
+    QJsonObject counters;
+    for (int c = 0; c < kStatCounters; ++c)
+        counters.insert(kCounterNames[c], double(s.counters[c]));
+
+    QJsonObject timers;
+    for (int t = 0; t < kStatTimers; ++t) {
+        QJsonObject timer;
+        timer.insert("ms", s.milliseconds(StatTimer(t)));
+        timer.insert("calls", double(s.timerCalls[t]));
+        timers.insert(kTimerNames[t], timer);
+    }
+
+    QJsonObject root;
+    root.insert("enabled", kStatsEnabled);
+    root.insert("counters", counters);
+    root.insert("timers", timers);
+    return root;
+}
+
+QString statsSummary(const StatsSnapshot &s)
+{
+    return QString("Разбор %1 мс, отсечение %2 мс, отрисовка %3 мс; "
+                   "частей %4, делений %5 (глубина %6)")
+        .arg(s.milliseconds(StatTimer::Parse), 0, 'f', 1)
+        .arg(s.milliseconds(StatTimer::Clip), 0, 'f', 1)
+        .arg(s.milliseconds(StatTimer::Paint), 0, 'f', 1)
+        .arg(s.counter(StatCounter::FragmentsEmitted))
+        .arg(s.counter(StatCounter::MidpointSplits))
+        .arg(s.counter(StatCounter::MidpointMaxDepth));
+}
+
+QString statsDetails(const StatsSnapshot &s)
+{
+    QStringList lines;
+    for (int t = 0; t < kStatTimers; ++t)
+        lines << QString("%1: %2 мс, замеров %3")
+                     .arg(kTimerNames[t])
+                     .arg(s.milliseconds(StatTimer(t)), 0, 'f', 2)
+                     .arg(s.timerCalls[t]);
+    for (int c = 0; c < kStatCounters; ++c)
+        lines << QString("%1: %2").arg(kCounterNames[c]).arg(s.counters[c]);
+    return lines.join("\n");
+}
+
+} // namespace clip
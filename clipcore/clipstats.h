@@ -0,0 +1,188 @@
+#pragma once
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+
+#ifdef CLIP_ENABLE_STATS
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace clip {
+
+// Счётчики и таймеры горячих путей: сколько раз делились отрезки в
+// алгоритме средней точки, сколько отрезков отброшено или принято сразу,
+// сколько вершин прошло каждую стадию Сазерленда–Ходжмана и сколько
+// времени ушло на разбор, отсечение и отрисовку.
+//
+// Собираются, только если задан макрос CLIP_ENABLE_STATS (опция CMake с
+// тем же именем); без него макросы CLIP_STAT_* ничего не делают, а
+// statsSnapshot() возвращает нули. У каждого потока свой блок счётчиков,
+// и пишет в него только сам поток — без атомарных сложений и общих строк
+// кэша; statsSnapshot() складывает блоки всех потоков.
+
+enum class StatCounter
+{
+    MidpointCalls,       // отрезков в clipMidpoint
+    MidpointSplits,      // делений пополам при поиске точки внутри окна
+    MidpointMaxDepth,    // наибольшая глубина деления (максимум, не сумма)
+    BoundarySteps,       // шагов двоичного поиска границы
+    TrivialRejects,      // отброшено сразу: segOutside, общий бит кодов
+    TrivialAccepts,      // принято целиком: оба конца внутри
+    FragmentsEmitted,    // видимых частей отрезков
+    IntersectionTests,   // отрезков, проверенных на пересечение с гранями
+    IntersectionPoints,  // найдено точек пересечения
+    ShLeftIn,            // вершин на входе стадий Сазерленда–Ходжмана
+    ShRightIn,
+    ShBottomIn,
+    ShTopIn,
+    ShOut,               // вершин в результате
+    ShConvexIn,          // вершин на входе стадий выпуклого окна (по всем граням)
+    Count
+};
+
+enum class StatTimer { Parse, Clip, Paint, Count };
+
+constexpr int kStatCounters = int(StatCounter::Count);
+constexpr int kStatTimers = int(StatTimer::Count);
+
+#ifdef CLIP_ENABLE_STATS
+constexpr bool kStatsEnabled = true;
+#else
+constexpr bool kStatsEnabled = false;
+#endif
+
+struct StatsSnapshot
+{
+    quint64 counters[kStatCounters] = {};
+    quint64 timerNs[kStatTimers] = {};
+    quint64 timerCalls[kStatTimers] = {};
+
+    quint64 counter(StatCounter c) const { return counters[int(c)]; }
+    double milliseconds(StatTimer t) const { return double(timerNs[int(t)]) / 1e6; }
+};
+
+// Сумма по всем потокам (включая завершившиеся) с последнего resetStats().
+StatsSnapshot statsSnapshot();
+
+// Обнуляет счётчики всех потоков. Звать, когда отсечение не идёт:
+// прибавка, сделанная одновременно со сбросом, может его пережить.
+void resetStats();
+
+// имена в JSON: midpoint_calls, sh_left_in, parse, ...
+const char *statName(StatCounter c);
+const char *statName(StatTimer t);
+
+// {"enabled": ..., "counters": {...}, "timers": {"parse": {"ms", "calls"}, ...}}
+QJsonObject statsToJson(const StatsSnapshot &s);
+
+// коротко, в одну строку — для строки состояния
+QString statsSummary(const StatsSnapshot &s);
+
+// все значения, по строке на счётчик
+QString statsDetails(const StatsSnapshot &s);
+
+#ifdef CLIP_ENABLE_STATS
+
+namespace detail {
+
+struct ThreadStats
+{
+    std::atomic<quint64> counters[kStatCounters] {};
+    std::atomic<quint64> timerNs[kStatTimers] {};
+    std::atomic<quint64> timerCalls[kStatTimers] {};
+    int timerDepth[kStatTimers] {};   // вложенные замеры одного таймера не складываются
+
+    ThreadStats();
+    ~ThreadStats();
+};
+
+ThreadStats &threadStats();
+
+// пишет только поток-владелец: загрузка и запись вместо fetch_add
+inline void bump(std::atomic<quint64> &v, quint64 n)
+{
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void statAdd(StatCounter c, quint64 n)
+{
+    bump(threadStats().counters[int(c)], n);
+}
+
+inline void statMax(StatCounter c, quint64 n)
+{
+    std::atomic<quint64> &v = threadStats().counters[int(c)];
+    if (n > v.load(std::memory_order_relaxed))
+        v.store(n, std::memory_order_relaxed);
+}
+
+class StatScope
+{
+public:
+    explicit StatScope(StatTimer t)
+        : timer(int(t))
+        , outer(threadStats().timerDepth[timer]++ == 0)
+        , start(std::chrono::steady_clock::now()) {}
+
+    ~StatScope()
+    {
+        ThreadStats &s = threadStats();
+        --s.timerDepth[timer];
+        if (!outer)
+            return;
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        bump(s.timerNs[timer], quint64(ns));
+        bump(s.timerCalls[timer], 1);
+    }
+
+    StatScope(const StatScope &) = delete;
+    StatScope &operator=(const StatScope &) = delete;
+
+private:
+    const int timer;
+    const bool outer;
+    const std::chrono::steady_clock::time_point start;
+};
+
+} // namespace detail
+
+// Счёт, накапливаемый в самом объекте (например, в стадии конвейера) и
+// сбрасываемый в блок потока одним сложением.
+struct StatTally
+{
+    quint64 n = 0;
+
+    void add(quint64 k = 1) { n += k; }
+    void flush(StatCounter c)
+    {
+        if (n)
+            detail::statAdd(c, n);
+        n = 0;
+    }
+};
+
+#define CLIP_STAT_ADD(counter, n) \
+    ::clip::detail::statAdd(::clip::StatCounter::counter, quint64(n))
+#define CLIP_STAT_MAX(counter, n) \
+    ::clip::detail::statMax(::clip::StatCounter::counter, quint64(n))
+#define CLIP_STAT_TIMER(timer) \
+    const ::clip::detail::StatScope clipStatScope##timer(::clip::StatTimer::timer)
+
+#else
+
+struct StatTally
+{
+    void add(quint64 = 1) {}
+    void flush(StatCounter) {}
+};
+
+// выражение n не вычисляется
+#define CLIP_STAT_ADD(counter, n) ((void)sizeof(n))
+#define CLIP_STAT_MAX(counter, n) ((void)sizeof(n))
+#define CLIP_STAT_TIMER(timer) ((void)0)
+
+#endif
+
+} // namespace clip
@@ -0,0 +1,139 @@
+#include "convexwindow.h"
+#include <algorithm>
+#include <cmath>
+
+namespace clip {
+
+namespace {
+
+// допуск проверки выпуклости и «вершина на прямой» (относительный)
+constexpr double kConvexEps = 1e-9;
+
+inline double cross(const QPointF &a, const QPointF &b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+// убирает повторы подряд и вершины, лежащие на прямой соседей
+void simplify(QVector<QPointF> &v)
+{
+    bool changed = true;
+    while (changed && v.size() >= 3) {
+        changed = false;
+        for (qsizetype i = 0; i < v.size() && v.size() >= 3; ) {
+            const QPointF &prev = v[(i + v.size() - 1) % v.size()];
+            const QPointF &next = v[(i + 1) % v.size()];
+            const QPointF e1 = v[i] - prev;
+            const QPointF e2 = next - v[i];
+            const double l1 = std::hypot(e1.x(), e1.y());
+            const double l2 = std::hypot(e2.x(), e2.y());
+            if (l1 == 0.0 || std::abs(cross(e1, e2)) <= kConvexEps * l1 * l2) {
+                v.remove(i);
+                changed = true;
+            } else {
+                ++i;
+            }
+        }
+    }
+}
+
+} // namespace
+
+ConvexWindow::ConvexWindow()
+{
+    setRect(QRectF());
+}
+
+ConvexWindow::ConvexWindow(const QRectF &rect)
+{
+    setRect(rect);
+}
+
+void ConvexWindow::setRect(const QRectF &rect)
+{
+    bounds = rect.normalized();
+    rectangular = true;
+
+    const double xmin = bounds.left(), xmax = bounds.right();
+    const double ymin = bounds.top(),  ymax = bounds.bottom();
+    corners = { QPointF(xmin, ymin), QPointF(xmax, ymin),
+                QPointF(xmax, ymax), QPointF(xmin, ymax) };
+    edges = { Plane {  0.0,  1.0,  ymin },     // нижняя: y >= ymin
+              Plane { -1.0,  0.0, -xmax },     // правая: x <= xmax
+              Plane {  0.0, -1.0, -ymax },     // верхняя: y <= ymax
+              Plane {  1.0,  0.0,  xmin } };   // левая: x >= xmin
+}
+
+bool ConvexWindow::setPolygon(const QVector<QPointF> &vertices, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    QVector<QPointF> v = vertices;
+    simplify(v);
+    if (v.size() < 3)
+        return fail("у окна меньше трёх различных вершин не на одной прямой");
+
+    // обход против часовой стрелки
+    double area2 = 0.0;
+    for (qsizetype i = 0; i < v.size(); ++i)
+        area2 += cross(v[i], v[(i + 1) % v.size()]);
+    if (area2 < 0.0)
+        std::reverse(v.begin(), v.end());
+
+    double xmin = v[0].x(), xmax = xmin, ymin = v[0].y(), ymax = ymin;
+    for (const QPointF &p : std::as_const(v)) {
+        xmin = std::min(xmin, p.x());
+        xmax = std::max(xmax, p.x());
+        ymin = std::min(ymin, p.y());
+        ymax = std::max(ymax, p.y());
+    }
+
+    QVector<Plane> planes(v.size());
+    for (qsizetype i = 0; i < v.size(); ++i) {
+        const QPointF &a = v[i];
+        const QPointF e = v[(i + 1) % v.size()] - a;
+        const double len = std::hypot(e.x(), e.y());
+        const double nx = -e.y() / len, ny = e.x() / len;
+        planes[i] = Plane { nx, ny, nx * a.x() + ny * a.y() };
+    }
+
+    // выпуклый — все вершины с внутренней стороны каждой грани
+    // (так отсеиваются и самопересекающиеся «звёзды»)
+    const double eps = kConvexEps * std::max(xmax - xmin, ymax - ymin);
+    for (const Plane &plane : std::as_const(planes)) {
+        for (const QPointF &p : std::as_const(v)) {
+            if (plane.distance(p) < -eps)
+                return fail("окно не выпуклое");
+        }
+    }
+
+    corners = v;
+    edges = planes;
+    bounds = QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax));
+
+    // прямоугольник со сторонами вдоль осей
+    rectangular = v.size() == 4;
+    for (qsizetype i = 0; rectangular && i < 4; ++i) {
+        const QPointF &a = v[i];
+        const QPointF &b = v[(i + 1) % 4];
+        rectangular = a.x() == b.x() || a.y() == b.y();
+    }
+    if (rectangular)
+        setRect(bounds);
+    return true;
+}
+
+bool ConvexWindow::contains(const QPointF &P) const
+{
+    for (const Plane &plane : edges) {
+        if (plane.distance(P) < 0.0)
+            return false;
+    }
+    return true;
+}
+
+} // namespace clip
@@ -0,0 +1,55 @@
+#pragma once
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+
+namespace clip {
+
+// Выпуклое окно отсечения (многоугольник).
+//
+// Для каждой грани один раз, при задании окна, считаются единичная
+// внутренняя нормаль n и смещение d: точка P лежит с внутренней стороны
+// грани, если n·P >= d. Окно, оказавшееся прямоугольником со сторонами
+// вдоль осей, помечается isRect(), и отсечение по нему идёт прежними
+// прямоугольными ядрами по boundingRect() — без потерь на общность.
+class ConvexWindow
+{
+public:
+    // n·P >= d — внутри
+    struct Plane
+    {
+        double nx, ny, d;
+
+        double distance(const QPointF &P) const { return nx * P.x() + ny * P.y() - d; }
+    };
+
+    ConvexWindow();
+    explicit ConvexWindow(const QRectF &rect);
+
+    void setRect(const QRectF &rect);
+
+    // Вершины в любом порядке обхода; повторы и вершины на прямой
+    // отбрасываются. Если после этого меньше трёх вершин или многоугольник
+    // не выпуклый, возвращает false (причина — в error) и окно не меняет.
+    bool setPolygon(const QVector<QPointF> &vertices, QString *error = nullptr);
+
+    bool isRect() const { return rectangular; }
+    const QRectF &boundingRect() const { return bounds; }
+
+    // вершины против часовой стрелки (Y вверх); грань i — от vertices()[i]
+    // к следующей
+    const QVector<QPointF> &vertices() const { return corners; }
+    const QVector<Plane> &planes() const { return edges; }
+    int edgeCount() const { return int(edges.size()); }
+
+    bool contains(const QPointF &P) const;
+
+private:
+    QVector<QPointF> corners;
+    QVector<Plane>   edges;
+    QRectF           bounds;
+    bool             rectangular = true;
+};
+
+} // namespace clip
@@ -0,0 +1,563 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Алгоритмы отсечения как шаблоны над типом точки и координат — только
+// заголовок и стандартная библиотека, без Qt. Тип координат — float,
+// double или std::int32_t (целочисленная сетка / фиксированная точка с
+// масштабом, который выбирает вызывающий); устройство точки описывает
+// PointTraits, так что подойдёт и своя структура, и QPointF
+// (qtpointtraits.h). Функции clipcore для QPointF/QRectF — экземпляры
+// этих шаблонов для double.
+
+namespace clip {
+
+// отрезки (и видимые части) короче sqrt(kMinLength2) не выводятся
+constexpr double kMinLength2 = 1e-3;
+
+// точность поиска точки пересечения с границей делением пополам
+constexpr double kBoundaryEps2 = 1e-12;
+
+// грани прямоугольного окна; Y вверх: Bottom — ymin, Top — ymax
+enum class Edge { Left, Right, Bottom, Top };
+
+namespace generic {
+
+// ---------- координаты ----------
+
+// Wide — для квадратов длин (без переполнения на всём диапазоне типа),
+// Real — для параметра вдоль отрезка; toCoord() возвращает вычисленное
+// в Real к типу координат (целые округляются к ближайшему узлу сетки).
+template<class T> struct CoordTraits;
+
+template<>
+struct CoordTraits<double>
+{
+    using Wide = double;
+    using Real = double;
+    static constexpr Wide minLength2 = kMinLength2;
+    static constexpr Wide boundaryEps2 = kBoundaryEps2;
+
+    static double half(double a, double b) { return (a + b) / 2.0; }
+    static double toCoord(double v) { return v; }
+};
+
+template<>
+struct CoordTraits<float>
+{
+    using Wide = float;
+    using Real = float;
+    static constexpr Wide minLength2 = float(kMinLength2);
+    static constexpr Wide boundaryEps2 = float(kBoundaryEps2);
+
+    static float half(float a, float b) { return (a + b) / 2.0f; }
+    static float toCoord(float v) { return v; }
+};
+
+// Середина округляется к ближайшему узлу, половины — к чётному: при
+// округлении вниз сдвиг копится с каждым делением и уводит точки с
+// отрезка. Деление пополам останавливается на соседних узлах.
+// Квадрат длины — в double: разность int32 занимает до 33 бит, и dx² + dy²
+// не помещается даже в int64. Разности в double точны, квадраты меньше
+// 2^53 тоже, так что сравнения с порогами 1 и 2 не огрубляются.
+template<>
+struct CoordTraits<std::int32_t>
+{
+    using Wide = double;
+    using Real = double;
+    static constexpr Wide minLength2 = 1;      // точка — не отрезок
+    static constexpr Wide boundaryEps2 = 2;    // соседние узлы, в том числе по диагонали
+
+    static std::int32_t half(std::int32_t a, std::int32_t b)
+    {
+        const std::int64_t s = std::int64_t(a) + b;
+        std::int64_t h = s >> 1;
+        if ((s & 1) && (h & 1))
+            ++h;
+        return std::int32_t(h);
+    }
+    static std::int32_t toCoord(double v) { return std::int32_t(std::lround(v)); }
+};
+
+// ---------- точки ----------
+
+// Для точки P: Coord, x(p), y(p), make(x, y).
+template<class P> struct PointTraits;
+
+template<class T>
+struct Point2
+{
+    T x, y;
+};
+
+template<class T>
+struct PointTraits<Point2<T>>
+{
+    using Coord = T;
+    static T x(const Point2<T> &p) { return p.x; }
+    static T y(const Point2<T> &p) { return p.y; }
+    static Point2<T> make(T x, T y) { return Point2<T> { x, y }; }
+};
+
+template<class P> using CoordOf = typename PointTraits<P>::Coord;
+
+// ---------- окна ----------
+
+// Окно — любой тип с членами xmin, ymin, xmax, ymax. Box хранит их в
+// объекте, у FixedBox это constexpr-константы, и после встраивания
+// сравнения с гранями идут с непосредственными операндами.
+template<class T>
+struct Box
+{
+    T xmin, ymin, xmax, ymax;
+};
+
+template<int Xmin, int Ymin, int Xmax, int Ymax>
+struct FixedBox
+{
+    static_assert(Xmin <= Xmax && Ymin <= Ymax, "окно задаётся как xmin ymin xmax ymax");
+
+    static constexpr int xmin = Xmin;
+    static constexpr int ymin = Ymin;
+    static constexpr int xmax = Xmax;
+    static constexpr int ymax = Ymax;
+};
+
+template<Edge E, class W>
+constexpr auto bound(const W &w)
+{
+    if constexpr (E == Edge::Left)
+        return w.xmin;
+    else if constexpr (E == Edge::Right)
+        return w.xmax;
+    else if constexpr (E == Edge::Bottom)
+        return w.ymin;
+    else
+        return w.ymax;
+}
+
+// ---------- логические проверки ----------
+
+template<class P>
+inline bool samePoint(const P &a, const P &b)
+{
+    using PT = PointTraits<P>;
+    return PT::x(a) == PT::x(b) && PT::y(a) == PT::y(b);
+}
+
+template<class P>
+inline typename CoordTraits<CoordOf<P>>::Wide length2(const P &a, const P &b)
+{
+    using PT = PointTraits<P>;
+    using Wide = typename CoordTraits<CoordOf<P>>::Wide;
+    const Wide dx = Wide(PT::x(b)) - Wide(PT::x(a));
+    const Wide dy = Wide(PT::y(b)) - Wide(PT::y(a));
+    return dx * dx + dy * dy;
+}
+
+template<class P>
+inline P midpoint(const P &a, const P &b)
+{
+    using PT = PointTraits<P>;
+    using CT = CoordTraits<CoordOf<P>>;
+    return PT::make(CT::half(PT::x(a), PT::x(b)), CT::half(PT::y(a), PT::y(b)));
+}
+
+template<class P, class W>
+inline bool pointInside(const P &p, const W &w)
+{
+    using PT = PointTraits<P>;
+    return PT::x(p) >= w.xmin && PT::x(p) <= w.xmax &&
+           PT::y(p) >= w.ymin && PT::y(p) <= w.ymax;
+}
+
+// полностью вне окна: обе точки по одну сторону
+template<class P, class W>
+inline bool segOutside(const P &a, const P &b, const W &w)
+{
+    using PT = PointTraits<P>;
+    return (PT::x(a) < w.xmin && PT::x(b) < w.xmin) ||
+           (PT::x(a) > w.xmax && PT::x(b) > w.xmax) ||
+           (PT::y(a) < w.ymin && PT::y(b) < w.ymin) ||
+           (PT::y(a) > w.ymax && PT::y(b) > w.ymax);
+}
+
+// ---------- алгоритм средней точки ----------
+
+// что происходило внутри clipMidpoint — для счётчиков (clipstats.h)
+struct MidpointTrace
+{
+    bool trivialReject = false;   // отброшен segOutside
+    bool trivialAccept = false;   // оба конца внутри
+    int  splits = 0;              // делений пополам при поиске точки внутри
+    int  maxDepth = 0;            // глубина, до которой дошла бы рекурсия
+    int  boundarySteps = 0;       // шагов уточнения границ
+};
+
+namespace detail {
+
+// стек участков: первые N — на месте, дальше — в куче
+template<class T, int N>
+class PieceStack
+{
+public:
+    bool isEmpty() const { return count == 0; }
+
+    void push(const T &v)
+    {
+        if (count < N)
+            local[count] = v;
+        else
+            spill.push_back(v);
+        ++count;
+    }
+
+    T pop()
+    {
+        --count;
+        if (count < N)
+            return local[count];
+        const T v = spill.back();
+        spill.pop_back();
+        return v;
+    }
+
+private:
+    T local[N];
+    std::vector<T> spill;
+    int count = 0;
+};
+
+// двоичный поиск границы между inside (в окне) и outside (вне окна);
+// возвращает последнюю найденную точку внутри. Середина, совпавшая с
+// концом (предел точности float или соседние узлы сетки), тоже конец поиска.
+template<class P, class W>
+P searchBoundary(P inside, P outside, const W &w, int &steps)
+{
+    using CT = CoordTraits<CoordOf<P>>;
+    while (length2(inside, outside) >= CT::boundaryEps2) {
+        const P m = midpoint(inside, outside);
+        if (samePoint(m, inside) || samePoint(m, outside))
+            break;
+        if (pointInside(m, w))
+            inside = m;
+        else
+            outside = m;
+        ++steps;
+    }
+    return inside;
+}
+
+} // namespace detail
+
+// Видимая часть AB — в [start, end]; false, если не видно ничего.
+// Без рекурсии: делением пополам ищется точка внутри окна, затем двоичным
+// поиском уточняются обе границы. Окно выпуклое, поэтому часть одна.
+template<class P, class W>
+bool clipMidpoint(const P &A, const P &B, const W &w, P &start, P &end,
+                  MidpointTrace *trace = nullptr)
+{
+    using CT = CoordTraits<CoordOf<P>>;
+
+    if (length2(A, B) < CT::minLength2)
+        return false;
+
+    if (segOutside(A, B, w)) {
+        if (trace)
+            trace->trivialReject = true;
+        return false;
+    }
+
+    const bool Ainside = pointInside(A, w);
+    const bool Binside = pointInside(B, w);
+
+    if (Ainside && Binside) {
+        if (trace)
+            trace->trivialAccept = true;
+        start = A;
+        end = B;
+        return true;
+    }
+
+    // L и R — концы участка, внутри которого лежит точка окна M
+    P L = A, R = B, M = A;
+
+    if (Binside && !Ainside) {
+        M = B;
+    } else if (!Ainside) {
+        // оба конца вне окна: делим пополам, пока середина какого-нибудь
+        // участка не окажется внутри; depth — глубина участка при рекурсии
+        struct Piece { P A, B; int depth; };
+        detail::PieceStack<Piece, 64> stack;
+        stack.push(Piece { A, B, 0 });
+
+        bool found = false;
+        int splits = 0, maxDepth = 0;
+        while (!stack.isEmpty() && !found) {
+            const Piece piece = stack.pop();
+
+            if (length2(piece.A, piece.B) < CT::minLength2)
+                continue;
+            if (segOutside(piece.A, piece.B, w))
+                continue;
+
+            const P mid = midpoint(piece.A, piece.B);
+            if (pointInside(mid, w)) {
+                L = piece.A;
+                R = piece.B;
+                M = mid;
+                found = true;
+            } else if (!samePoint(mid, piece.A) && !samePoint(mid, piece.B)) {
+                stack.push(Piece { mid, piece.B, piece.depth + 1 });
+                stack.push(Piece { piece.A, mid, piece.depth + 1 });
+                ++splits;
+                maxDepth = std::max(maxDepth, piece.depth + 1);
+            }
+        }
+        if (trace) {
+            trace->splits = splits;
+            trace->maxDepth = maxDepth;
+        }
+
+        if (!found)
+            return false;
+    }
+
+    // уточняем обе границы видимого участка
+    int steps = 0;
+    start = Ainside ? A : detail::searchBoundary(M, L, w, steps);
+    end   = Binside ? B : detail::searchBoundary(M, R, w, steps);
+    if (trace)
+        trace->boundarySteps = steps;
+
+    return length2(start, end) >= CT::minLength2;
+}
+
+// ---------- точки пересечения с гранями ----------
+
+// Пересечение AB с гранью E (отрезком границы окна, концы включены).
+template<Edge E, class P, class W>
+bool edgeIntersection(const P &A, const P &B, const W &w, P &out)
+{
+    using PT = PointTraits<P>;
+    using CT = CoordTraits<CoordOf<P>>;
+    using Real = typename CT::Real;
+
+    constexpr bool vertical = E == Edge::Left || E == Edge::Right;
+    // u — координата поперёк грани, v — вдоль
+    const Real u0 = vertical ? PT::x(A) : PT::y(A);
+    const Real u1 = vertical ? PT::x(B) : PT::y(B);
+    const Real v0 = vertical ? PT::y(A) : PT::x(A);
+    const Real v1 = vertical ? PT::y(B) : PT::x(B);
+    const Real du = u1 - u0;
+    if (du == Real(0))
+        return false;             // параллелен грани
+
+    const Real edge = Real(bound<E>(w));
+    const Real t = (edge - u0) / du;
+    if (t < Real(0) || t > Real(1))
+        return false;
+
+    const Real v = v0 + t * (v1 - v0);
+    const Real vmin = Real(vertical ? w.ymin : w.xmin);
+    const Real vmax = Real(vertical ? w.ymax : w.xmax);
+    if (v < vmin || v > vmax)
+        return false;
+
+    const auto e = CT::toCoord(edge);
+    const auto c = CT::toCoord(v);
+    out = vertical ? PT::make(e, c) : PT::make(c, e);
+    return true;
+}
+
+// Точки пересечения AB с гранями (Left, Right, Bottom, Top) дописываются
+// в out (нужен push_back); возвращает, сколько их.
+template<class P, class W, class Out>
+int appendRealIntersections(const P &A, const P &B, const W &w, Out &out)
+{
+    int n = 0;
+    P r;
+    if (edgeIntersection<Edge::Left>(A, B, w, r))   { out.push_back(r); ++n; }
+    if (edgeIntersection<Edge::Right>(A, B, w, r))  { out.push_back(r); ++n; }
+    if (edgeIntersection<Edge::Bottom>(A, B, w, r)) { out.push_back(r); ++n; }
+    if (edgeIntersection<Edge::Top>(A, B, w, r))    { out.push_back(r); ++n; }
+    return n;
+}
+
+// ---------- Сазерленд–Ходжман ----------
+
+// счётчики вершин в стадиях: NoCount ничего не стоит, Count считает
+struct NoCount
+{
+    void add() {}
+    std::size_t value() const { return 0; }
+};
+
+struct Count
+{
+    std::size_t n = 0;
+
+    void add() { ++n; }
+    std::size_t value() const { return n; }
+};
+
+// приёмник, который всё выбрасывает (например, ненужные точки пересечения)
+template<class P>
+struct Discard
+{
+    void push_back(const P &) {}
+};
+
+template<Edge E, class P>
+inline bool insideEdge(const P &p, CoordOf<P> b)
+{
+    using PT = PointTraits<P>;
+    if constexpr (E == Edge::Left)
+        return PT::x(p) >= b;
+    else if constexpr (E == Edge::Right)
+        return PT::x(p) <= b;
+    else if constexpr (E == Edge::Bottom)
+        return PT::y(p) >= b;
+    else
+        return PT::y(p) <= b;
+}
+
+// пересечение SP с прямой грани E (точки по разные стороны от неё)
+template<Edge E, class P>
+inline P intersectWithEdge(const P &S, const P &P1, CoordOf<P> b)
+{
+    using PT = PointTraits<P>;
+    using CT = CoordTraits<CoordOf<P>>;
+    using Real = typename CT::Real;
+
+    const Real dx = Real(PT::x(P1)) - Real(PT::x(S));
+    const Real dy = Real(PT::y(P1)) - Real(PT::y(S));
+
+    if constexpr (E == Edge::Left || E == Edge::Right) {
+        const Real t = (dx == Real(0)) ? Real(0) : (Real(b) - Real(PT::x(S))) / dx;
+        return PT::make(b, CT::toCoord(Real(PT::y(S)) + t * dy));
+    } else {
+        const Real t = (dy == Real(0)) ? Real(0) : (Real(b) - Real(PT::y(S))) / dy;
+        return PT::make(CT::toCoord(Real(PT::x(S)) + t * dx), b);
+    }
+}
+
+// последняя стадия: складывает вершины в результат (нужен push_back)
+template<class P, class Out, class Counter = NoCount>
+struct PolygonSink
+{
+    Out &out;
+    Counter received {};
+
+    void push(const P &p)
+    {
+        received.add();
+        out.push_back(p);
+    }
+    void close() {}
+};
+
+// Стадия отсечения одной гранью. Получает вершины по одной, для каждого
+// ребра (предыдущая, текущая) передаёт дальше то же, что clipAgainstEdge:
+//   внутри -> внутри: конец; внутри -> вне: пересечение;
+//   вне -> внутри: пересечение и конец; вне -> вне: ничего.
+template<Edge E, class P, class Next, class Points, class Counter = NoCount>
+class EdgeStage : private Counter
+{
+public:
+    using Coord = CoordOf<P>;
+
+    EdgeStage(Coord bound, Next &next, Points &intersections)
+        : bound(bound), next(next), intersections(intersections) {}
+
+    void push(const P &p)
+    {
+        Counter::add();
+        const bool in = insideEdge<E>(p, bound);
+        if (!hasFirst) {
+            first = p;
+            firstIn = in;
+            hasFirst = true;
+        } else {
+            edge(prev, prevIn, p, in);
+        }
+        prev = p;
+        prevIn = in;
+    }
+
+    // замыкающее ребро (последняя, первая)
+    void close()
+    {
+        if (hasFirst)
+            edge(prev, prevIn, first, firstIn);
+        next.close();
+    }
+
+    // вершин, пришедших на вход стадии
+    std::size_t count() const { return Counter::value(); }
+
+private:
+    void edge(const P &S, bool Sin, const P &p, bool Pin)
+    {
+        if (Sin && Pin) {
+            next.push(p);
+        } else if (Sin != Pin) {
+            const P I = intersectWithEdge<E>(S, p, bound);
+            intersections.push_back(I);
+            next.push(I);
+            if (Pin)
+                next.push(p);
+        }
+    }
+
+    const Coord bound;
+    Next &next;
+    Points &intersections;
+
+    P first {}, prev {};
+    bool firstIn = false, prevIn = false;
+    bool hasFirst = false;
+};
+
+// Четыре стадии подряд: Left -> Right -> Bottom -> Top -> out. Вершины
+// результата идут в том же порядке, что при последовательном отсечении
+// гранями в этом порядке.
+template<class P, class Out, class Points, class Counter = NoCount>
+struct RectPipeline
+{
+    template<class W>
+    RectPipeline(const W &w, Out &out, Points &intersections)
+        : sink { out },
+          top   (CoordOf<P>(w.ymax), sink,   intersections),
+          bottom(CoordOf<P>(w.ymin), top,    intersections),
+          right (CoordOf<P>(w.xmax), bottom, intersections),
+          left  (CoordOf<P>(w.xmin), right,  intersections) {}
+
+    void push(const P &p) { left.push(p); }
+    void close() { left.close(); }
+
+    PolygonSink<P, Out, Counter>                             sink;
+    EdgeStage<Edge::Top,    P, decltype(sink),   Points, Counter> top;
+    EdgeStage<Edge::Bottom, P, decltype(top),    Points, Counter> bottom;
+    EdgeStage<Edge::Right,  P, decltype(bottom), Points, Counter> right;
+    EdgeStage<Edge::Left,   P, decltype(right),  Points, Counter> left;
+};
+
+// Многоугольник polygon[0..count) отсекается окном w; вершины и точки
+// пересечения дописываются в outPolygon и outIntersections.
+template<class P, class W, class Out, class Points>
+void appendPolygonSutherlandHodgman(const P *polygon, std::size_t count, const W &w,
+                                    Out &outPolygon, Points &outIntersections)
+{
+    RectPipeline<P, Out, Points> pipeline(w, outPolygon, outIntersections);
+    for (std::size_t i = 0; i < count; ++i)
+        pipeline.push(polygon[i]);
+    pipeline.close();
+}
+
+} // namespace generic
+
+} // namespace clip
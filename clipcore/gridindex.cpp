@@ -0,0 +1,254 @@
+#include "gridindex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace clip {
+
+namespace {
+
+// прямоугольник как четыре числа: без нормализации QRectF на каждом шаге
+struct Box
+{
+    double xmin, ymin, xmax, ymax;
+};
+
+inline Box boxOf(const QLineF &s)
+{
+    return Box { std::min(s.x1(), s.x2()), std::min(s.y1(), s.y2()),
+                 std::max(s.x1(), s.x2()), std::max(s.y1(), s.y2()) };
+}
+
+inline Box boxOf(const QPointF &p)
+{
+    return Box { p.x(), p.y(), p.x(), p.y() };
+}
+
+// NaN и бесконечности в сетку не попадают: int(NaN) не определён
+inline bool isFinite(const Box &b)
+{
+    return std::isfinite(b.xmin) && std::isfinite(b.ymin) &&
+           std::isfinite(b.xmax) && std::isfinite(b.ymax);
+}
+
+// предел размера сетки по каждой оси
+constexpr int kMaxCellsPerAxis = 4096;
+
+} // namespace
+
+void GridIndex::build(const QVector<QLineF> &segments)
+{
+    const QLineF *s = segments.constData();
+    buildBoxes(segments.size(), [s](qsizetype i) { return boxOf(s[i]); });
+}
+
+void GridIndex::build(const QVector<QPointF> &points)
+{
+    const QPointF *p = points.constData();
+    buildBoxes(points.size(), [p](qsizetype i) { return boxOf(p[i]); });
+}
+
+void GridIndex::clear()
+{
+    count = 0;
+    levels.clear();
+    stamps.clear();
+    stamp = 0;
+}
+
+// ограничение до приведения к int: координаты запроса могут быть сколь
+// угодно далеко от сетки
+int GridIndex::cellX(const Level &level, double x) const
+{
+    return int(std::clamp(std::floor((x - x0) * level.invCellW), 0.0, double(level.nx - 1)));
+}
+
+int GridIndex::cellY(const Level &level, double y) const
+{
+    return int(std::clamp(std::floor((y - y0) * level.invCellH), 0.0, double(level.ny - 1)));
+}
+
+template<class BoxOf>
+void GridIndex::buildBoxes(qsizetype n, BoxOf boxOf)
+{
+    clear();
+    if (n == 0)
+        return;
+
+    // --- границы всех элементов (кроме нечисловых — их запрос не выдаёт) ---
+    const double inf = std::numeric_limits<double>::infinity();
+    Box bounds { inf, inf, -inf, -inf };
+    for (qsizetype i = 0; i < n; ++i) {
+        const Box b = boxOf(i);
+        if (!isFinite(b))
+            continue;
+        bounds.xmin = std::min(bounds.xmin, b.xmin);
+        bounds.ymin = std::min(bounds.ymin, b.ymin);
+        bounds.xmax = std::max(bounds.xmax, b.xmax);
+        bounds.ymax = std::max(bounds.ymax, b.ymax);
+    }
+    if (bounds.xmin > bounds.xmax)
+        return;
+
+    // --- основная сетка: около kItemsPerCell элементов на ячейку,
+    //     ячейки примерно квадратные; над ней — всё более грубые ---
+    const double w = std::max(bounds.xmax - bounds.xmin, 1e-9);
+    const double h = std::max(bounds.ymax - bounds.ymin, 1e-9);
+    const double cells = std::max(1.0, double(n) / kItemsPerCell);
+    int nx = std::clamp(int(std::ceil(std::sqrt(cells * w / h))), 1, kMaxCellsPerAxis);
+    int ny = std::clamp(int(std::ceil(cells / nx)), 1, kMaxCellsPerAxis);
+    for (;;) {
+        Level level;
+        level.nx = nx;
+        level.ny = ny;
+        level.invCellW = nx / w;
+        level.invCellH = ny / h;
+        levels.append(level);
+        if (nx == 1 && ny == 1)
+            break;
+        nx = (nx + kLevelScale - 1) / kLevelScale;
+        ny = (ny + kLevelScale - 1) / kLevelScale;
+    }
+
+    x0 = bounds.xmin;
+    y0 = bounds.ymin;
+    x1 = bounds.xmax;
+    y1 = bounds.ymax;
+    count = n;
+
+    // --- сетка каждого элемента: самая мелкая, где он накрывает не больше
+    //     kMaxCellsPerItem ячеек; в последней (одна ячейка) — всегда ---
+    const int levelCount = int(levels.size());
+    QVector<qint8> levelOf(n, -1);
+    QVector<qsizetype> levelSize(levelCount, 0);
+    for (qsizetype i = 0; i < n; ++i) {
+        const Box b = boxOf(i);
+        if (!isFinite(b))
+            continue;
+        int l = 0;
+        for (; l < levelCount - 1; ++l) {
+            const Level &level = levels[l];
+            const qsizetype spanX = cellX(level, b.xmax) - cellX(level, b.xmin) + 1;
+            const qsizetype spanY = cellY(level, b.ymax) - cellY(level, b.ymin) + 1;
+            if (spanX * spanY <= kMaxCellsPerItem)
+                break;
+        }
+        levelOf[i] = qint8(l);
+        ++levelSize[l];
+    }
+
+    for (int l = 0; l < levelCount; ++l) {
+        Level &level = levels[l];
+        if (levelSize[l] == 0)
+            continue;
+        auto forCells = [&](const Box &b, auto visit) {
+            const int cx0 = cellX(level, b.xmin), cx1 = cellX(level, b.xmax);
+            const int cy0 = cellY(level, b.ymin), cy1 = cellY(level, b.ymax);
+            for (int cy = cy0; cy <= cy1; ++cy)
+                for (int cx = cx0; cx <= cx1; ++cx)
+                    visit(qsizetype(cy) * level.nx + cx);
+        };
+
+        // --- проход 1: сколько элементов в каждой ячейке ---
+        const qsizetype cellCount = qsizetype(level.nx) * level.ny;
+        level.cellStart.fill(0, cellCount + 1);
+        qsizetype *start = level.cellStart.data();
+        if (l > 0) {
+            level.ids.reserve(levelSize[l]);
+            level.boxes.reserve(levelSize[l]);
+        }
+        for (qsizetype i = 0; i < n; ++i) {
+            if (levelOf[i] != l)
+                continue;
+            const Box b = boxOf(i);
+            forCells(b, [start](qsizetype c) { ++start[c + 1]; });
+            if (l > 0) {
+                level.ids.append(quint32(i));
+                level.boxes.append(QRectF(QPointF(b.xmin, b.ymin), QPointF(b.xmax, b.ymax)));
+            }
+        }
+
+        for (qsizetype c = 0; c < cellCount; ++c)
+            start[c + 1] += start[c];
+
+        // --- проход 2: раскладка номеров по ячейкам ---
+        level.cellItems.resize(start[cellCount]);
+        quint32 *items = level.cellItems.data();
+        QVector<qsizetype> fill(level.cellStart.constBegin(), level.cellStart.constEnd() - 1);
+        qsizetype *next = fill.data();
+        if (l == 0) {
+            for (qsizetype i = 0; i < n; ++i)
+                if (levelOf[i] == 0)
+                    forCells(boxOf(i), [&](qsizetype c) { items[next[c]++] = quint32(i); });
+        } else {
+            for (qsizetype k = 0; k < level.ids.size(); ++k)
+                forCells(boxOf(level.ids[k]), [&](qsizetype c) { items[next[c]++] = quint32(k); });
+        }
+    }
+
+    stamps.fill(0, n);
+}
+
+void GridIndex::query(const QRectF &rect, QVector<quint32> &out) const
+{
+    query(&rect, 1, out);
+}
+
+void GridIndex::query(const QRectF *rects, int rectCount,
+                      QVector<quint32> &out) const
+{
+    out.clear();
+    if (count == 0)
+        return;
+
+    // новая метка на запрос; при переполнении метки сбрасываются
+    if (++stamp == 0) {
+        stamps.fill(0);
+        stamp = 1;
+    }
+    quint32 *seen = stamps.data();
+
+    for (int i = 0; i < rectCount; ++i) {
+        const QRectF r = rects[i].normalized();
+        if (std::isnan(r.left()) || std::isnan(r.right()) ||
+            std::isnan(r.top()) || std::isnan(r.bottom()))
+            continue;
+        if (r.right() < x0 || r.left() > x1 || r.bottom() < y0 || r.top() > y1)
+            continue;
+
+        for (const Level &level : levels) {
+            if (level.cellItems.isEmpty())
+                continue;
+            const qsizetype *start = level.cellStart.constData();
+            const quint32 *items = level.cellItems.constData();
+
+            const int cx0 = cellX(level, r.left()),  cx1 = cellX(level, r.right());
+            const int cy0 = cellY(level, r.top()),   cy1 = cellY(level, r.bottom());
+
+            const quint32 *ids = level.ids.constData();
+            const QRectF *boxes = level.boxes.constData();
+            const bool coarse = !level.ids.isEmpty();
+
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                for (int cx = cx0; cx <= cx1; ++cx) {
+                    const qsizetype c = qsizetype(cy) * level.nx + cx;
+                    for (qsizetype k = start[c]; k < start[c + 1]; ++k) {
+                        const quint32 id = coarse ? ids[items[k]] : items[k];
+                        if (seen[id] == stamp)
+                            continue;
+                        if (coarse) {
+                            const QRectF &b = boxes[items[k]];
+                            if (b.right() < r.left() || b.left() > r.right() ||
+                                b.bottom() < r.top() || b.top() > r.bottom())
+                                continue;
+                        }
+                        seen[id] = stamp;
+                        out.append(id);
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace clip
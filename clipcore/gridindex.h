@@ -0,0 +1,73 @@
+#pragma once
+#include <QVector>
+#include <QLineF>
+#include <QRectF>
+
+namespace clip {
+
+// Равномерная сетка над ограничивающими прямоугольниками отрезков (или
+// точек) для выборки того, что попадает в прямоугольник, — например, в
+// видимую область холста.
+//
+// Ячейки хранятся сжато (номера элементов подряд, начало ячейки — в
+// cellStart). Сеток несколько: над основной — всё более грубые, каждая в
+// kLevelScale раз крупнее по каждой оси, последняя — одна ячейка. Элемент
+// кладётся в самую мелкую сетку, где накрывает не больше kMaxCellsPerItem
+// ячеек, поэтому длинные отрезки не раздувают основную сетку и не
+// перебираются подряд при каждом запросе.
+class GridIndex
+{
+public:
+    // средняя заполненность ячейки, предел ячеек на один элемент
+    // и во сколько раз следующая сетка грубее
+    static constexpr int kItemsPerCell    = 4;
+    static constexpr int kMaxCellsPerItem = 64;
+    static constexpr int kLevelScale      = 8;
+
+    void build(const QVector<QLineF> &segments);
+    void build(const QVector<QPointF> &points);
+    void clear();
+
+    bool isEmpty() const { return count == 0; }
+
+    // Номера элементов, прямоугольник которых может пересекать rect, каждый
+    // по одному разу (порядок не определён). out очищается. Запрос меняет
+    // внутренние метки, поэтому из нескольких потоков сразу не вызывается.
+    void query(const QRectF &rect, QVector<quint32> &out) const;
+
+    // то же для объединения нескольких прямоугольников
+    void query(const QRectF *rects, int rectCount, QVector<quint32> &out) const;
+
+private:
+    struct Level
+    {
+        int    nx = 0, ny = 0;
+        double invCellW = 0, invCellH = 0;
+
+        QVector<qsizetype> cellStart;  // nx * ny + 1
+        QVector<quint32>   cellItems;
+
+        // у грубых сеток в cellItems — место в ids и boxes: элемент там
+        // проверяется по своему прямоугольнику, а не выдаётся всей ячейкой
+        QVector<quint32>   ids;
+        QVector<QRectF>    boxes;
+    };
+
+    template<class BoxOf>
+    void buildBoxes(qsizetype n, BoxOf boxOf);
+
+    int cellX(const Level &level, double x) const;
+    int cellY(const Level &level, double y) const;
+
+    qsizetype count = 0;
+    double    x0 = 0, y0 = 0;          // углы сетки
+    double    x1 = 0, y1 = 0;
+
+    QVector<Level> levels;             // от основной к самой грубой
+
+    // метки «уже выдан в этом запросе»
+    mutable QVector<quint32> stamps;
+    mutable quint32          stamp = 0;
+};
+
+} // namespace clip
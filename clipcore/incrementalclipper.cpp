@@ -0,0 +1,255 @@
+#include "incrementalclipper.h"
+#include "clipstats.h"
+#include <algorithm>
+
+namespace clip {
+
+namespace {
+
+// отрезков на часть при параллельном пересчёте
+constexpr qsizetype kReclipPartSize = 4096;
+
+// Полоса, которую прошла вертикальная (или горизонтальная) грань, в
+// пределах объединения старого и нового окна по другой оси: рамка, не
+// задевающая объединение, снаружи обоих окон.
+QRectF verticalBand(double a, double b, const QRectF &span)
+{
+    return QRectF(QPointF(std::min(a, b), span.top()),
+                  QPointF(std::max(a, b), span.bottom()));
+}
+
+QRectF horizontalBand(double a, double b, const QRectF &span)
+{
+    return QRectF(QPointF(span.left(), std::min(a, b)),
+                  QPointF(span.right(), std::max(a, b)));
+}
+
+} // namespace
+
+quint8 IncrementalClipper::classify(const QLineF &s, const QRectF &w)
+{
+    const double xmin = std::min(s.x1(), s.x2()), xmax = std::max(s.x1(), s.x2());
+    const double ymin = std::min(s.y1(), s.y2()), ymax = std::max(s.y1(), s.y2());
+
+    if (xmax < w.left() || xmin > w.right() || ymax < w.top() || ymin > w.bottom())
+        return kOutside;
+    if (xmin > w.left() && xmax < w.right() && ymin > w.top() && ymax < w.bottom())
+        return kInside;
+    return kPartial;
+}
+
+void IncrementalClipper::clear()
+{
+    segments.clear();
+    engine = nullptr;
+    grid.clear();
+    fragments.clear();
+    flags.clear();
+    setOf.clear();
+    pointSets.clear();
+    freeSets.clear();
+    candidates.clear();
+}
+
+void IncrementalClipper::setSegments(const QVector<QLineF> &input)
+{
+    clear();
+    segments = input;
+    grid.build(segments);
+}
+
+void IncrementalClipper::setSegments(const QVector<QLineF> &input,
+                                     const GridIndex &index)
+{
+    clear();
+    segments = input;
+    grid = index;
+}
+
+void IncrementalClipper::clipAll(const QRectF &window,
+                                 const SegmentEngine &clipEngine,
+                                 WorkStealingPool &pool)
+{
+    begin(window, clipEngine);
+    reclip(nullptr, 0, segments.size(), pool);
+}
+
+void IncrementalClipper::begin(const QRectF &window,
+                               const SegmentEngine &clipEngine)
+{
+    clipWindow = window;
+    engine = &clipEngine;
+
+    const qsizetype n = segments.size();
+    fragments.resize(n);
+    flags.fill(kUnknown, n);
+    setOf.fill(-1, n);
+    pointSets.clear();
+    freeSets.clear();
+}
+
+void IncrementalClipper::clipRange(qsizetype first, qsizetype last,
+                                   WorkStealingPool &pool)
+{
+    CLIP_STAT_TIMER(Clip);
+    if (engine && first < last)
+        reclip(nullptr, first, last - first, pool);
+}
+
+qsizetype IncrementalClipper::setWindow(const QRectF &window,
+                                        WorkStealingPool &pool)
+{
+    CLIP_STAT_TIMER(Clip);
+    const QRectF old = clipWindow;
+    clipWindow = window;
+    if (!engine || window == old)
+        return 0;
+
+    // полосы, пройденные гранями, которые сдвинулись
+    const QRectF span = old.united(window);
+    QRectF bands[4];
+    int bandCount = 0;
+    if (window.left() != old.left())
+        bands[bandCount++] = verticalBand(old.left(), window.left(), span);
+    if (window.right() != old.right())
+        bands[bandCount++] = verticalBand(old.right(), window.right(), span);
+    if (window.top() != old.top())
+        bands[bandCount++] = horizontalBand(old.top(), window.top(), span);
+    if (window.bottom() != old.bottom())
+        bands[bandCount++] = horizontalBand(old.bottom(), window.bottom(), span);
+
+    grid.query(bands, bandCount, candidates);
+
+    // плюс все отрезки с точками пересечения (без повторов)
+    for (const PointSet &set : std::as_const(pointSets)) {
+        if (set.id != kNoId)
+            candidates.append(set.id);
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    reclip(candidates.constData(), 0, candidates.size(), pool);
+    return candidates.size();
+}
+
+void IncrementalClipper::reclip(const quint32 *ids, qsizetype first,
+                                qsizetype count, WorkStealingPool &pool)
+{
+    const qsizetype parts = (count + kReclipPartSize - 1) / kReclipPartSize;
+    QVector<QVector<PendingPoints>> pending(parts);
+
+    // указатели заранее: из потоков — без проверок разделения QVector
+    QVector<PendingPoints> *pendingOut = pending.data();
+    const QLineF *seg = segments.constData();
+    QLineF *frag = fragments.data();
+    quint8 *flag = flags.data();
+    const qint32 *set = setOf.constData();
+    const QRectF window = clipWindow;
+    const SegmentEngine &clipEngine = *engine;
+
+    pool.run(parts, [&](qsizetype part, int) {
+        const qsizetype begin = part * kReclipPartSize;
+        const qsizetype end = std::min(begin + kReclipPartSize, count);
+        QVector<QLineF> out;
+        QVector<QPointF> real;
+
+        for (qsizetype k = begin; k < end; ++k) {
+            const quint32 i = ids ? ids[k] : quint32(first + k);
+            const QLineF &s = seg[i];
+            const quint8 cls = classify(s, window);
+
+            // строго внутри и раньше, и теперь — результат от окна не зависит
+            if (cls == kInside && flag[i] != kUnknown && (flag[i] & kClassMask) == kInside)
+                continue;
+
+            quint8 f = cls;
+            PointSet points;
+            if (cls != kOutside) {
+                out.clear();
+                clipEngine.clip(s.p1(), s.p2(), window, out);
+                if (!out.isEmpty()) {
+                    frag[i] = out.first();
+                    f |= kVisible;
+                }
+                if (cls == kPartial) {
+                    real.clear();
+                    appendRealIntersections(s.p1(), s.p2(), window, real);
+                    points.count = int(std::min<qsizetype>(real.size(), 4));
+                    std::copy(real.cbegin(), real.cbegin() + points.count, points.points);
+                }
+            }
+            flag[i] = f;
+
+            if (points.count > 0 || set[i] >= 0)
+                pendingOut[part].append(PendingPoints { i, points });
+        }
+    });
+
+    // наборы точек раздаются в одном потоке
+    for (const QVector<PendingPoints> &partPending : std::as_const(pending)) {
+        for (const PendingPoints &p : partPending) {
+            qint32 &slot = setOf[p.id];
+            if (p.set.count == 0) {
+                pointSets[slot].id = kNoId;
+                freeSets.append(slot);
+                slot = -1;
+                continue;
+            }
+            if (slot < 0) {
+                if (!freeSets.isEmpty()) {
+                    slot = freeSets.takeLast();
+                } else {
+                    slot = qint32(pointSets.size());
+                    pointSets.append(PointSet());
+                }
+            }
+            pointSets[slot] = p.set;
+            pointSets[slot].id = p.id;
+        }
+    }
+}
+
+void IncrementalClipper::result(SegmentClipResult &out) const
+{
+    out.visible.clear();
+    out.intersections.clear();
+
+    for (qsizetype i = 0; i < segments.size(); ++i) {
+        const QPointF *points;
+        const int n = intersections(i, points);
+        for (int k = 0; k < n; ++k)
+            out.intersections.append(points[k]);
+        if (flags[i] & kVisible)
+            out.visible.append(fragments[i]);
+    }
+}
+
+qsizetype IncrementalClipper::visibleCount() const
+{
+    qsizetype n = 0;
+    for (quint8 f : flags)
+        n += (f & kVisible) != 0;
+    return n;
+}
+
+qsizetype IncrementalClipper::intersectionCount() const
+{
+    qsizetype n = 0;
+    for (const PointSet &set : pointSets) {
+        if (set.id != kNoId)
+            n += set.count;
+    }
+    return n;
+}
+
+void IncrementalClipper::visibleIds(QVector<quint32> &ids) const
+{
+    ids.clear();
+    ids.reserve(visibleCount());
+    for (qsizetype i = 0; i < flags.size(); ++i) {
+        if (flags[i] & kVisible)
+            ids.append(quint32(i));
+    }
+}
+
+} // namespace clip
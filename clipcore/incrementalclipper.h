@@ -0,0 +1,122 @@
+#pragma once
+#include "gridindex.h"
+#include "segmentengine.h"
+#include "threadpool.h"
+
+namespace clip {
+
+// Отсечение набора отрезков с запоминанием результата каждого отрезка,
+// чтобы при перемещении окна пересчитывать только то, что могло измениться.
+//
+// Для каждого отрезка хранятся класс относительно окна (снаружи — рамка
+// целиком за одной из граней; внутри — рамка строго внутри окна; иначе
+// пересекает), видимая часть и точки пересечения. Результат отрезка
+// зависит от грани окна, только если его рамка задевает полосу, которую
+// грань прошла при перемещении; такие отрезки находятся по сетке, прочие
+// (в том числе оставшиеся снаружи или внутри) не трогаются. Исключение —
+// отрезки с точками пересечения: точка считается по ребру окна целиком,
+// поэтому они пересчитываются при любом перемещении.
+class IncrementalClipper
+{
+public:
+    // новый набор отрезков (строится сетка); результат сбрасывается
+    void setSegments(const QVector<QLineF> &segments);
+    // то же с уже построенной по этим отрезкам сеткой
+    void setSegments(const QVector<QLineF> &segments, const GridIndex &index);
+    void clear();
+
+    // полное отсечение; engine должен жить, пока используется клиппер
+    void clipAll(const QRectF &window,
+                 const SegmentEngine &engine,
+                 WorkStealingPool &pool = WorkStealingPool::global());
+
+    // То же по частям (фоновая загрузка): begin(), затем clipRange() по
+    // диапазонам номеров, пока не будут пройдены все отрезки. До этого
+    // результат неотсечённых отрезков пуст, а setWindow() не вызывается.
+    void begin(const QRectF &window, const SegmentEngine &engine);
+    void clipRange(qsizetype first, qsizetype last,
+                   WorkStealingPool &pool = WorkStealingPool::global());
+
+    // новое окно (после clipAll); возвращает, сколько отрезков пересчитано
+    qsizetype setWindow(const QRectF &window,
+                        WorkStealingPool &pool = WorkStealingPool::global());
+
+    const QRectF &window() const { return clipWindow; }
+    qsizetype size() const { return segments.size(); }
+
+    // сетка по исходным отрезкам (для отбора видимых на экране)
+    const GridIndex &index() const { return grid; }
+
+    // видимая часть i-го отрезка
+    bool visible(qsizetype i, QLineF &fragment) const
+    {
+        if (!(flags[i] & kVisible))
+            return false;
+        fragment = fragments[i];
+        return true;
+    }
+
+    // точки пересечения i-го отрезка с гранями (не больше четырёх)
+    int intersections(qsizetype i, const QPointF *&points) const
+    {
+        const qint32 set = setOf[i];
+        if (set < 0)
+            return 0;
+        points = pointSets[set].points;
+        return pointSets[set].count;
+    }
+
+    // результат в порядке входа — как у SegmentEngine::clipAll()
+    void result(SegmentClipResult &out) const;
+
+    // Для записи результата прямо из буферов (resultexport.h): число
+    // видимых частей и точек пересечения, номера отрезков с видимой частью
+    // по порядку и сами части — fragmentData()[id] для id из visibleIds().
+    qsizetype visibleCount() const;
+    qsizetype intersectionCount() const;
+    void visibleIds(QVector<quint32> &ids) const;
+    const QLineF *fragmentData() const { return fragments.constData(); }
+
+private:
+    enum : quint8 {
+        kOutside = 0, kInside = 1, kPartial = 2,
+        kClassMask = 3,
+        kVisible = 4,
+        kUnknown = 8             // ещё не отсекался (без kVisible)
+    };
+
+    struct PointSet
+    {
+        QPointF points[4];
+        int     count = 0;
+        quint32 id = kNoId;      // чей набор; kNoId — свободен
+    };
+    static constexpr quint32 kNoId = 0xFFFFFFFF;
+
+    struct PendingPoints
+    {
+        quint32  id;
+        PointSet set;
+    };
+
+    static quint8 classify(const QLineF &s, const QRectF &window);
+
+    // пересчёт отрезков ids (или first, first + 1, ... при ids == nullptr)
+    void reclip(const quint32 *ids, qsizetype first, qsizetype count,
+                WorkStealingPool &pool);
+
+    QVector<QLineF>   segments;
+    QRectF            clipWindow;
+    const SegmentEngine *engine = nullptr;
+    GridIndex         grid;
+
+    QVector<QLineF>   fragments;     // видимая часть (если kVisible)
+    QVector<quint8>   flags;         // класс | kVisible
+    QVector<qint32>   setOf;         // номер набора точек или -1
+    QVector<PointSet> pointSets;
+    QVector<qint32>   freeSets;
+
+    QVector<quint32>  candidates;
+};
+
+} // namespace clip
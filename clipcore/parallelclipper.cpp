@@ -0,0 +1,88 @@
+#include "parallelclipper.h"
+#include "clipstats.h"
+#include <algorithm>
+
+namespace clip {
+
+namespace {
+
+// Window — QRectF или ConvexWindow: выбор перегрузки clipRange
+// происходит при компиляции, во внутреннем цикле ветвлений нет
+template<class Window>
+void clipParallel(const QVector<QLineF> &segments,
+                  const Window &window,
+                  const SegmentEngine &engine,
+                  SegmentClipResult &result,
+                  WorkStealingPool &pool,
+                  qsizetype chunkSize)
+{
+    CLIP_STAT_TIMER(Clip);
+    chunkSize = std::max<qsizetype>(chunkSize, 1);
+    const qsizetype n = segments.size();
+    const qsizetype chunks = (n + chunkSize - 1) / chunkSize;
+
+    if (chunks <= 1 || pool.threadCount() == 1) {
+        engine.clipAll(segments, window, result);
+        return;
+    }
+
+    // --- отсечение: у каждой части свой буфер ---
+    // (указатели берутся заранее: неконстантный доступ к QVector из
+    //  нескольких потоков проверял бы общий счётчик ссылок)
+    QVector<SegmentClipResult> parts(chunks);
+    SegmentClipResult *partOut = parts.data();
+    pool.run(chunks, [&](qsizetype part, int) {
+        const qsizetype begin = part * chunkSize;
+        const qsizetype count = std::min(chunkSize, n - begin);
+        engine.clipRange(segments.constData() + begin, count, window,
+                         partOut[part]);
+    });
+
+    // --- склейка в порядке входа ---
+    QVector<qsizetype> visibleAt(chunks + 1, 0);
+    QVector<qsizetype> pointsAt(chunks + 1, 0);
+    for (qsizetype c = 0; c < chunks; ++c) {
+        visibleAt[c + 1] = visibleAt[c] + parts[c].visible.size();
+        pointsAt[c + 1]  = pointsAt[c]  + parts[c].intersections.size();
+    }
+
+    result.visible.resize(visibleAt.back());
+    result.intersections.resize(pointsAt.back());
+
+    QLineF  *visibleOut = result.visible.data();
+    QPointF *pointsOut  = result.intersections.data();
+    pool.run(chunks, [&](qsizetype part, int) {
+        const SegmentClipResult &r = partOut[part];
+        std::copy(r.visible.cbegin(), r.visible.cend(),
+                  visibleOut + visibleAt.at(part));
+        std::copy(r.intersections.cbegin(), r.intersections.cend(),
+                  pointsOut + pointsAt.at(part));
+    });
+}
+
+} // namespace
+
+void clipSegmentsParallel(const QVector<QLineF> &segments,
+                          const QRectF &window,
+                          const SegmentEngine &engine,
+                          SegmentClipResult &result,
+                          WorkStealingPool &pool,
+                          qsizetype chunkSize)
+{
+    clipParallel(segments, window, engine, result, pool, chunkSize);
+}
+
+void clipSegmentsParallel(const QVector<QLineF> &segments,
+                          const ConvexWindow &window,
+                          const SegmentEngine &engine,
+                          SegmentClipResult &result,
+                          WorkStealingPool &pool,
+                          qsizetype chunkSize)
+{
+    if (window.isRect())
+        clipParallel(segments, window.boundingRect(), engine, result, pool, chunkSize);
+    else
+        clipParallel(segments, window, engine, result, pool, chunkSize);
+}
+
+} // namespace clip
@@ -0,0 +1,29 @@
+#pragma once
+#include "segmentengine.h"
+#include "threadpool.h"
+
+namespace clip {
+
+// размер части по умолчанию (отрезков)
+constexpr qsizetype kParallelChunkSize = 4096;
+
+// Параллельное отсечение набора отрезков. Вход делится на части по
+// chunkSize, части выполняются пулом с перехватом работы, каждая пишет
+// в свой буфер; затем буферы склеиваются в порядке входа, так что
+// результат совпадает с engine.clipAll() при любом числе потоков.
+void clipSegmentsParallel(const QVector<QLineF> &segments,
+                          const QRectF &window,
+                          const SegmentEngine &engine,
+                          SegmentClipResult &result,
+                          WorkStealingPool &pool = WorkStealingPool::global(),
+                          qsizetype chunkSize = kParallelChunkSize);
+
+// то же для выпуклого окна (см. SegmentEngine::clipRange)
+void clipSegmentsParallel(const QVector<QLineF> &segments,
+                          const ConvexWindow &window,
+                          const SegmentEngine &engine,
+                          SegmentClipResult &result,
+                          WorkStealingPool &pool = WorkStealingPool::global(),
+                          qsizetype chunkSize = kParallelChunkSize);
+
+} // namespace clip
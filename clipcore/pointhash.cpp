@@ -0,0 +1,80 @@
+#include "pointhash.h"
+#include <cmath>
+#include <limits>
+
+namespace clip {
+
+PointHash::PointHash(double cellSize)
+{
+    reset(cellSize);
+}
+
+void PointHash::reset(double cellSize)
+{
+    cell = cellSize > 0 ? cellSize : 1.0;
+    invCell = 1.0 / cell;
+    clear();
+}
+
+void PointHash::clear()
+{
+    count = 0;
+    cellSlots.clear();
+    buckets.clear();
+}
+
+qint32 PointHash::cellOf(double v) const
+{
+    // далёкие (и нечисловые) координаты — в крайние ячейки
+    constexpr double lo = std::numeric_limits<qint32>::min();
+    constexpr double hi = std::numeric_limits<qint32>::max();
+    const double c = std::floor(v * invCell);
+    return c >= lo && c <= hi ? qint32(c) : (c > 0 ? qint32(hi) : qint32(lo));
+}
+
+void PointHash::insert(const QPointF *points, qsizetype n)
+{
+    for (qsizetype i = 0; i < n; ++i) {
+        const QPointF &P = points[i];
+        const quint64 k = key(cellOf(P.x()), cellOf(P.y()));
+        qsizetype slot = cellSlots.value(k, -1);
+        if (slot < 0) {
+            slot = buckets.size();
+            cellSlots.insert(k, slot);
+            buckets.append(QVector<QPointF>());
+        }
+        buckets[slot].append(P);
+    }
+    count += n;
+}
+
+bool PointHash::nearest(const QPointF &P, double radius, QPointF &found) const
+{
+    if (count == 0 || !(radius > 0))
+        return false;
+
+    const qint32 cx0 = cellOf(P.x() - radius), cx1 = cellOf(P.x() + radius);
+    const qint32 cy0 = cellOf(P.y() - radius), cy1 = cellOf(P.y() + radius);
+
+    double best = radius * radius;
+    bool hit = false;
+    for (qint64 cy = cy0; cy <= cy1; ++cy) {
+        for (qint64 cx = cx0; cx <= cx1; ++cx) {
+            const qsizetype slot = cellSlots.value(key(qint32(cx), qint32(cy)), -1);
+            if (slot < 0)
+                continue;
+            for (const QPointF &Q : buckets[slot]) {
+                const double dx = Q.x() - P.x(), dy = Q.y() - P.y();
+                const double d2 = dx * dx + dy * dy;
+                if (d2 < best) {
+                    best = d2;
+                    found = Q;
+                    hit = true;
+                }
+            }
+        }
+    }
+    return hit;
+}
+
+} // namespace clip
@@ -0,0 +1,43 @@
+#pragma once
+#include <QHash>
+#include <QVector>
+#include <QPointF>
+
+namespace clip {
+
+// Пространственный хеш точек: квадратные ячейки со стороной cellSize,
+// в QHash хранятся только непустые. В отличие от GridIndex, точки можно
+// дописывать пачками без перестройки (так приходят точки фонового
+// отсечения). Поиск смотрит лишь ячейки, которые задевает круг запроса,
+// поэтому его цена зависит от числа точек рядом, а не от их общего числа.
+class PointHash
+{
+public:
+    explicit PointHash(double cellSize = 1.0);
+
+    // пустой хеш с новой стороной ячейки
+    void reset(double cellSize);
+    void clear();
+
+    void insert(const QPointF *points, qsizetype count);
+    void insert(const QVector<QPointF> &points) { insert(points.constData(), points.size()); }
+
+    qsizetype size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    // ближайшая к P точка на расстоянии меньше radius
+    bool nearest(const QPointF &P, double radius, QPointF &found) const;
+
+private:
+    qint32  cellOf(double v) const;
+    quint64 key(qint32 cx, qint32 cy) const
+    { return (quint64(quint32(cx)) << 32) | quint32(cy); }
+
+    double                    cell = 1.0;
+    double                    invCell = 1.0;
+    qsizetype                 count = 0;
+    QHash<quint64, qsizetype> cellSlots;   // ячейка -> номер в buckets
+    QVector<QVector<QPointF>> buckets;
+};
+
+} // namespace clip
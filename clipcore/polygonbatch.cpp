@@ -0,0 +1,121 @@
+#include "polygonbatch.h"
+#include "clipstats.h"
+#include "polygonclipper.h"
+#include <algorithm>
+#include <numeric>
+
+namespace clip {
+
+void PolygonSet::clear()
+{
+    vertices.clear();
+    offsets.resize(1);
+    offsets[0] = 0;
+}
+
+void PolygonSet::append(const QPointF *points, qsizetype n)
+{
+    const qsizetype at = vertices.size();
+    vertices.resize(at + n);
+    std::copy(points, points + n, vertices.data() + at);
+    offsets.append(at + n);
+}
+
+PolygonBatchClipper::PolygonBatchClipper(WorkStealingPool &pool)
+    : pool(pool)
+    , arenas(size_t(pool.threadCount()))
+{
+}
+
+void PolygonBatchClipper::clip(const PolygonSet &input, const QRectF &window,
+                               PolygonSetClipResult &result)
+{
+    clipWith(input, window, result);
+}
+
+void PolygonBatchClipper::clip(const PolygonSet &input, const ConvexWindow &window,
+                               PolygonSetClipResult &result)
+{
+    if (window.isRect())
+        clipWith(input, window.boundingRect(), result);
+    else
+        clipWith(input, window, result);
+}
+
+template<class Window>
+void PolygonBatchClipper::clipWith(const PolygonSet &input, const Window &window,
+                                   PolygonSetClipResult &result)
+{
+    CLIP_STAT_TIMER(Clip);
+    const qsizetype count = input.count();
+    QVector<qsizetype> &polygonOffsets = result.polygons.offsets;
+    QVector<qsizetype> &pointOffsets = result.intersections.offsets;
+    polygonOffsets.resize(count + 1);
+    pointOffsets.resize(count + 1);
+    polygonOffsets[0] = pointOffsets[0] = 0;
+
+    // --- части: целые многоугольники, около kPartVertices вершин ---
+    parts.clear();
+    const qsizetype *in = input.offsets.constData();
+    for (qsizetype first = 0; first < count; ) {
+        qsizetype last = first + 1;
+        while (last < count && in[last] - in[first] < kPartVertices)
+            ++last;
+        parts.append(Part { first, last });
+        first = last;
+    }
+
+    for (Arena &arena : arenas) {
+        arena.vertices.clear();
+        arena.intersections.clear();
+    }
+
+    // --- отсечение в арены; в offsets[i + 1] пока длины ---
+    Part *partData = parts.data();
+    Arena *arenaData = arenas.data();
+    qsizetype *polygonLength = polygonOffsets.data() + 1;
+    qsizetype *pointLength = pointOffsets.data() + 1;
+
+    pool.run(parts.size(), [&](qsizetype p, int worker) {
+        Part &part = partData[p];
+        Arena &arena = arenaData[worker];
+        part.arena = worker;
+        part.vertexBegin = arena.vertices.size();
+        part.intersectionBegin = arena.intersections.size();
+
+        for (qsizetype i = part.first; i < part.last; ++i) {
+            const qsizetype vertices = arena.vertices.size();
+            const qsizetype points = arena.intersections.size();
+            appendPolygonSutherlandHodgman(input.polygon(i), input.size(i), window,
+                                           arena.vertices, arena.intersections);
+            polygonLength[i] = arena.vertices.size() - vertices;
+            pointLength[i] = arena.intersections.size() - points;
+        }
+    });
+
+    // --- длины в смещения, затем участки арен — на свои места ---
+    std::partial_sum(polygonOffsets.begin(), polygonOffsets.end(), polygonOffsets.begin());
+    std::partial_sum(pointOffsets.begin(), pointOffsets.end(), pointOffsets.begin());
+    result.polygons.vertices.resize(polygonOffsets[count]);
+    result.intersections.vertices.resize(pointOffsets[count]);
+
+    QPointF *vertexOut = result.polygons.vertices.data();
+    QPointF *pointOut = result.intersections.vertices.data();
+    const qsizetype *vertexAt = polygonOffsets.constData();
+    const qsizetype *pointAt = pointOffsets.constData();
+
+    pool.run(parts.size(), [&](qsizetype p, int) {
+        const Part &part = partData[p];
+        const Arena &arena = arenaData[part.arena];
+
+        const QPointF *v = arena.vertices.constData() + part.vertexBegin;
+        std::copy(v, v + (vertexAt[part.last] - vertexAt[part.first]),
+                  vertexOut + vertexAt[part.first]);
+
+        const QPointF *q = arena.intersections.constData() + part.intersectionBegin;
+        std::copy(q, q + (pointAt[part.last] - pointAt[part.first]),
+                  pointOut + pointAt[part.first]);
+    });
+}
+
+} // namespace clip
@@ -0,0 +1,79 @@
+#pragma once
+#include "convexwindow.h"
+#include "threadpool.h"
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <vector>
+
+namespace clip {
+
+// Много многоугольников в одном буфере: вершины подряд, i-й занимает
+// [offsets[i], offsets[i + 1]). Пустые (нулевой длины) допустимы.
+struct PolygonSet
+{
+    QVector<QPointF>   vertices;
+    QVector<qsizetype> offsets { 0 };   // count() + 1
+
+    qsizetype count() const { return offsets.size() - 1; }
+    qsizetype size(qsizetype i) const { return offsets[i + 1] - offsets[i]; }
+    const QPointF *polygon(qsizetype i) const { return vertices.constData() + offsets[i]; }
+
+    void clear();
+    void append(const QPointF *points, qsizetype n);
+};
+
+// Результат пакетного отсечения: polygons[i] — отсечённый i-й многоугольник
+// (может быть пустым), intersections[i] — его точки пересечения с гранями,
+// в том же порядке, что у clipPolygonSutherlandHodgman().
+struct PolygonSetClipResult
+{
+    PolygonSet polygons;
+    PolygonSet intersections;
+};
+
+// Пакетный Сазерленд–Ходжман. Вход делится на части примерно по
+// kPartVertices вершин; части отсекаются параллельно, и каждый поток пула
+// пишет в свою арену — пару растущих буферов, которые живут между вызовами
+// и не перевыделяются при повторном отсечении. Затем длины сводятся в
+// смещения, и участки арен параллельно копируются в общие буферы
+// результата. Отдельного QVector на многоугольник нет.
+class PolygonBatchClipper
+{
+public:
+    static constexpr qsizetype kPartVertices = 1 << 15;
+
+    explicit PolygonBatchClipper(WorkStealingPool &pool = WorkStealingPool::global());
+
+    void clip(const PolygonSet &input, const QRectF &window,
+              PolygonSetClipResult &result);
+
+    // выпуклое окно; прямоугольное — тем же путём, что выше
+    void clip(const PolygonSet &input, const ConvexWindow &window,
+              PolygonSetClipResult &result);
+
+private:
+    template<class Window>
+    void clipWith(const PolygonSet &input, const Window &window,
+                  PolygonSetClipResult &result);
+
+    struct Arena
+    {
+        QVector<QPointF> vertices;
+        QVector<QPointF> intersections;
+    };
+
+    // часть входа и где лежит её результат
+    struct Part
+    {
+        qsizetype first, last;             // многоугольники [first, last)
+        int       arena = 0;
+        qsizetype vertexBegin = 0, intersectionBegin = 0;
+    };
+
+    WorkStealingPool  &pool;
+    std::vector<Arena> arenas;             // по потоку пула
+    QVector<Part>      parts;
+};
+
+} // namespace clip
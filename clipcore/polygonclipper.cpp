@@ -0,0 +1,212 @@
+#include "polygonclipper.h"
+#include "clipstats.h"
+#include "qtpointtraits.h"
+#include <QVarLengthArray>
+#include <type_traits>
+
+namespace clip {
+
+namespace {
+
+// Прямоугольное окно — конвейер стадий из genericclipper.h для QPointF;
+// вершины по стадиям считаются, только если собраны счётчики
+using StageCounter = std::conditional_t<kStatsEnabled, generic::Count, generic::NoCount>;
+using RectChain = generic::RectPipeline<QPointF, QVector<QPointF>, QVector<QPointF>,
+                                        StageCounter>;
+
+void countStages(const RectChain &chain)
+{
+    CLIP_STAT_ADD(ShLeftIn, chain.left.count());
+    CLIP_STAT_ADD(ShRightIn, chain.right.count());
+    CLIP_STAT_ADD(ShBottomIn, chain.bottom.count());
+    CLIP_STAT_ADD(ShTopIn, chain.top.count());
+    CLIP_STAT_ADD(ShOut, chain.sink.received.value());
+}
+
+// Конвейер для выпуклого окна: те же стадии, но грань — элемент массива,
+// а не параметр шаблона (число граней известно только во время работы).
+// Стадия k передаёт вершины стадии k + 1, последняя — в out.
+class ConvexChain
+{
+public:
+    ConvexChain(const ConvexWindow &window, QVector<QPointF> &out,
+                QVector<QPointF> &intersections)
+        : planes(window.planes().constData()),
+          stages(window.edgeCount()),
+          out(out), intersections(intersections) {}
+
+    void push(const QPointF &P) { push(0, P); }
+
+    void close()
+    {
+        for (int k = 0; k < stages.size(); ++k) {
+            const Stage &s = stages[k];
+            if (s.hasFirst)
+                edge(k, s.prev, s.prevDistance, s.first, s.firstDistance);
+        }
+        received.flush(StatCounter::ShConvexIn);
+        emitted.flush(StatCounter::ShOut);
+    }
+
+private:
+    struct Stage
+    {
+        QPointF first, prev;
+        double firstDistance = 0.0, prevDistance = 0.0;
+        bool hasFirst = false;
+    };
+
+    void push(int k, const QPointF &P)
+    {
+        if (k == stages.size()) {
+            emitted.add();
+            out.append(P);
+            return;
+        }
+        received.add();
+
+        Stage &s = stages[k];
+        const double distance = planes[k].distance(P);
+        if (!s.hasFirst) {
+            s.first = P;
+            s.firstDistance = distance;
+            s.hasFirst = true;
+        } else {
+            edge(k, s.prev, s.prevDistance, P, distance);
+        }
+        s.prev = P;
+        s.prevDistance = distance;
+    }
+
+    // ребро SP относительно грани k; расстояния со знаком, >= 0 — внутри
+    void edge(int k, QPointF S, double ds, QPointF P, double dp)
+    {
+        const bool Sin = ds >= 0.0, Pin = dp >= 0.0;
+        if (Sin && Pin) {
+            push(k + 1, P);
+        } else if (Sin != Pin) {
+            const double t = ds / (ds - dp);
+            const QPointF I(S.x() + t * (P.x() - S.x()), S.y() + t * (P.y() - S.y()));
+            intersections.append(I);
+            push(k + 1, I);
+            if (Pin)
+                push(k + 1, P);
+        }
+    }
+
+    const ConvexWindow::Plane *planes;
+    QVarLengthArray<Stage, kMaxInlineEdges> stages;
+    QVector<QPointF> &out;
+    QVector<QPointF> &intersections;
+    StatTally received, emitted;
+};
+
+} // namespace
+
+void clipPolygonSutherlandHodgman(const QVector<QPointF> &polygon,
+                                  const QRectF &window,
+                                  PolygonClipResult &result)
+{
+    clipPolygonSutherlandHodgman(polygon.constData(), polygon.size(),
+                                 window, result);
+}
+
+void clipPolygonSutherlandHodgman(const QPointF *polygon,
+                                  qsizetype count,
+                                  const QRectF &window,
+                                  PolygonClipResult &result)
+{
+    CLIP_STAT_TIMER(Clip);
+    result.polygon.clear();
+    result.intersections.clear();
+    appendPolygonSutherlandHodgman(polygon, count, window,
+                                   result.polygon, result.intersections);
+}
+
+void appendPolygonSutherlandHodgman(const QPointF *polygon,
+                                    qsizetype count,
+                                    const QRectF &window,
+                                    QVector<QPointF> &outPolygon,
+                                    QVector<QPointF> &outIntersections)
+{
+    RectChain chain(generic::boxOf(window), outPolygon, outIntersections);
+    for (qsizetype i = 0; i < count; ++i)
+        chain.push(polygon[i]);
+    chain.close();
+    countStages(chain);
+}
+
+void clipPolygonSutherlandHodgman(const QVector<QPointF> &polygon,
+                                  const ConvexWindow &window,
+                                  PolygonClipResult &result)
+{
+    clipPolygonSutherlandHodgman(polygon.constData(), polygon.size(),
+                                 window, result);
+}
+
+void clipPolygonSutherlandHodgman(const QPointF *polygon,
+                                  qsizetype count,
+                                  const ConvexWindow &window,
+                                  PolygonClipResult &result)
+{
+    CLIP_STAT_TIMER(Clip);
+    result.polygon.clear();
+    result.intersections.clear();
+    appendPolygonSutherlandHodgman(polygon, count, window,
+                                   result.polygon, result.intersections);
+}
+
+void appendPolygonSutherlandHodgman(const QPointF *polygon,
+                                    qsizetype count,
+                                    const ConvexWindow &window,
+                                    QVector<QPointF> &outPolygon,
+                                    QVector<QPointF> &outIntersections)
+{
+    if (window.isRect()) {
+        appendPolygonSutherlandHodgman(polygon, count, window.boundingRect(),
+                                       outPolygon, outIntersections);
+        return;
+    }
+
+    ConvexChain chain(window, outPolygon, outIntersections);
+    for (qsizetype i = 0; i < count; ++i)
+        chain.push(polygon[i]);
+    chain.close();
+}
+
+// ---------- потоковый вариант ----------
+
+struct PolygonStreamClipper::Chain
+{
+    explicit Chain(const QRectF &window)
+        : stages(generic::boxOf(window), result.polygon, result.intersections) {}
+
+    PolygonClipResult result;
+    RectChain stages;
+};
+
+PolygonStreamClipper::PolygonStreamClipper(const QRectF &window)
+    : chain(std::make_unique<Chain>(window))
+{
+}
+
+PolygonStreamClipper::~PolygonStreamClipper() = default;
+
+void PolygonStreamClipper::push(const QPointF *points, qsizetype count)
+{
+    for (qsizetype i = 0; i < count; ++i)
+        chain->stages.push(points[i]);
+}
+
+void PolygonStreamClipper::finish()
+{
+    chain->stages.close();
+    countStages(chain->stages);
+}
+
+PolygonClipResult &PolygonStreamClipper::output()
+{
+    return chain->result;
+}
+
+} // namespace clip
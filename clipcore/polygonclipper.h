@@ -0,0 +1,87 @@
+#pragma once
+#include "convexwindow.h"
+#include "genericclipper.h"
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <memory>
+
+namespace clip {
+
+// Результат отсечения многоугольника. Буферы можно переиспользовать:
+// повторное отсечение в тот же результат не выделяет память, если
+// ёмкости хватает (clear() в Qt 6 сохраняет ёмкость неразделённого QVector).
+struct PolygonClipResult
+{
+    QVector<QPointF> polygon;        // отсечённый многоугольник
+    QVector<QPointF> intersections;  // точки пересечения со всеми гранями
+};
+
+// === Сазерленд–Ходжман ===
+
+// Потоковый (конвейерный) вариант: каждая вершина сразу проходит все
+// четыре стадии-грани, грань — параметр шаблона, промежуточных
+// многоугольников нет. Вершины результата идут в том же порядке, что и
+// при последовательном отсечении гранями Left, Right, Bottom, Top.
+void clipPolygonSutherlandHodgman(const QVector<QPointF> &polygon,
+                                  const QRectF &window,
+                                  PolygonClipResult &result);
+
+void clipPolygonSutherlandHodgman(const QPointF *polygon,
+                                  qsizetype count,
+                                  const QRectF &window,
+                                  PolygonClipResult &result);
+
+// то же, но вершины и точки пересечения дописываются в конец outPolygon
+// и outIntersections (для многих многоугольников в общих буферах)
+void appendPolygonSutherlandHodgman(const QPointF *polygon,
+                                    qsizetype count,
+                                    const QRectF &window,
+                                    QVector<QPointF> &outPolygon,
+                                    QVector<QPointF> &outIntersections);
+
+// Выпуклое окно. Прямоугольное (window.isRect()) отсекается конвейером
+// выше; иное — таким же конвейером, где стадии-грани — элементы массива
+// с заранее вычисленными нормалями: промежуточных многоугольников тоже нет,
+// а при числе граней до kMaxInlineEdges нет и выделения памяти.
+constexpr int kMaxInlineEdges = 16;
+
+void clipPolygonSutherlandHodgman(const QVector<QPointF> &polygon,
+                                  const ConvexWindow &window,
+                                  PolygonClipResult &result);
+
+void clipPolygonSutherlandHodgman(const QPointF *polygon,
+                                  qsizetype count,
+                                  const ConvexWindow &window,
+                                  PolygonClipResult &result);
+
+void appendPolygonSutherlandHodgman(const QPointF *polygon,
+                                    qsizetype count,
+                                    const ConvexWindow &window,
+                                    QVector<QPointF> &outPolygon,
+                                    QVector<QPointF> &outIntersections);
+
+// Тот же конвейер для многоугольника, не помещающегося в память: вершины
+// подаются порциями через push(), finish() замыкает контур. Вершины и точки
+// пересечения копятся в output(); между порциями их можно забрать и
+// очистить, тогда память не растёт.
+class PolygonStreamClipper
+{
+public:
+    explicit PolygonStreamClipper(const QRectF &window);
+    ~PolygonStreamClipper();
+
+    PolygonStreamClipper(const PolygonStreamClipper &) = delete;
+    PolygonStreamClipper &operator=(const PolygonStreamClipper &) = delete;
+
+    void push(const QPointF *points, qsizetype count);
+    void finish();
+
+    PolygonClipResult &output();
+
+private:
+    struct Chain;
+    std::unique_ptr<Chain> chain;
+};
+
+} // namespace clip
@@ -0,0 +1,235 @@
+#include "polylineclipper.h"
+#include "clipstats.h"
+#include "qtpointtraits.h"
+#include <algorithm>
+
+namespace clip {
+
+void PolylineClipResult::clear()
+{
+    chains.clear();
+    source.clear();
+    intersections.clear();
+}
+
+namespace {
+
+// Прямоугольное окно: код — биты внешних граней, как у Коэна–Сазерленда.
+struct RectRegion
+{
+    const QRectF &window;
+
+    using Code = unsigned;
+
+    Code code(const QPointF &P) const
+    {
+        Code c = 0;
+        if (P.x() < window.left())
+            c |= 1;
+        else if (P.x() > window.right())
+            c |= 2;
+        if (P.y() < window.top())
+            c |= 4;
+        else if (P.y() > window.bottom())
+            c |= 8;
+        return c;
+    }
+
+    // оба конца за одной гранью
+    static bool sameSide(Code a, Code b) { return (a & b) != 0; }
+
+    // видимый участок [t0, t1] ребра AB (Лианг–Барски); false — не виден
+    bool clip(const QPointF &A, const QPointF &B, double &t0, double &t1) const
+    {
+        const double dx = B.x() - A.x();
+        const double dy = B.y() - A.y();
+        const double p[4] = { -dx, dx, -dy, dy };
+        const double q[4] = { A.x() - window.left(),  window.right()  - A.x(),
+                              A.y() - window.top(),   window.bottom() - A.y() };
+
+        t0 = 0.0;
+        t1 = 1.0;
+        for (int i = 0; i < 4; ++i) {
+            if (p[i] == 0.0) {
+                if (q[i] < 0.0)
+                    return false;
+            } else {
+                const double r = q[i] / p[i];
+                if (p[i] < 0.0)
+                    t0 = std::max(t0, r);
+                else
+                    t1 = std::min(t1, r);
+            }
+        }
+        return t0 <= t1;
+    }
+};
+
+// Выпуклое окно: код — биты граней, с внешней стороны которых лежит точка.
+// У граней с номера 63 общий бит kOther; по нему ребро не отбрасывается.
+struct ConvexRegion
+{
+    const ConvexWindow &window;
+
+    using Code = quint64;
+    static constexpr Code kOther = Code(1) << 63;
+
+    Code code(const QPointF &P) const
+    {
+        Code c = 0;
+        const QVector<ConvexWindow::Plane> &planes = window.planes();
+        for (qsizetype i = 0; i < planes.size(); ++i) {
+            if (planes[i].distance(P) < 0.0)
+                c |= i < 63 ? Code(1) << i : kOther;
+        }
+        return c;
+    }
+
+    static bool sameSide(Code a, Code b) { return (a & b & ~kOther) != 0; }
+
+    // Кирус–Бек
+    bool clip(const QPointF &A, const QPointF &B, double &t0, double &t1) const
+    {
+        const double dx = B.x() - A.x();
+        const double dy = B.y() - A.y();
+
+        t0 = 0.0;
+        t1 = 1.0;
+        for (const ConvexWindow::Plane &plane : window.planes()) {
+            const double num = plane.distance(A);
+            const double den = plane.nx * dx + plane.ny * dy;
+            if (den == 0.0) {
+                if (num < 0.0)
+                    return false;
+            } else {
+                const double r = -num / den;
+                if (den > 0.0)
+                    t0 = std::max(t0, r);
+                else
+                    t1 = std::min(t1, r);
+                if (t0 > t1)
+                    return false;
+            }
+        }
+        return true;
+    }
+};
+
+template<class Region>
+void clipChains(const PolylineSet &input, const Region &region, PolylineClipResult &result)
+{
+    CLIP_STAT_TIMER(Clip);
+    result.clear();
+    PolylineSet &out = result.chains;
+    QVector<QPointF> &v = out.vertices;
+    v.reserve(input.vertices.size());
+
+    StatTally accepts, rejects, fragments;
+
+    // начало открытой подцепочки в v; -1 — подцепочка закрыта
+    qsizetype open = -1;
+    auto begin = [&](const QPointF &P) {
+        open = v.size();
+        v.append(P);
+    };
+    // подцепочка из одной точки (касание окна) не выводится
+    auto close = [&](qsizetype chain) {
+        if (open < 0)
+            return;
+        const qsizetype n = v.size() - open;
+        if (n < 2 || (n == 2 && generic::length2(v[open], v[open + 1]) < kMinLength2)) {
+            v.resize(open);
+        } else {
+            out.offsets.append(v.size());
+            result.source.append(chain);
+            fragments.add();
+        }
+        open = -1;
+    };
+
+    for (qsizetype c = 0; c < input.count(); ++c) {
+        const QPointF *p = input.polygon(c);
+        const qsizetype n = input.size(c);
+        if (n == 0)
+            continue;
+
+        typename Region::Code codeA = region.code(p[0]);
+        if (codeA == 0)
+            begin(p[0]);
+
+        for (qsizetype i = 1; i < n; ++i) {
+            const QPointF &A = p[i - 1];
+            const QPointF &B = p[i];
+            const typename Region::Code codeB = region.code(B);
+
+            if ((codeA | codeB) == 0) {
+                // целиком внутри: подцепочка продолжается вершиной B
+                accepts.add();
+                if (open < 0)
+                    begin(A);
+                v.append(B);
+            } else if (Region::sameSide(codeA, codeB)) {
+                rejects.add();
+                close(c);
+            } else {
+                double t0, t1;
+                if (!region.clip(A, B, t0, t1)) {
+                    close(c);
+                } else {
+                    // вершина внутри окна — конец участка, без погрешности t
+                    if (codeA == 0)
+                        t0 = 0.0;
+                    if (codeB == 0)
+                        t1 = 1.0;
+                    const QPointF d = B - A;
+                    if (t0 > 0.0) {
+                        // вход в окно
+                        close(c);
+                        const QPointF P = A + t0 * d;
+                        begin(P);
+                        result.intersections.append(P);
+                    } else if (open < 0) {
+                        begin(A);
+                    }
+                    if (t1 < 1.0) {
+                        // выход из окна
+                        const QPointF Q = A + t1 * d;
+                        v.append(Q);
+                        result.intersections.append(Q);
+                        close(c);
+                    } else {
+                        v.append(B);
+                    }
+                }
+            }
+            codeA = codeB;
+        }
+        close(c);
+    }
+
+    accepts.flush(StatCounter::TrivialAccepts);
+    rejects.flush(StatCounter::TrivialRejects);
+    fragments.flush(StatCounter::FragmentsEmitted);
+    CLIP_STAT_ADD(IntersectionPoints, result.intersections.size());
+}
+
+} // namespace
+
+void clipPolylines(const PolylineSet &input,
+                   const QRectF &window,
+                   PolylineClipResult &result)
+{
+    clipChains(input, RectRegion { window }, result);
+}
+
+void clipPolylines(const PolylineSet &input,
+                   const ConvexWindow &window,
+                   PolylineClipResult &result)
+{
+    if (window.isRect())
+        clipChains(input, RectRegion { window.boundingRect() }, result);
+    else
+        clipChains(input, ConvexRegion { window }, result);
+}
+
+} // namespace clip
@@ -0,0 +1,45 @@
+#pragma once
+#include "convexwindow.h"
+#include "polygonbatch.h"
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+namespace clip {
+
+// Ломаные (связные цепочки отрезков) в одном буфере вершин — так же, как
+// многоугольники в PolygonSet: i-я цепочка занимает [offsets[i],
+// offsets[i + 1]). Цепочка не замкнута: ребра от последней вершины к
+// первой нет. Общая вершина соседних рёбер хранится один раз.
+using PolylineSet = PolygonSet;
+
+// Результат отсечения ломаных: видимые подцепочки — диапазоны одного
+// буфера вершин chains, source[j] — номер исходной цепочки j-й подцепочки.
+// Ломаная, несколько раз входящая в окно, даёт несколько подцепочек.
+struct PolylineClipResult
+{
+    PolylineSet        chains;
+    QVector<qsizetype> source;
+    QVector<QPointF>   intersections;  // точки входа в окно и выхода из него
+
+    void clear();
+};
+
+// Каждая цепочка проходится один раз. Положение вершины относительно окна
+// (код Коэна–Сазерленда, у выпуклого окна — набор внешних граней)
+// вычисляется один раз и служит обоим её рёбрам. Ребро целиком внутри
+// лишь дописывает в подцепочку свою конечную вершину, ребро за одной
+// гранью отбрасывается без вычислений, остальные отсекаются
+// параметрически (Лианг–Барски, у выпуклого окна — Кирус–Бек). Выход из
+// окна закрывает подцепочку, вход открывает новую. Результат
+// перезаписывается; буферы result переиспользуются.
+void clipPolylines(const PolylineSet &input,
+                   const QRectF &window,
+                   PolylineClipResult &result);
+
+// выпуклое окно; прямоугольное (window.isRect()) — как выше
+void clipPolylines(const PolylineSet &input,
+                   const ConvexWindow &window,
+                   PolylineClipResult &result);
+
+} // namespace clip
@@ -0,0 +1,29 @@
+#pragma once
+#include "genericclipper.h"
+#include <QPointF>
+#include <QRectF>
+
+namespace clip {
+
+namespace generic {
+
+// QPointF для шаблонов genericclipper.h
+template<>
+struct PointTraits<QPointF>
+{
+    using Coord = qreal;
+    static qreal x(const QPointF &p) { return p.x(); }
+    static qreal y(const QPointF &p) { return p.y(); }
+    static QPointF make(qreal x, qreal y) { return QPointF(x, y); }
+};
+
+// окно clipcore: QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax)),
+// т.е. top() — ymin
+inline Box<qreal> boxOf(const QRectF &window)
+{
+    return Box<qreal> { window.left(), window.top(), window.right(), window.bottom() };
+}
+
+} // namespace generic
+
+} // namespace clip
@@ -0,0 +1,596 @@
+#include "resultexport.h"
+#include "bufferedwriter.h"
+#include "threadpool.h"
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+namespace clip {
+
+namespace {
+
+// Элементов в блоке форматирования. В SVG блок — это и отдельный <path>:
+// очень длинный атрибут d плохо переносят просмотрщики.
+constexpr qsizetype kFormatBlockItems = 1 << 14;
+
+// верхние оценки длины строк
+constexpr qsizetype kPointChars   = 2 * kNumberChars + 2;
+constexpr qsizetype kSegmentChars = 4 * kNumberChars + 6;
+constexpr qsizetype kCountChars   = kNumberChars + 1;
+
+bool fail(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+// Отрезки и точки пересечения перебираются по номерам источника: у
+// incremental это номера всех его отрезков, и часть из них пропускается.
+qsizetype segmentSource(const ExportScene &scene)
+{
+    return scene.incremental ? scene.incremental->size() : scene.segmentCount;
+}
+
+bool segmentAt(const ExportScene &scene, qsizetype i, QLineF &s)
+{
+    if (scene.incremental)
+        return scene.incremental->visible(i, s);
+    if (scene.segments) {
+        s = scene.segments[i];
+    } else {
+        const SegmentColumns &c = scene.columns;
+        s = QLineF(c.x1[i], c.y1[i], c.x2[i], c.y2[i]);
+    }
+    return true;
+}
+
+bool hasPoints(const ExportScene &scene)
+{
+    return scene.points || scene.incremental;
+}
+
+qsizetype pointSource(const ExportScene &scene)
+{
+    return scene.incremental ? scene.incremental->size() : scene.pointCount;
+}
+
+// не больше стольких точек на номер источника
+int pointsPerSource(const ExportScene &scene)
+{
+    return scene.incremental ? 4 : 1;
+}
+
+int pointsAt(const ExportScene &scene, qsizetype i, const QPointF *&points)
+{
+    if (scene.incremental)
+        return scene.incremental->intersections(i, points);
+    points = scene.points + i;
+    return 1;
+}
+
+// Элементы [0, count) набираются блоками по kFormatBlockItems: блоки
+// форматируются параллельно в пуле, каждый в свой буфер, и пишутся по
+// порядку, по два на поток за раз. Форматирование чисел заметно дороже
+// самой записи, так что иначе вывод упирался бы в одно ядро.
+// chars(begin, end) — верхняя оценка длины блока, format(p, begin, end)
+// набирает его с p и возвращает конец.
+template<class Chars, class Format>
+void putBlocks(WorkStealingPool &pool, BufferedWriter &out, qsizetype count,
+               Chars chars, Format format)
+{
+    const qsizetype blocks = (count + kFormatBlockItems - 1) / kFormatBlockItems;
+    const qsizetype round = std::min<qsizetype>(2 * pool.threadCount(), blocks);
+    if (round == 0)
+        return;
+
+    QVector<QByteArray> text(round);
+    QVector<qsizetype> length(round);
+    QByteArray *buffers = text.data();
+    qsizetype *lengths = length.data();
+
+    for (qsizetype first = 0; first < blocks && out.ok(); first += round) {
+        const qsizetype n = std::min(round, blocks - first);
+        pool.run(n, [&](qsizetype part, int) {
+            const qsizetype begin = (first + part) * kFormatBlockItems;
+            const qsizetype end = std::min(begin + kFormatBlockItems, count);
+            QByteArray &buffer = buffers[part];
+            buffer.resize(chars(begin, end));
+            lengths[part] = format(buffer.data(), begin, end) - buffer.constData();
+        });
+        for (qsizetype part = 0; part < n; ++part)
+            out.write(buffers[part].constData(), lengths[part]);
+    }
+}
+
+// ---------- текст ----------
+
+inline char *pointLine(char *p, const QPointF &v)
+{
+    p = writeNumber(p, v.x()); *p++ = ' ';
+    p = writeNumber(p, v.y()); *p++ = '\n';
+    return p;
+}
+
+// строка "x1 y1   x2 y2", как у saveSegmentScene
+inline char *segmentLine(char *p, const QLineF &s)
+{
+    p = writeNumber(p, s.x1()); *p++ = ' ';
+    p = writeNumber(p, s.y1()); *p++ = ' '; *p++ = ' '; *p++ = ' ';
+    p = writeNumber(p, s.x2()); *p++ = ' ';
+    p = writeNumber(p, s.y2()); *p++ = '\n';
+    return p;
+}
+
+inline char *countLine(char *p, qsizetype n)
+{
+    p = std::to_chars(p, p + kNumberChars, qint64(n)).ptr;
+    *p++ = '\n';
+    return p;
+}
+
+// n, затем n строк "x y"
+void putPoints(WorkStealingPool &pool, BufferedWriter &out, const QPointF *points, qsizetype n)
+{
+    out.putInteger(n);
+    out.put('\n');
+    putBlocks(pool, out, n,
+              [](qsizetype begin, qsizetype end) { return (end - begin) * kPointChars; },
+              [points](char *p, qsizetype begin, qsizetype end) {
+                  for (qsizetype i = begin; i < end; ++i)
+                      p = pointLine(p, points[i]);
+                  return p;
+              });
+}
+
+void putWindow(WorkStealingPool &pool, BufferedWriter &out, const ExportScene &scene)
+{
+    if (!scene.windowPolygon.isEmpty()) {
+        putPoints(pool, out, scene.windowPolygon.constData(), scene.windowPolygon.size());
+        return;
+    }
+    const QRectF &w = scene.window;
+    out.putNumber(w.left());   out.put(' ');
+    out.putNumber(w.top());    out.put(' ');
+    out.putNumber(w.right());  out.put(' ');
+    out.putNumber(w.bottom()); out.put('\n');
+}
+
+bool writeText(const QString &fileName, const ExportScene &scene, WorkStealingPool &pool,
+               const std::atomic_bool *cancel, QString *error)
+{
+    if (scene.kind == SceneKind::Unknown)
+        return fail(error, fileName + ": нет результата для записи");
+
+    BufferedWriter out;
+    out.setCancelFlag(cancel);
+    if (!out.open(fileName))
+        return fail(error, fileName + ": не удалось открыть файл для записи");
+
+    switch (scene.kind) {
+    case SceneKind::Segments:
+        out.putInteger(scene.segmentCount);
+        out.put('\n');
+        putBlocks(pool, out, segmentSource(scene),
+                  [](qsizetype begin, qsizetype end) { return (end - begin) * kSegmentChars; },
+                  [&scene](char *p, qsizetype begin, qsizetype end) {
+                      QLineF s;
+                      for (qsizetype i = begin; i < end; ++i) {
+                          if (segmentAt(scene, i, s))
+                              p = segmentLine(p, s);
+                      }
+                      return p;
+                  });
+        break;
+    case SceneKind::Polygon:
+        putPoints(pool, out, scene.vertices, scene.vertexCount);
+        break;
+    case SceneKind::MultiPolygon:
+    case SceneKind::Polyline: {
+        // метка, число наборов, затем каждый набор: n и n строк "x y"
+        out.put(scene.kind == SceneKind::MultiPolygon ? 'P' : 'L');
+        out.put(' ');
+        out.putInteger(scene.setCount);
+        out.put('\n');
+        const qsizetype *offsets = scene.offsets;
+        putBlocks(pool, out, scene.setCount,
+                  [offsets](qsizetype begin, qsizetype end) {
+                      return (offsets[end] - offsets[begin]) * kPointChars +
+                             (end - begin) * kCountChars;
+                  },
+                  [&scene, offsets](char *p, qsizetype begin, qsizetype end) {
+                      for (qsizetype k = begin; k < end; ++k) {
+                          p = countLine(p, offsets[k + 1] - offsets[k]);
+                          for (qsizetype i = offsets[k]; i < offsets[k + 1]; ++i)
+                              p = pointLine(p, scene.vertices[i]);
+                      }
+                      return p;
+                  });
+        break;
+    }
+    case SceneKind::Unknown:
+        break;
+    }
+    putWindow(pool, out, scene);
+
+    if (!out.finish())
+        return fail(error, fileName + ": не удалось записать файл");
+    return true;
+}
+
+// ---------- двоичный формат ----------
+
+bool writeBinary(const QString &fileName, const ExportScene &scene,
+                 ColumnPrecision precision, const std::atomic_bool *cancel, QString *error)
+{
+    if (!scene.windowPolygon.isEmpty())
+        return fail(error, fileName + ": окно-многоугольник в двоичном формате не хранится");
+
+    bool ok = false;
+    switch (scene.kind) {
+    case SceneKind::Segments:
+        if (scene.incremental) {
+            // номера видимых частей — вместо копии самих частей
+            QVector<quint32> ids;
+            scene.incremental->visibleIds(ids);
+            ok = writeBinarySegments(fileName, scene.incremental->fragmentData(),
+                                     ids.constData(), ids.size(), scene.window, precision,
+                                     cancel);
+        } else if (scene.segments) {
+            ok = writeBinarySegments(fileName, scene.segments, scene.segmentCount,
+                                     scene.window, precision, cancel);
+        } else {
+            SegmentColumns columns = scene.columns;
+            columns.count = scene.segmentCount;
+            ok = writeBinarySegments(fileName, columns, scene.window, precision, cancel);
+        }
+        break;
+    case SceneKind::Polygon:
+        ok = writeBinaryPolygon(fileName, scene.vertices, scene.vertexCount,
+                                scene.window, precision, cancel);
+        break;
+    case SceneKind::MultiPolygon:
+        return fail(error, fileName + ": несколько многоугольников в двоичном "
+                                      "формате не хранятся");
+    case SceneKind::Polyline:
+        return fail(error, fileName + ": ломаные в двоичном формате не хранятся");
+    case SceneKind::Unknown:
+        return fail(error, fileName + ": нет результата для записи");
+    }
+
+    if (!ok)
+        return fail(error, fileName + ": не удалось записать файл");
+    return true;
+}
+
+// ---------- SVG ----------
+
+// Координаты пишутся как есть, только Y с обратным знаком: в SVG она
+// направлена вниз. Толщина линий задана в пикселях (non-scaling-stroke)
+// и не зависит от масштаба сцены.
+inline char *svgPoint(char *p, char command, const QPointF &v)
+{
+    *p++ = command;
+    p = writeNumber(p, v.x()); *p++ = ' ';
+    return writeNumber(p, 0.0 - v.y());   // без "-0"
+}
+
+// у SVG пары после M без буквы — уже отрезки к ним
+inline char *svgChain(char *p, const QPointF *v, qsizetype n, bool closed)
+{
+    p = svgPoint(p, 'M', v[0]);
+    for (qsizetype i = 1; i < n; ++i)
+        p = svgPoint(p, ' ', v[i]);
+    if (closed)
+        *p++ = 'Z';
+    return p;
+}
+
+// элементы [0, count) — блоками, каждый блок — <path> вида style
+template<class Chars, class Format>
+void putSvgPaths(WorkStealingPool &pool, BufferedWriter &out, const char *style,
+                 qsizetype count, Chars chars, Format format)
+{
+    QByteArray head("<path ");
+    head.append(style);
+    head.append(" vector-effect=\"non-scaling-stroke\" d=\"");
+    static constexpr char tail[] = "\"/>\n";
+    constexpr qsizetype tailChars = sizeof tail - 1;
+
+    putBlocks(pool, out, count,
+              [&](qsizetype begin, qsizetype end) {
+                  return head.size() + chars(begin, end) + tailChars;
+              },
+              [&](char *p, qsizetype begin, qsizetype end) {
+                  std::memcpy(p, head.constData(), size_t(head.size()));
+                  char *q = format(p + head.size(), begin, end);
+                  if (q == p + head.size())
+                      return p;   // в блоке всё пропущено — без пустого <path>
+                  std::memcpy(q, tail, tailChars);
+                  return q + tailChars;
+              });
+}
+
+// как на холсте: окно синим, отрезки и ломаные красным, многоугольник
+// зелёным с заливкой; точки — цветом точек своего режима
+constexpr const char *kSvgWindowStyle =
+    "fill=\"none\" stroke=\"#0000ff\" stroke-width=\"2\"";
+constexpr const char *kSvgLineStyle =
+    "fill=\"none\" stroke=\"#ff0000\" stroke-width=\"2\" stroke-linejoin=\"round\"";
+constexpr const char *kSvgPolygonStyle =
+    "fill=\"#009600\" fill-opacity=\"0.16\" stroke=\"#009600\" stroke-width=\"3\"";
+constexpr const char *kSvgLinePointStyle =
+    "fill=\"none\" stroke=\"#ff7878\" stroke-opacity=\"0.7\" stroke-width=\"10\" "
+    "stroke-linecap=\"round\"";
+constexpr const char *kSvgPolygonPointStyle =
+    "fill=\"none\" stroke=\"#7896ff\" stroke-opacity=\"0.78\" stroke-width=\"10\" "
+    "stroke-linecap=\"round\"";
+
+bool writeSvg(const QString &fileName, const ExportScene &scene, WorkStealingPool &pool,
+              const std::atomic_bool *cancel, QString *error)
+{
+    if (scene.kind == SceneKind::Unknown)
+        return fail(error, fileName + ": нет результата для записи");
+
+    BufferedWriter out;
+    out.setCancelFlag(cancel);
+    if (!out.open(fileName))
+        return fail(error, fileName + ": не удалось открыть файл для записи");
+
+    // область рисунка — окно с полями в 5 %
+    const QRectF &w = scene.window;
+    double margin = 0.05 * std::max(w.width(), w.height());
+    if (margin <= 0.0)
+        margin = 1.0;
+    out.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+              "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"");
+    out.putNumber(w.left() - margin);               out.put(' ');
+    out.putNumber(0.0 - (w.bottom() + margin));     out.put(' ');
+    out.putNumber(w.width() + 2 * margin);          out.put(' ');
+    out.putNumber(w.height() + 2 * margin);
+    out.write("\">\n");
+
+    // окно
+    const QVector<QPointF> window = scene.windowPolygon.isEmpty()
+        ? QVector<QPointF> { w.topLeft(), w.topRight(), w.bottomRight(), w.bottomLeft() }
+        : scene.windowPolygon;
+    putSvgPaths(pool, out, kSvgWindowStyle, 1,
+                [&window](qsizetype, qsizetype) { return window.size() * kPointChars + 1; },
+                [&window](char *p, qsizetype, qsizetype) {
+                    return svgChain(p, window.constData(), window.size(), true);
+                });
+
+    // результат
+    const bool polygons = scene.kind == SceneKind::Polygon ||
+                          scene.kind == SceneKind::MultiPolygon;
+    const char *style = polygons ? kSvgPolygonStyle : kSvgLineStyle;
+    switch (scene.kind) {
+    case SceneKind::Segments:
+        putSvgPaths(pool, out, style, segmentSource(scene),
+                    [](qsizetype begin, qsizetype end) { return (end - begin) * 2 * kPointChars; },
+                    [&scene](char *p, qsizetype begin, qsizetype end) {
+                        QLineF s;
+                        for (qsizetype i = begin; i < end; ++i) {
+                            if (!segmentAt(scene, i, s))
+                                continue;
+                            p = svgPoint(p, 'M', s.p1());
+                            p = svgPoint(p, ' ', s.p2());
+                        }
+                        return p;
+                    });
+        break;
+    case SceneKind::Polygon:
+        if (scene.vertexCount > 0)
+            putSvgPaths(pool, out, style, 1,
+                        [&scene](qsizetype, qsizetype) { return scene.vertexCount * kPointChars + 1; },
+                        [&scene](char *p, qsizetype, qsizetype) {
+                            return svgChain(p, scene.vertices, scene.vertexCount, true);
+                        });
+        break;
+    case SceneKind::MultiPolygon:
+    case SceneKind::Polyline: {
+        const qsizetype *offsets = scene.offsets;
+        putSvgPaths(pool, out, style, scene.setCount,
+                    [offsets](qsizetype begin, qsizetype end) {
+                        return (offsets[end] - offsets[begin]) * kPointChars + (end - begin);
+                    },
+                    [&scene, offsets, polygons](char *p, qsizetype begin, qsizetype end) {
+                        for (qsizetype k = begin; k < end; ++k) {
+                            const qsizetype n = offsets[k + 1] - offsets[k];
+                            if (n > 0)
+                                p = svgChain(p, scene.vertices + offsets[k], n, polygons);
+                        }
+                        return p;
+                    });
+        break;
+    }
+    case SceneKind::Unknown:
+        break;
+    }
+
+    // точки пересечения — подпути нулевой длины с круглым концом
+    if (hasPoints(scene)) {
+        const qsizetype perSource = pointsPerSource(scene);
+        putSvgPaths(pool, out, polygons ? kSvgPolygonPointStyle : kSvgLinePointStyle,
+                    pointSource(scene),
+                    [perSource](qsizetype begin, qsizetype end) {
+                        return (end - begin) * perSource * (kPointChars + 2);
+                    },
+                    [&scene](char *p, qsizetype begin, qsizetype end) {
+                        const QPointF *points;
+                        for (qsizetype i = begin; i < end; ++i) {
+                            const int n = pointsAt(scene, i, points);
+                            for (int k = 0; k < n; ++k) {
+                                p = svgPoint(p, 'M', points[k]);
+                                *p++ = 'h';
+                                *p++ = '0';
+                            }
+                        }
+                        return p;
+                    });
+    }
+
+    out.write("</svg>\n");
+    if (!out.finish())
+        return fail(error, fileName + ": не удалось записать файл");
+    return true;
+}
+
+bool writePointsFile(const QString &fileName, const ExportScene &scene,
+                     WorkStealingPool &pool, const std::atomic_bool *cancel, QString *error)
+{
+    BufferedWriter out;
+    out.setCancelFlag(cancel);
+    if (!out.open(fileName))
+        return fail(error, fileName + ": не удалось открыть файл для записи");
+    out.putInteger(scene.pointCount);
+    out.put('\n');
+    const qsizetype perSource = pointsPerSource(scene);
+    putBlocks(pool, out, pointSource(scene),
+              [perSource](qsizetype begin, qsizetype end) {
+                  return (end - begin) * perSource * kPointChars;
+              },
+              [&scene](char *p, qsizetype begin, qsizetype end) {
+                  const QPointF *points;
+                  for (qsizetype i = begin; i < end; ++i) {
+                      const int n = pointsAt(scene, i, points);
+                      for (int k = 0; k < n; ++k)
+                          p = pointLine(p, points[k]);
+                  }
+                  return p;
+              });
+    if (!out.finish())
+        return fail(error, fileName + ": не удалось записать файл");
+    return true;
+}
+
+} // namespace
+
+QStringList exportFormatNames()
+{
+    return { "text", "binary", "svg" };
+}
+
+bool exportFormatFromName(const QString &name, ExportFormat &format)
+{
+    const QString n = name.toLower();
+    if (n == "text" || n == "txt")
+        format = ExportFormat::Text;
+    else if (n == "binary" || n == "scb")
+        format = ExportFormat::Binary;
+    else if (n == "svg")
+        format = ExportFormat::Svg;
+    else
+        return false;
+    return true;
+}
+
+QString exportSuffix(ExportFormat format)
+{
+    switch (format) {
+    case ExportFormat::Binary: return ".scb";
+    case ExportFormat::Svg:    return ".svg";
+    case ExportFormat::Text:   break;
+    }
+    return ".txt";
+}
+
+ExportFormat exportFormatForFile(const QString &fileName)
+{
+    ExportFormat format = ExportFormat::Text;
+    exportFormatFromName(QFileInfo(fileName).suffix(), format);
+    return format;
+}
+
+QString exportPointsFileName(const QString &fileName)
+{
+    const QFileInfo fi(fileName);
+    return QDir(fi.path()).filePath(fi.completeBaseName() + ".points.txt");
+}
+
+ExportScene exportSegments(const QVector<QLineF> &visible)
+{
+    ExportScene scene;
+    scene.kind = SceneKind::Segments;
+    scene.segments = visible.constData();
+    scene.segmentCount = visible.size();
+    return scene;
+}
+
+ExportScene exportSegments(const SegmentColumns &visible)
+{
+    ExportScene scene;
+    scene.kind = SceneKind::Segments;
+    scene.columns = visible;
+    scene.segmentCount = visible.count;
+    return scene;
+}
+
+ExportScene exportSegments(const IncrementalClipper &clipper)
+{
+    ExportScene scene;
+    scene.kind = SceneKind::Segments;
+    scene.incremental = &clipper;
+    scene.segmentCount = clipper.visibleCount();
+    scene.pointCount = clipper.intersectionCount();
+    return scene;
+}
+
+ExportScene exportPolygon(const QVector<QPointF> &polygon)
+{
+    ExportScene scene;
+    scene.kind = SceneKind::Polygon;
+    scene.vertices = polygon.constData();
+    scene.vertexCount = polygon.size();
+    return scene;
+}
+
+ExportScene exportPointSets(SceneKind kind, const PolygonSet &sets)
+{
+    ExportScene scene;
+    scene.kind = kind;
+    scene.vertices = sets.vertices.constData();
+    scene.vertexCount = sets.vertices.size();
+    scene.offsets = sets.offsets.constData();
+    scene.setCount = sets.count();
+    return scene;
+}
+
+bool exportScene(const QString &fileName,
+                 ExportFormat format,
+                 const ExportScene &scene,
+                 QString *error,
+                 ColumnPrecision precision,
+                 WorkStealingPool &pool,
+                 const std::atomic_bool *cancel)
+{
+    bool ok = false;
+    switch (format) {
+    case ExportFormat::Text:
+        ok = writeText(fileName, scene, pool, cancel, error);
+        break;
+    case ExportFormat::Binary:
+        ok = writeBinary(fileName, scene, precision, cancel, error);
+        break;
+    case ExportFormat::Svg:
+        // точки уже в рисунке
+        ok = writeSvg(fileName, scene, pool, cancel, error);
+        break;
+    }
+
+    const bool pointsFile = format != ExportFormat::Svg && hasPoints(scene);
+    if (ok && pointsFile)
+        ok = writePointsFile(exportPointsFileName(fileName), scene, pool, cancel, error);
+
+    // прервана — не остаётся ни одного из файлов, даже уже дописанного
+    if (cancel && *cancel) {
+        QFile::remove(fileName);
+        if (pointsFile)
+            QFile::remove(exportPointsFileName(fileName));
+        return fail(error, fileName + ": запись отменена");
+    }
+    return ok;
+}
+
+} // namespace clip
@@ -0,0 +1,81 @@
+#pragma once
+#include "binaryformat.h"
+#include "clipio.h"
+#include "incrementalclipper.h"
+#include "threadpool.h"
+#include <QString>
+#include <QStringList>
+
+namespace clip {
+
+// Форматы экспорта результата отсечения:
+//   text   — тот же текстовый формат, что и на входе (clipio.h);
+//   binary — *.scb (binaryformat.h), только отрезки и один многоугольник
+//            с прямоугольным окном;
+//   svg    — окно, результат и точки пересечения слоями; Y направлена вверх,
+//            как на холсте.
+enum class ExportFormat { Text, Binary, Svg };
+
+// имена для командной строки: text, binary, svg
+QStringList exportFormatNames();
+bool exportFormatFromName(const QString &name, ExportFormat &format);
+
+// ".txt", ".scb", ".svg"
+QString exportSuffix(ExportFormat format);
+// по расширению имени файла; неизвестное — text
+ExportFormat exportFormatForFile(const QString &fileName);
+
+// Результат отсечения для записи — указатели на буферы клиппера, без копий.
+// Заполняется то, что соответствует kind:
+//   Segments     — segments (segmentCount), столбцы columns или
+//                  incremental: видимые части и точки пересечения берутся
+//                  прямо из клиппера, с пропуском невидимых отрезков
+//                  (segmentCount и pointCount — сколько будет записано);
+//   Polygon      — vertices (vertexCount);
+//   MultiPolygon, Polyline — vertices и offsets (setCount + 1 смещений,
+//                  как у PolygonSet).
+// points — точки пересечения; nullptr (и нет incremental) — не записываются.
+struct ExportScene
+{
+    SceneKind        kind = SceneKind::Unknown;
+    const QLineF    *segments = nullptr;
+    SegmentColumns   columns;
+    const IncrementalClipper *incremental = nullptr;
+    qsizetype        segmentCount = 0;
+    const QPointF   *vertices = nullptr;
+    qsizetype        vertexCount = 0;
+    const qsizetype *offsets = nullptr;
+    qsizetype        setCount = 0;
+    const QPointF   *points = nullptr;
+    qsizetype        pointCount = 0;
+    QRectF           window;
+    QVector<QPointF> windowPolygon;   // пусто — окно-прямоугольник window
+};
+
+// заполнение ExportScene по буферам результата (окно задаётся отдельно)
+ExportScene exportSegments(const QVector<QLineF> &visible);
+ExportScene exportSegments(const SegmentColumns &visible);
+ExportScene exportSegments(const IncrementalClipper &clipper);   // с точками
+ExportScene exportPolygon(const QVector<QPointF> &polygon);
+ExportScene exportPointSets(SceneKind kind, const PolygonSet &sets);
+
+// Запись в fileName через BufferedWriter. Текст и SVG набираются блоками
+// параллельно в pool и пишутся по порядку, двоичные столбцы переводятся
+// прямо в буфер записи. Точкам пересечения в текстовом
+// и двоичном формате места нет, они пишутся рядом, в <имя>.points.txt:
+// n, затем n строк "x y".
+// При ошибке в error (если задан) — причина. Поднятый cancel прерывает
+// запись между блоками: записанные файлы удаляются, результат — false
+// с причиной «запись отменена».
+bool exportScene(const QString &fileName,
+                 ExportFormat format,
+                 const ExportScene &scene,
+                 QString *error = nullptr,
+                 ColumnPrecision precision = ColumnPrecision::Float64,
+                 WorkStealingPool &pool = WorkStealingPool::global(),
+                 const std::atomic_bool *cancel = nullptr);
+
+// имя файла с точками пересечения для fileName
+QString exportPointsFileName(const QString &fileName);
+
+} // namespace clip
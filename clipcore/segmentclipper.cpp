@@ -0,0 +1,262 @@
+#include "segmentclipper.h"
+#include "clipstats.h"
+#include "qtpointtraits.h"
+#include <algorithm>
+
+namespace clip {
+
+namespace {
+
+inline double length2(const QPointF &A, const QPointF &B)
+{
+    return generic::length2(A, B);
+}
+
+} // namespace
+
+// ---------- логические проверки ----------
+
+bool pointInside(const QPointF &P, const QRectF &window)
+{
+    return generic::pointInside(P, generic::boxOf(window));
+}
+
+bool segOutside(const QPointF &A, const QPointF &B, const QRectF &window)
+{
+    return generic::segOutside(A, B, generic::boxOf(window));
+}
+
+// ---------- Алгоритм средней точки ----------
+
+void clipMidpoint(const QPointF &A,
+                  const QPointF &B,
+                  const QRectF &window,
+                  QVector<QLineF> &outLines)
+{
+    QPointF start, end;
+    generic::MidpointTrace trace;
+    const bool visible = generic::clipMidpoint(A, B, generic::boxOf(window), start, end,
+                                               kStatsEnabled ? &trace : nullptr);
+
+    CLIP_STAT_ADD(MidpointCalls, 1);
+    CLIP_STAT_ADD(TrivialRejects, trace.trivialReject);
+    CLIP_STAT_ADD(TrivialAccepts, trace.trivialAccept);
+    CLIP_STAT_ADD(MidpointSplits, trace.splits);
+    CLIP_STAT_MAX(MidpointMaxDepth, trace.maxDepth);
+    CLIP_STAT_ADD(BoundarySteps, trace.boundarySteps);
+
+    if (!visible)
+        return;
+
+    CLIP_STAT_ADD(FragmentsEmitted, 1);
+    outLines.append(QLineF(start, end));
+}
+
+// ---------- Коэн–Сазерленд ----------
+
+namespace {
+
+enum Outcode {
+    CodeInside = 0,
+    CodeLeft   = 1,
+    CodeRight  = 2,
+    CodeBottom = 4,   // y < window.top()
+    CodeTop    = 8    // y > window.bottom()
+};
+
+int outcode(const QPointF &P, const QRectF &window)
+{
+    int code = CodeInside;
+    if (P.x() < window.left())        code |= CodeLeft;
+    else if (P.x() > window.right())  code |= CodeRight;
+    if (P.y() < window.top())         code |= CodeBottom;
+    else if (P.y() > window.bottom()) code |= CodeTop;
+    return code;
+}
+
+} // namespace
+
+void clipCohenSutherland(const QPointF &A,
+                         const QPointF &B,
+                         const QRectF &window,
+                         QVector<QLineF> &outLines)
+{
+    if (length2(A, B) < kMinLength2)
+        return;
+
+    QPointF P = A, Q = B;
+    int codeP = outcode(P, window);
+    int codeQ = outcode(Q, window);
+    if (!(codeP | codeQ))
+        CLIP_STAT_ADD(TrivialAccepts, 1);
+    else if (codeP & codeQ)
+        CLIP_STAT_ADD(TrivialRejects, 1);
+
+    for (;;) {
+        if (!(codeP | codeQ))
+            break;              // оба конца внутри
+        if (codeP & codeQ)
+            return;             // оба по одну сторону от окна
+
+        // переносим внешний конец на границу
+        const int code = codeP ? codeP : codeQ;
+        const double dx = Q.x() - P.x();
+        const double dy = Q.y() - P.y();
+        QPointF I;
+
+        if (code & CodeTop) {
+            const double y = window.bottom();
+            I = QPointF(P.x() + dx * (y - P.y()) / dy, y);
+        } else if (code & CodeBottom) {
+            const double y = window.top();
+            I = QPointF(P.x() + dx * (y - P.y()) / dy, y);
+        } else if (code & CodeRight) {
+            const double x = window.right();
+            I = QPointF(x, P.y() + dy * (x - P.x()) / dx);
+        } else {
+            const double x = window.left();
+            I = QPointF(x, P.y() + dy * (x - P.x()) / dx);
+        }
+
+        if (code == codeP) {
+            P = I;
+            codeP = outcode(P, window);
+        } else {
+            Q = I;
+            codeQ = outcode(Q, window);
+        }
+    }
+
+    if (length2(P, Q) < kMinLength2)
+        return;
+
+    CLIP_STAT_ADD(FragmentsEmitted, 1);
+    outLines.append(QLineF(P, Q));
+}
+
+// ---------- Лианг–Барски ----------
+
+void clipLiangBarsky(const QPointF &A,
+                     const QPointF &B,
+                     const QRectF &window,
+                     QVector<QLineF> &outLines)
+{
+    if (length2(A, B) < kMinLength2)
+        return;
+
+    const double dx = B.x() - A.x();
+    const double dy = B.y() - A.y();
+
+    // p * t <= q для каждой из четырёх граней
+    const double p[4] = { -dx, dx, -dy, dy };
+    const double q[4] = { A.x() - window.left(),  window.right()  - A.x(),
+                          A.y() - window.top(),   window.bottom() - A.y() };
+
+    double t0 = 0.0, t1 = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0)
+                return;         // параллелен грани и снаружи
+        } else {
+            const double r = q[i] / p[i];
+            if (p[i] < 0.0)
+                t0 = std::max(t0, r);   // вход
+            else
+                t1 = std::min(t1, r);   // выход
+        }
+    }
+
+    if (t0 > t1)
+        return;
+
+    const QPointF P(A.x() + t0 * dx, A.y() + t0 * dy);
+    const QPointF Q(A.x() + t1 * dx, A.y() + t1 * dy);
+    if (length2(P, Q) < kMinLength2)
+        return;
+
+    CLIP_STAT_ADD(FragmentsEmitted, 1);
+    outLines.append(QLineF(P, Q));
+}
+
+// ---------- Кирус–Бек ----------
+
+void clipCyrusBeck(const QPointF &A,
+                   const QPointF &B,
+                   const ConvexWindow &window,
+                   QVector<QLineF> &outLines)
+{
+    if (length2(A, B) < kMinLength2)
+        return;
+
+    const double dx = B.x() - A.x();
+    const double dy = B.y() - A.y();
+
+    // внутри грани: n·(A + t·D) >= d, т.е. num + t * den >= 0
+    double t0 = 0.0, t1 = 1.0;
+    for (const ConvexWindow::Plane &plane : window.planes()) {
+        const double num = plane.distance(A);
+        const double den = plane.nx * dx + plane.ny * dy;
+        if (den == 0.0) {
+            if (num < 0.0)
+                return;         // параллелен грани и снаружи
+        } else {
+            const double r = -num / den;
+            if (den > 0.0)
+                t0 = std::max(t0, r);   // вход
+            else
+                t1 = std::min(t1, r);   // выход
+            if (t0 > t1)
+                return;
+        }
+    }
+
+    const QPointF P(A.x() + t0 * dx, A.y() + t0 * dy);
+    const QPointF Q(A.x() + t1 * dx, A.y() + t1 * dy);
+    if (length2(P, Q) < kMinLength2)
+        return;
+
+    CLIP_STAT_ADD(FragmentsEmitted, 1);
+    outLines.append(QLineF(P, Q));
+}
+
+// ---------- точки пересечения с гранями ----------
+
+QVector<QPointF> findRealIntersections(const QPointF &A,
+                                       const QPointF &B,
+                                       const QRectF &window)
+{
+    QVector<QPointF> pts;
+    appendRealIntersections(A, B, window, pts);
+    return pts;
+}
+
+void appendRealIntersections(const QPointF &A,
+                             const QPointF &B,
+                             const QRectF &window,
+                             QVector<QPointF> &out)
+{
+    const int found = generic::appendRealIntersections(A, B, generic::boxOf(window), out);
+
+    CLIP_STAT_ADD(IntersectionTests, 1);
+    CLIP_STAT_ADD(IntersectionPoints, found);
+}
+
+void appendRealIntersections(const QPointF &A,
+                             const QPointF &B,
+                             const ConvexWindow &window,
+                             QVector<QPointF> &out)
+{
+    const QLineF segment(A, B);
+    const QVector<QPointF> &v = window.vertices();
+    const qsizetype before = out.size();
+    for (qsizetype i = 0; i < v.size(); ++i) {
+        QPointF ip;
+        if (segment.intersects(QLineF(v[i], v[(i + 1) % v.size()]), &ip)
+                == QLineF::BoundedIntersection)
+            out.append(ip);
+    }
+    CLIP_STAT_ADD(IntersectionTests, 1);
+    CLIP_STAT_ADD(IntersectionPoints, out.size() - before);
+}
+
+} // namespace clip
@@ -0,0 +1,71 @@
+#pragma once
+#include "convexwindow.h"
+#include "genericclipper.h"
+#include <QVector>
+#include <QLineF>
+#include <QRectF>
+
+namespace clip {
+
+// Результат отсечения набора отрезков
+struct SegmentClipResult
+{
+    QVector<QLineF>  visible;        // видимые части
+    QVector<QPointF> intersections;  // реальные точки пересечения с границей окна
+};
+
+// окно задаётся как QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax)),
+// т.е. top() — нижняя граница (Y вверх), bottom() — верхняя
+
+bool pointInside(const QPointF &P, const QRectF &window);
+
+// полностью вне окна: обе точки по одну сторону
+bool segOutside(const QPointF &A, const QPointF &B, const QRectF &window);
+
+// === Алгоритм средней точки ===
+// Без рекурсии: делением пополам ищется точка внутри окна, затем двоичным
+// поиском уточняются обе границы видимого участка. Окно выпуклое, поэтому
+// видимая часть одна, и в outLines добавляется не более одного отрезка.
+void clipMidpoint(const QPointF &A,
+                  const QPointF &B,
+                  const QRectF &window,
+                  QVector<QLineF> &outLines);
+
+// === Коэн–Сазерленд (коды концов) ===
+void clipCohenSutherland(const QPointF &A,
+                         const QPointF &B,
+                         const QRectF &window,
+                         QVector<QLineF> &outLines);
+
+// === Лианг–Барски (параметрический) ===
+void clipLiangBarsky(const QPointF &A,
+                     const QPointF &B,
+                     const QRectF &window,
+                     QVector<QLineF> &outLines);
+
+// === Кирус–Бек (выпуклое окно) ===
+// Тот же параметрический подход, что у Лианга–Барски, но по нормалям и
+// смещениям граней, заранее вычисленным в ConvexWindow.
+void clipCyrusBeck(const QPointF &A,
+                   const QPointF &B,
+                   const ConvexWindow &window,
+                   QVector<QLineF> &outLines);
+
+// точки пересечения отрезка AB с гранями окна
+QVector<QPointF> findRealIntersections(const QPointF &A,
+                                       const QPointF &B,
+                                       const QRectF &window);
+
+// то же без отдельного вектора на отрезок: точки дописываются в out
+void appendRealIntersections(const QPointF &A,
+                             const QPointF &B,
+                             const QRectF &window,
+                             QVector<QPointF> &out);
+
+// то же для выпуклого окна (грани по порядку вершин); точки дописываются в out
+void appendRealIntersections(const QPointF &A,
+                             const QPointF &B,
+                             const ConvexWindow &window,
+                             QVector<QPointF> &out);
+
+} // namespace clip
@@ -0,0 +1,162 @@
+#include "segmentengine.h"
+#include "batchclipper.h"
+#include "clipstats.h"
+
+namespace clip {
+
+void SegmentEngine::clipAll(const QVector<QLineF> &segments,
+                            const QRectF &window,
+                            SegmentClipResult &result) const
+{
+    result.visible.clear();
+    result.intersections.clear();
+    clipRange(segments.constData(), segments.size(), window, result);
+}
+
+void SegmentEngine::clipRange(const QLineF *segments,
+                              qsizetype count,
+                              const QRectF &window,
+                              SegmentClipResult &result) const
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        const QLineF &s = segments[i];
+
+        // --- добавляем реальные точки пересечения ---
+        appendRealIntersections(s.p1(), s.p2(), window, result.intersections);
+
+        // --- запускаем выбранный алгоритм ---
+        clip(s.p1(), s.p2(), window, result.visible);
+    }
+}
+
+void SegmentEngine::clipAll(const QVector<QLineF> &segments,
+                            const ConvexWindow &window,
+                            SegmentClipResult &result) const
+{
+    result.visible.clear();
+    result.intersections.clear();
+    clipRange(segments.constData(), segments.size(), window, result);
+}
+
+void SegmentEngine::clipRange(const QLineF *segments,
+                              qsizetype count,
+                              const ConvexWindow &window,
+                              SegmentClipResult &result) const
+{
+    if (window.isRect()) {
+        clipRange(segments, count, window.boundingRect(), result);
+        return;
+    }
+
+    for (qsizetype i = 0; i < count; ++i) {
+        const QLineF &s = segments[i];
+        appendRealIntersections(s.p1(), s.p2(), window, result.intersections);
+        clipCyrusBeck(s.p1(), s.p2(), window, result.visible);
+    }
+}
+
+namespace {
+
+class MidpointEngine : public SegmentEngine
+{
+public:
+    SegmentAlgorithm algorithm() const override
+    { return SegmentAlgorithm::Midpoint; }
+
+    void clip(const QPointF &A, const QPointF &B, const QRectF &window,
+              QVector<QLineF> &outLines) const override
+    { clipMidpoint(A, B, window, outLines); }
+};
+
+class CohenSutherlandEngine : public SegmentEngine
+{
+public:
+    SegmentAlgorithm algorithm() const override
+    { return SegmentAlgorithm::CohenSutherland; }
+
+    void clip(const QPointF &A, const QPointF &B, const QRectF &window,
+              QVector<QLineF> &outLines) const override
+    { clipCohenSutherland(A, B, window, outLines); }
+};
+
+class LiangBarskyEngine : public SegmentEngine
+{
+public:
+    SegmentAlgorithm algorithm() const override
+    { return SegmentAlgorithm::LiangBarsky; }
+
+    void clip(const QPointF &A, const QPointF &B, const QRectF &window,
+              QVector<QLineF> &outLines) const override
+    { clipLiangBarsky(A, B, window, outLines); }
+
+    using SegmentEngine::clipRange;
+
+    // видимые части считаются пакетным SIMD-ядром по структуре массивов
+    void clipRange(const QLineF *segments, qsizetype count,
+                   const QRectF &window,
+                   SegmentClipResult &result) const override
+    {
+        const SegmentArrays in = SegmentArrays::fromLines(segments, count);
+        SegmentArrays out;
+        QVector<quint8> mask;
+        clipLiangBarskyBatch(in.columns(), window, out, mask);
+        const qsizetype visibleBefore = result.visible.size();
+
+        for (qsizetype i = 0; i < count; ++i) {
+            appendRealIntersections(segments[i].p1(), segments[i].p2(), window,
+                                    result.intersections);
+
+            if (mask[i])
+                result.visible.append(QLineF(out.x1[i], out.y1[i],
+                                             out.x2[i], out.y2[i]));
+        }
+        CLIP_STAT_ADD(FragmentsEmitted, result.visible.size() - visibleBefore);
+    }
+};
+
+} // namespace
+
+std::unique_ptr<SegmentEngine> createSegmentEngine(SegmentAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case SegmentAlgorithm::Midpoint:
+        return std::make_unique<MidpointEngine>();
+    case SegmentAlgorithm::CohenSutherland:
+        return std::make_unique<CohenSutherlandEngine>();
+    case SegmentAlgorithm::LiangBarsky:
+        return std::make_unique<LiangBarskyEngine>();
+    }
+    return std::make_unique<MidpointEngine>();
+}
+
+QString segmentAlgorithmName(SegmentAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case SegmentAlgorithm::Midpoint:        return "midpoint";
+    case SegmentAlgorithm::CohenSutherland: return "cohen-sutherland";
+    case SegmentAlgorithm::LiangBarsky:     return "liang-barsky";
+    }
+    return QString();
+}
+
+bool segmentAlgorithmFromName(const QString &name, SegmentAlgorithm &algorithm)
+{
+    for (SegmentAlgorithm a : { SegmentAlgorithm::Midpoint,
+                                SegmentAlgorithm::CohenSutherland,
+                                SegmentAlgorithm::LiangBarsky }) {
+        if (segmentAlgorithmName(a) == name) {
+            algorithm = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList segmentAlgorithmNames()
+{
+    return QStringList() << segmentAlgorithmName(SegmentAlgorithm::Midpoint)
+                         << segmentAlgorithmName(SegmentAlgorithm::CohenSutherland)
+                         << segmentAlgorithmName(SegmentAlgorithm::LiangBarsky);
+}
+
+} // namespace clip
@@ -0,0 +1,58 @@
+#pragma once
+#include "segmentclipper.h"
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+namespace clip {
+
+// алгоритмы отсечения отрезков, выбираемые во время работы
+enum class SegmentAlgorithm { Midpoint, CohenSutherland, LiangBarsky };
+
+// Стратегия отсечения отрезков. Все реализации дают одинаковую видимую
+// часть (с точностью kBoundaryEps2 у средней точки) и не более одного
+// отрезка на каждый входной.
+class SegmentEngine
+{
+public:
+    virtual ~SegmentEngine() = default;
+
+    virtual SegmentAlgorithm algorithm() const = 0;
+
+    // видимая часть AB дописывается в outLines
+    virtual void clip(const QPointF &A,
+                      const QPointF &B,
+                      const QRectF &window,
+                      QVector<QLineF> &outLines) const = 0;
+
+    // весь набор отрезков: видимые части и точки пересечения с окном
+    void clipAll(const QVector<QLineF> &segments,
+                 const QRectF &window,
+                 SegmentClipResult &result) const;
+
+    // count отрезков начиная с segments; результат дописывается в result
+    virtual void clipRange(const QLineF *segments,
+                           qsizetype count,
+                           const QRectF &window,
+                           SegmentClipResult &result) const;
+
+    // То же для выпуклого окна. Прямоугольное окно (window.isRect())
+    // отсекается этим алгоритмом, как выше; иное — Кирусом–Беком.
+    void clipAll(const QVector<QLineF> &segments,
+                 const ConvexWindow &window,
+                 SegmentClipResult &result) const;
+
+    void clipRange(const QLineF *segments,
+                   qsizetype count,
+                   const ConvexWindow &window,
+                   SegmentClipResult &result) const;
+};
+
+std::unique_ptr<SegmentEngine> createSegmentEngine(SegmentAlgorithm algorithm);
+
+// имена для командной строки: midpoint, cohen-sutherland, liang-barsky
+QString segmentAlgorithmName(SegmentAlgorithm algorithm);
+bool segmentAlgorithmFromName(const QString &name, SegmentAlgorithm &algorithm);
+QStringList segmentAlgorithmNames();
+
+} // namespace clip
@@ -0,0 +1,583 @@
+#include "streamclipper.h"
+#include "binaryformat.h"
+#include "bufferedwriter.h"
+#include "parallelclipper.h"
+#include "polygonclipper.h"
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace clip {
+
+namespace {
+
+// блок чтения текста и место под количество в начале результата
+constexpr qint64 kReadBlockBytes = 4 << 20;
+constexpr int    kCountFieldWidth = 20;
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// ---------- канал между потоками ----------
+
+// Очередь буферов между стадиями. Её длина ограничена числом буферов,
+// которые ходят по кругу (по два на вход и на выход), а не самой очередью.
+template<class T>
+class Channel
+{
+public:
+    void push(T &&value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(std::move(value));
+        }
+        ready.notify_one();
+    }
+
+    // false — канал закрыт и пуст
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        value = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<T> items;
+    bool closed = false;
+};
+
+// ---------- отрезки и вершины ----------
+
+template<class Item> struct ItemTraits;
+
+template<> struct ItemTraits<QLineF>
+{
+    static constexpr int values = 4;
+    static QLineF make(const double *v) { return QLineF(v[0], v[1], v[2], v[3]); }
+};
+
+template<> struct ItemTraits<QPointF>
+{
+    static constexpr int values = 2;
+    static QPointF make(const double *v) { return QPointF(v[0], v[1]); }
+};
+
+// ---------- текст порциями ----------
+
+// Числа текстового файла по порциям, без чтения файла целиком.
+// В буфере разбираются только числа до последнего пробельного символа,
+// хвост (возможно, обрезанное число) переносится в начало при дочитывании.
+class TextNumberStream
+{
+public:
+    bool open(const QString &fileName, ParseError &error)
+    {
+        file.setFileName(fileName);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = ParseError { 0, 0, QString("не удалось открыть файл") };
+            return false;
+        }
+        if (!refill())
+            return false;
+        if (buffer.size() >= 3 && std::memcmp(buffer.constData(), "\xEF\xBB\xBF", 3) == 0)
+            pos = scanned = lineStart = 3;
+        return true;
+    }
+
+    // до max чисел в out; меньше max — конец файла, -1 — ошибка
+    qsizetype read(double *out, qsizetype max, ParseError &error)
+    {
+        qsizetype n = 0;
+        while (n < max) {
+            const char *data = buffer.constData();
+            while (pos < safeEnd && isSpace(data[pos]))
+                ++pos;
+            if (pos == safeEnd) {
+                if (eof)
+                    return n;
+                if (!refill())
+                    return -1;
+                continue;
+            }
+
+            const char *token = data + pos;
+            const char *p = token + (*token == '+');   // from_chars не принимает '+'
+            const char *end = data + safeEnd;
+            const std::from_chars_result r = std::from_chars(p, end, out[n]);
+            if (r.ec != std::errc() || (r.ptr != end && !isSpace(*r.ptr)) ||
+                !std::isfinite(out[n])) {
+                const char *tokenEnd = token;
+                while (tokenEnd < end && !isSpace(*tokenEnd))
+                    ++tokenEnd;
+                error = errorAt(token - data, QString("неверное число \"%1\"")
+                                    .arg(QString::fromUtf8(token, tokenEnd - token)));
+                return -1;
+            }
+            pos = r.ptr - data;
+            ++n;
+        }
+        return n;
+    }
+
+    ParseError errorAtEnd(const QString &message)
+    {
+        return errorAt(buffer.size(), message);
+    }
+
+private:
+    // дочитать блок; начало буфера до pos отбрасывается
+    bool refill()
+    {
+        countLines(pos);
+        buffer.remove(0, pos);
+        bufferOffset += pos;
+        scanned -= pos;
+        pos = 0;
+
+        const qsizetype kept = buffer.size();
+        buffer.resize(kept + kReadBlockBytes);
+        const qint64 got = file.read(buffer.data() + kept, kReadBlockBytes);
+        buffer.resize(kept + std::max<qint64>(got, 0));
+        eof = got <= 0;
+
+        safeEnd = buffer.size();
+        if (!eof) {
+            while (safeEnd > 0 && !isSpace(buffer.at(safeEnd - 1)))
+                --safeEnd;
+        }
+        return true;
+    }
+
+    // строки считаются лениво: только в отбрасываемой части и при ошибке
+    void countLines(qsizetype upTo)
+    {
+        const char *data = buffer.constData();
+        const char *p = data + scanned;
+        const char *end = data + upTo;
+        while (const char *nl = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)))) {
+            ++line;
+            lineStart = bufferOffset + (nl + 1 - data);
+            p = nl + 1;
+        }
+        scanned = upTo;
+    }
+
+    ParseError errorAt(qsizetype at, const QString &message)
+    {
+        countLines(at);
+        return ParseError { line, bufferOffset + at - lineStart + 1, message };
+    }
+
+    QFile      file;
+    QByteArray buffer;
+    qsizetype  pos = 0;          // следующий неразобранный байт
+    qsizetype  safeEnd = 0;      // конец разбираемой части буфера
+    qsizetype  scanned = 0;      // до сюда переводы строки уже сосчитаны
+    qint64     bufferOffset = 0; // смещение buffer[0] в файле
+    qint64     line = 1;
+    qint64     lineStart = 0;    // смещение начала текущей строки в файле
+    bool       eof = false;
+};
+
+// ---------- чтение порций ----------
+
+template<class Item>
+class ItemReader
+{
+public:
+    virtual ~ItemReader() = default;
+
+    // следующая порция (пустая — вход кончился); false — ошибка
+    virtual bool read(QVector<Item> &chunk, qsizetype max, ParseError &error) = 0;
+};
+
+template<class Item>
+class TextItemReader : public ItemReader<Item>
+{
+public:
+    TextItemReader(TextNumberStream &text, qint64 count)
+        : text(text), count(count) {}
+
+    bool read(QVector<Item> &chunk, qsizetype max, ParseError &error) override
+    {
+        constexpr int k = ItemTraits<Item>::values;
+        const qsizetype want = qsizetype(std::min<qint64>(max, count - done));
+        numbers.resize(want * k);
+
+        const qsizetype got = text.read(numbers.data(), want * k, error);
+        if (got < 0)
+            return false;
+        if (got < want * k) {
+            const qint64 need = 1 + count * k;
+            error = text.errorAtEnd(QString("ожидалось %1 чисел, в файле %2")
+                                        .arg(need).arg(1 + done * k + got));
+            return false;
+        }
+
+        chunk.resize(want);
+        for (qsizetype i = 0; i < want; ++i)
+            chunk[i] = ItemTraits<Item>::make(numbers.constData() + i * k);
+        done += want;
+        return true;
+    }
+
+private:
+    TextNumberStream &text;
+    const qint64 count;
+    qint64 done = 0;
+    QVector<double> numbers;
+};
+
+template<class Item>
+class BinaryItemReader : public ItemReader<Item>
+{
+public:
+    BinaryItemReader(QFile &file, const BinaryHeader &header)
+        : file(file), header(header) {}
+
+    bool read(QVector<Item> &chunk, qsizetype max, ParseError &error) override
+    {
+        constexpr int k = ItemTraits<Item>::values;
+        const qsizetype want = qsizetype(std::min<qint64>(max, qint64(header.count) - done));
+        const qint64 bytes = qint64(want) * header.precision;
+
+        for (int c = 0; c < k; ++c) {
+            columns[c].resize(bytes);
+            if (!file.seek(qint64(header.columnOffset[c]) + done * header.precision) ||
+                file.read(columns[c].data(), bytes) != bytes) {
+                error = ParseError { 0, 0, QString("ошибка чтения столбцов") };
+                return false;
+            }
+        }
+
+        chunk.resize(want);
+        double v[4];
+        for (qsizetype i = 0; i < want; ++i) {
+            for (int c = 0; c < k; ++c)
+                v[c] = value(c, i);
+            chunk[i] = ItemTraits<Item>::make(v);
+        }
+        done += want;
+        return true;
+    }
+
+private:
+    double value(int c, qsizetype i) const
+    {
+        const char *p = columns[c].constData();
+        if (header.precision == quint32(ColumnPrecision::Float32)) {
+            float f;
+            std::memcpy(&f, p + i * 4, 4);
+            return f;
+        }
+        double d;
+        std::memcpy(&d, p + i * 8, 8);
+        return d;
+    }
+
+    QFile &file;
+    const BinaryHeader &header;
+    qint64 done = 0;
+    QByteArray columns[4];
+};
+
+// ---------- запись результата ----------
+
+inline char *writeItem(char *p, const QLineF &s)
+{
+    p = writeNumber(p, s.x1()); *p++ = ' ';
+    p = writeNumber(p, s.y1()); *p++ = ' '; *p++ = ' '; *p++ = ' ';
+    p = writeNumber(p, s.x2()); *p++ = ' ';
+    p = writeNumber(p, s.y2()); *p++ = '\n';
+    return p;
+}
+
+inline char *writeItem(char *p, const QPointF &v)
+{
+    p = writeNumber(p, v.x()); *p++ = ' ';
+    p = writeNumber(p, v.y()); *p++ = '\n';
+    return p;
+}
+
+class TextSceneWriter
+{
+public:
+    bool open(const QString &fileName)
+    {
+        if (!out.open(fileName))
+            return false;
+        // место под количество, заполняется в finish()
+        QByteArray field(kCountFieldWidth, ' ');
+        field.append('\n');
+        out.write(field);
+        return out.ok();
+    }
+
+    // строки набираются прямо в буфере записи, без промежуточного текста
+    template<class Item>
+    bool write(const QVector<Item> &items)
+    {
+        constexpr qsizetype lineChars = ItemTraits<Item>::values * (kNumberChars + 3);
+        for (const Item &item : items)
+            out.commit(writeItem(out.reserve(lineChars), item));
+        return out.ok();
+    }
+
+    bool finish(qint64 count, const QRectF &window)
+    {
+        out.putNumber(window.left());   out.put(' ');
+        out.putNumber(window.top());    out.put(' ');
+        out.putNumber(window.right());  out.put(' ');
+        out.putNumber(window.bottom()); out.put('\n');
+
+        const QByteArray n = QByteArray::number(count);
+        return out.rewrite(0, n.constData(), n.size()) && out.finish();
+    }
+
+private:
+    BufferedWriter out;
+};
+
+// ---------- конвейер ----------
+
+// Чтение (отдельный поток) -> отсечение (вызывающий поток и пул) ->
+// запись (отдельный поток). По каждому каналу ходят два буфера.
+// clipChunk(in, out) отсекает порцию в out; flush(out) — остаток после
+// конца входа (для многоугольника — замыкающее ребро).
+template<class Item, class Clip, class Flush>
+bool runPipeline(ItemReader<Item> &reader, TextSceneWriter &writer,
+                 qsizetype chunkSize, Clip clipChunk, Flush flush,
+                 qint64 &outputCount, ParseError &error)
+{
+    Channel<QVector<Item>> freeIn, fullIn, freeOut, fullOut;
+    for (int i = 0; i < 2; ++i) {
+        freeIn.push(QVector<Item>());
+        freeOut.push(QVector<Item>());
+    }
+
+    std::atomic<bool> stop { false };
+    bool readFailed = false;
+    bool writeFailed = false;
+    ParseError readError;
+
+    std::thread readerThread([&] {
+        QVector<Item> chunk;
+        while (!stop && freeIn.pop(chunk)) {
+            if (!reader.read(chunk, chunkSize, readError)) {
+                readFailed = true;
+                stop = true;
+                break;
+            }
+            if (chunk.isEmpty())
+                break;
+            fullIn.push(std::move(chunk));
+        }
+        fullIn.close();
+    });
+
+    qint64 written = 0;
+    std::thread writerThread([&] {
+        QVector<Item> chunk;
+        while (fullOut.pop(chunk)) {
+            if (!writeFailed && !writer.write(chunk)) {
+                writeFailed = true;
+                stop = true;
+            }
+            written += chunk.size();
+            freeOut.push(std::move(chunk));
+        }
+    });
+
+    QVector<Item> in, out;
+    while (fullIn.pop(in)) {
+        if (!stop) {
+            freeOut.pop(out);
+            clipChunk(in, out);
+            fullOut.push(std::move(out));
+        }
+        freeIn.push(std::move(in));
+    }
+    if (!stop) {
+        freeOut.pop(out);
+        flush(out);
+        fullOut.push(std::move(out));
+    }
+    fullOut.close();
+
+    readerThread.join();
+    writerThread.join();
+
+    if (readFailed) {
+        error = readError;
+        return false;
+    }
+    if (writeFailed) {
+        error = ParseError { 0, 0, QString("не удалось записать результат") };
+        return false;
+    }
+    outputCount = written;
+    return true;
+}
+
+bool clipSegmentStream(ItemReader<QLineF> &reader, TextSceneWriter &writer,
+                       const QRectF &window, const StreamOptions &options,
+                       const SegmentEngine &engine, StreamStats &stats,
+                       ParseError &error, WorkStealingPool &pool)
+{
+    SegmentClipResult result;
+    return runPipeline<QLineF>(reader, writer, options.chunkSize,
+        [&](const QVector<QLineF> &in, QVector<QLineF> &out) {
+            clipSegmentsParallel(in, window, engine, result, pool);
+            stats.intersections += result.intersections.size();
+            out.swap(result.visible);
+        },
+        [](QVector<QLineF> &out) { out.clear(); },
+        stats.outputCount, error);
+}
+
+bool clipPolygonStream(ItemReader<QPointF> &reader, TextSceneWriter &writer,
+                       const QRectF &window, const StreamOptions &options,
+                       StreamStats &stats, ParseError &error)
+{
+    PolygonStreamClipper clipper(window);
+    PolygonClipResult &result = clipper.output();
+
+    auto take = [&](QVector<QPointF> &out) {
+        stats.intersections += result.intersections.size();
+        result.intersections.clear();
+        out.clear();
+        out.swap(result.polygon);
+    };
+
+    return runPipeline<QPointF>(reader, writer, options.chunkSize,
+        [&](const QVector<QPointF> &in, QVector<QPointF> &out) {
+            clipper.push(in.constData(), in.size());
+            take(out);
+        },
+        [&](QVector<QPointF> &out) {
+            clipper.finish();
+            take(out);
+        },
+        stats.outputCount, error);
+}
+
+} // namespace
+
+bool clipStream(const QString &inFile,
+                const QString &outFile,
+                const StreamOptions &options,
+                const SegmentEngine &engine,
+                StreamStats &stats,
+                ParseError &error,
+                WorkStealingPool &pool)
+{
+    stats = StreamStats();
+
+    std::unique_ptr<ItemReader<QLineF>>  segmentReader;
+    std::unique_ptr<ItemReader<QPointF>> polygonReader;
+    QRectF window = options.window;
+
+    // --- вход: двоичный (окно и тип — из заголовка) или текст ---
+    QFile binary;
+    BinaryHeader header {};
+    TextNumberStream text;
+
+    if (isBinarySceneFile(inFile)) {
+        QString message;
+        binary.setFileName(inFile);
+        if (!binary.open(QIODevice::ReadOnly) ||
+            !readBinaryHeader(binary, header, &message)) {
+            error = ParseError { 0, 0, message.isEmpty() ? QString("не удалось открыть файл")
+                                                         : message };
+            return false;
+        }
+        stats.kind = SceneKind(header.kind);
+        stats.inputCount = qint64(header.count);
+        if (!options.hasWindow)
+            window = QRectF(QPointF(header.window[0], header.window[1]),
+                            QPointF(header.window[2], header.window[3]));
+
+        if (stats.kind == SceneKind::Segments)
+            segmentReader = std::make_unique<BinaryItemReader<QLineF>>(binary, header);
+        else
+            polygonReader = std::make_unique<BinaryItemReader<QPointF>>(binary, header);
+    } else {
+        if (!options.hasWindow) {
+            error = ParseError { 0, 0, QString("для текстового файла окно нужно задать заранее") };
+            return false;
+        }
+        if (!text.open(inFile, error))
+            return false;
+
+        stats.kind = options.textKind == SceneKind::Polygon ? SceneKind::Polygon
+                                                            : SceneKind::Segments;
+        const qsizetype minimum = stats.kind == SceneKind::Polygon ? 3 : 0;
+
+        double v;
+        const qsizetype got = text.read(&v, 1, error);
+        if (got < 0)
+            return false;
+        if (got == 0) {
+            error = text.errorAtEnd("файл пуст");
+            return false;
+        }
+        if (!isCount(v, minimum)) {
+            error = ParseError { 0, 0,
+                QString("первое число (%1) должно быть целым и не меньше %2")
+                    .arg(v).arg(minimum) };
+            return false;
+        }
+        stats.inputCount = qint64(v);
+
+        if (stats.kind == SceneKind::Segments)
+            segmentReader = std::make_unique<TextItemReader<QLineF>>(text, stats.inputCount);
+        else
+            polygonReader = std::make_unique<TextItemReader<QPointF>>(text, stats.inputCount);
+    }
+
+    // --- выход ---
+    TextSceneWriter writer;
+    if (!writer.open(outFile)) {
+        error = ParseError { 0, 0, QString("не удалось создать %1").arg(outFile) };
+        return false;
+    }
+
+    StreamOptions opt = options;
+    opt.chunkSize = std::max<qsizetype>(opt.chunkSize, 1);
+
+    const bool ok = segmentReader
+        ? clipSegmentStream(*segmentReader, writer, window, opt, engine, stats, error, pool)
+        : clipPolygonStream(*polygonReader, writer, window, opt, stats, error);
+    if (!ok)
+        return false;
+
+    if (!writer.finish(stats.outputCount, window)) {
+        error = ParseError { 0, 0, QString("не удалось записать результат") };
+        return false;
+    }
+    return true;
+}
+
+} // namespace clip
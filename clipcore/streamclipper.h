@@ -0,0 +1,46 @@
+#pragma once
+#include "clipio.h"
+#include "segmentengine.h"
+#include "threadpool.h"
+
+namespace clip {
+
+// размер порции по умолчанию (отрезков или вершин)
+constexpr qsizetype kStreamChunkSize = 1 << 18;
+
+struct StreamOptions
+{
+    // окно отсечения; для двоичного входа без окна берётся окно из заголовка,
+    // для текстового оно обязательно (в тексте окно стоит в конце файла)
+    bool      hasWindow = false;
+    QRectF    window;
+
+    // тип текстового входа (у двоичного — из заголовка)
+    SceneKind textKind = SceneKind::Segments;
+
+    qsizetype chunkSize = kStreamChunkSize;
+};
+
+struct StreamStats
+{
+    SceneKind kind = SceneKind::Unknown;
+    qint64    inputCount = 0;      // отрезков или вершин на входе
+    qint64    outputCount = 0;     // видимых частей или вершин результата
+    qint64    intersections = 0;
+};
+
+// Отсечение файла, который не помещается в память. Вход (текст или *.scb)
+// читается порциями по chunkSize, порции отсекаются и сразу пишутся в
+// outFile в текстовом формате. Чтение, отсечение и запись идут в трёх
+// потоках через двойные буферы, так что память ограничена четырьмя
+// порциями независимо от размера входа. Количество в первой строке
+// результата дописывается в конце (под него оставлено место).
+bool clipStream(const QString &inFile,
+                const QString &outFile,
+                const StreamOptions &options,
+                const SegmentEngine &engine,
+                StreamStats &stats,
+                ParseError &error,
+                WorkStealingPool &pool = WorkStealingPool::global());
+
+} // namespace clip
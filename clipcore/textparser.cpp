@@ -0,0 +1,216 @@
+#include "textparser.h"
+#include "clipstats.h"
+#include <QFile>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <charconv>
+#include <cstring>
+
+namespace clip {
+
+QString ParseError::toString(const QString &fileName) const
+{
+    if (line <= 0)
+        return QString("%1: %2").arg(fileName, message);
+    return QString("%1:%2:%3: %4").arg(fileName).arg(line).arg(column).arg(message);
+}
+
+namespace {
+
+// минимальный размер части для параллельного разбора
+constexpr qint64 kMinPartBytes = 1 << 20;
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// строка и столбец байта offset (считается только при ошибке)
+void locate(const char *data, qint64 offset, ParseError &error)
+{
+    qint64 line = 1;
+    const char *lineStart = data;
+    const char *p = data;
+    const char *end = data + offset;
+    while (const char *nl = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)))) {
+        ++line;
+        lineStart = p = nl + 1;
+    }
+    error.line = line;
+    error.column = (end - lineStart) + 1;
+}
+
+struct Part
+{
+    const char *begin;
+    const char *end;
+    qsizetype   count = 0;      // чисел в части
+    qsizetype   first = 0;      // номер первого числа части
+    qint64      lines = 0;      // переводов строки в части
+    qint64      errorAt = -1;   // смещение неверного числа от начала текста
+};
+
+void countTokens(Part &part)
+{
+    qsizetype count = 0;
+    qint64 lines = 0;
+    bool inToken = false;
+    for (const char *p = part.begin; p < part.end; ++p) {
+        const bool space = isSpace(*p);
+        count += (!space && !inToken);
+        lines += (*p == '\n');
+        inToken = !space;
+    }
+    part.count = count;
+    part.lines = lines;
+}
+
+// разбор части; false и part.errorAt — при неверном числе
+bool parsePart(const char *data, Part &part, double *out)
+{
+    const char *p = part.begin;
+    const char *end = part.end;
+    for (;;) {
+        while (p < end && isSpace(*p))
+            ++p;
+        if (p == end)
+            return true;
+
+        const char *token = p;
+        if (*p == '+')              // from_chars не принимает ведущий '+'
+            ++p;
+
+        // nan и inf from_chars тоже принимает — координатами они не бывают
+        double value;
+        const std::from_chars_result r = std::from_chars(p, end, value);
+        if (r.ec != std::errc() || (r.ptr != end && !isSpace(*r.ptr)) ||
+            !std::isfinite(value)) {
+            part.errorAt = token - data;
+            return false;
+        }
+        *out++ = value;
+        p = r.ptr;
+    }
+}
+
+} // namespace
+
+bool parseNumbers(const char *data, qint64 size,
+                  NumberText &text,
+                  ParseError &error,
+                  WorkStealingPool &pool)
+{
+    QVector<double> &numbers = text.numbers;
+    numbers.clear();
+    text.tag = 0;
+
+    // UTF-8 BOM
+    qint64 skip = 0;
+    if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        skip = 3;
+
+    // метка формата: буква, за которой пробельный символ или конец
+    qint64 first = skip;
+    while (first < size && isSpace(data[first]))
+        ++first;
+    if (first < size && std::isalpha(static_cast<unsigned char>(data[first])) &&
+        (first + 1 == size || isSpace(data[first + 1]))) {
+        text.tag = data[first];
+        skip = first + 1;
+    }
+
+    // --- части по границам строк ---
+    const qint64 maxParts = std::max<qint64>(1, size / kMinPartBytes);
+    const qint64 partCount = std::min<qint64>(maxParts, qint64(pool.threadCount()) * 4);
+
+    QVector<Part> parts;
+    const char *p = data + skip;
+    const char *end = data + size;
+    for (qint64 i = 1; i <= partCount; ++i) {
+        const char *cut = (i == partCount) ? end : data + size * i / partCount;
+        if (cut < p)
+            cut = p;
+        if (cut < end) {
+            const char *nl = static_cast<const char *>(std::memchr(cut, '\n', size_t(end - cut)));
+            cut = nl ? nl + 1 : end;
+        }
+        if (cut > p) {
+            parts.append(Part { p, cut });
+            p = cut;
+        }
+    }
+
+    Part *partData = parts.data();
+
+    // --- проход 1: сколько чисел в каждой части ---
+    pool.run(parts.size(), [&](qsizetype i, int) {
+        countTokens(partData[i]);
+    });
+
+    qsizetype total = 0;
+    qint64 lines = 0;
+    for (Part &part : parts) {
+        part.first = total;
+        total += part.count;
+        lines += part.lines;
+    }
+
+    const char *lastLine = end;
+    while (lastLine > data && lastLine[-1] != '\n')
+        --lastLine;
+    text.endLine = lines + 1;
+    text.endColumn = (end - lastLine) + 1;
+
+    // --- проход 2: разбор прямо на место ---
+    numbers.resize(total);
+    double *out = numbers.data();
+    pool.run(parts.size(), [&](qsizetype i, int) {
+        parsePart(data, partData[i], out + partData[i].first);
+    });
+
+    for (const Part &part : parts) {
+        if (part.errorAt >= 0) {
+            locate(data, part.errorAt, error);
+            const char *tokenEnd = data + part.errorAt;
+            while (tokenEnd < end && !isSpace(*tokenEnd))
+                ++tokenEnd;
+            error.message = QString("неверное число \"%1\"")
+                .arg(QString::fromUtf8(data + part.errorAt, tokenEnd - (data + part.errorAt)));
+            numbers.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseNumbersFile(const QString &fileName,
+                      NumberText &text,
+                      ParseError &error,
+                      WorkStealingPool &pool)
+{
+    CLIP_STAT_TIMER(Parse);
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly)) {
+        error = ParseError { 0, 0, QString("не удалось открыть файл") };
+        return false;
+    }
+
+    const qint64 size = f.size();
+    if (size == 0) {
+        text = NumberText();
+        return true;
+    }
+
+    const uchar *data = f.map(0, size);
+    if (!data) {
+        // отобразить нельзя (например, не обычный файл) — читаем целиком
+        const QByteArray bytes = f.readAll();
+        return parseNumbers(bytes.constData(), bytes.size(), text, error, pool);
+    }
+
+    return parseNumbers(reinterpret_cast<const char *>(data), size,
+                        text, error, pool);
+}
+
+} // namespace clip
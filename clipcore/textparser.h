@@ -0,0 +1,62 @@
+#pragma once
+#include "threadpool.h"
+#include <QString>
+#include <QVector>
+#include <limits>
+
+namespace clip {
+
+// место и причина ошибки разбора (строки и столбцы — с 1)
+struct ParseError
+{
+    qint64  line = 0;
+    qint64  column = 0;
+    QString message;
+
+    // "файл:строка:столбец: сообщение"
+    QString toString(const QString &fileName) const;
+};
+
+// числа текста и положение его конца (для сообщений о нехватке чисел)
+struct NumberText
+{
+    QVector<double> numbers;
+    qint64 endLine = 1;
+    qint64 endColumn = 1;
+
+    // буква-метка формата перед числами ("P" — несколько многоугольников,
+    // "L" — ломаные), 0 — метки нет
+    char tag = 0;
+
+    ParseError errorAtEnd(const QString &message) const
+    { return ParseError { endLine, endColumn, message }; }
+};
+
+// Разбор всех чисел текста (через пробельные символы) с помощью
+// std::from_chars. Одиночная латинская буква в самом начале считается
+// меткой формата (NumberText::tag). Текст режется на части по границам строк, части
+// разбираются параллельно в два прохода: подсчёт чисел, затем запись
+// сразу на своё место в заранее выделенный numbers.
+bool parseNumbers(const char *data, qint64 size,
+                  NumberText &text,
+                  ParseError &error,
+                  WorkStealingPool &pool = WorkStealingPool::global());
+
+// то же для файла, отображённого в память
+bool parseNumbersFile(const QString &fileName,
+                      NumberText &text,
+                      ParseError &error,
+                      WorkStealingPool &pool = WorkStealingPool::global());
+
+// предел количеств из файла: произведения вида 1 + 4n + 4 не переполняются
+constexpr qsizetype kMaxCount = std::numeric_limits<qsizetype>::max() / 8;
+
+// Количество из файла: целое v в [minimum, maximum]. Диапазон проверяется
+// до приведения — double вне диапазона qsizetype (1e300, nan) к нему не
+// приводится.
+inline bool isCount(double v, qsizetype minimum, qsizetype maximum = kMaxCount)
+{
+    return v >= double(minimum) && v <= double(maximum) && v == double(qsizetype(v));
+}
+
+} // namespace clip
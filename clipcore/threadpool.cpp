@@ -0,0 +1,143 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace clip {
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < threadCount; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    // поток 0 — вызывающий run()
+    for (int i = 1; i < threadCount; ++i)
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : threads)
+        t.join();
+}
+
+WorkStealingPool &WorkStealingPool::global()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
+
+void WorkStealingPool::run(qsizetype partCount,
+                           const std::function<void(qsizetype, int)> &task)
+{
+    if (partCount <= 0)
+        return;
+
+    // мало частей или один поток — без синхронизации
+    if (partCount == 1 || queues.size() == 1) {
+        for (qsizetype part = 0; part < partCount; ++part)
+            task(part, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex);
+
+    // непрерывные диапазоны: соседние части обычно и по стоимости близки
+    const qsizetype workers = qsizetype(queues.size());
+    for (qsizetype w = 0; w < workers; ++w) {
+        const qsizetype begin = partCount * w / workers;
+        const qsizetype end   = partCount * (w + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        for (qsizetype part = begin; part < end; ++part)
+            queues[w]->parts.push_back(part);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        currentTask = &task;
+        pending = partCount;
+        busyWorkers = 1;
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    --busyWorkers;
+    done.wait(lock, [this]{ return pending == 0 && busyWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+    quint64 seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wake.wait(lock, [&]{ return stopping || (generation != seen && pending > 0); });
+            if (stopping)
+                return;
+            seen = generation;
+            ++busyWorkers;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--busyWorkers == 0 && pending == 0)
+            done.notify_all();
+    }
+}
+
+void WorkStealingPool::drain(int worker)
+{
+    const std::function<void(qsizetype, int)> *task;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        task = currentTask;
+    }
+
+    qsizetype part;
+    while (takeLocal(worker, part) || steal(worker, part)) {
+        (*task)(part, worker);
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--pending == 0)
+            done.notify_all();
+    }
+}
+
+bool WorkStealingPool::takeLocal(int worker, qsizetype &part)
+{
+    Queue &q = *queues[worker];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.parts.empty())
+        return false;
+    part = q.parts.front();
+    q.parts.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, qsizetype &part)
+{
+    const int n = int(queues.size());
+    for (int i = 1; i < n; ++i) {
+        Queue &q = *queues[(worker + i) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.parts.empty()) {
+            part = q.parts.back();
+            q.parts.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace clip
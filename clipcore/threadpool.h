@@ -0,0 +1,67 @@
+#pragma once
+#include <QtGlobal>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clip {
+
+// Пул потоков с перехватом работы (work stealing).
+// run() раздаёт номера частей по очередям потоков непрерывными диапазонами;
+// поток берёт части из начала своей очереди, а опустев — забирает с конца
+// чужих. Так неравномерные по стоимости части (глубина деления в методе
+// средней точки сильно разная) распределяются без простоя.
+class WorkStealingPool
+{
+public:
+    // threadCount <= 0 — по числу ядер
+    explicit WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    int threadCount() const { return int(queues.size()); }
+
+    // task(part, worker) для каждой part из [0, partCount); вызывающий поток
+    // работает как worker 0. Возвращается, когда все части выполнены.
+    // Вызовы из разных потоков выполняются по очереди; вложенный run()
+    // из task не допускается.
+    void run(qsizetype partCount,
+             const std::function<void(qsizetype part, int worker)> &task);
+
+    // общий пул приложения
+    static WorkStealingPool &global();
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<qsizetype> parts;
+    };
+
+    void workerLoop(int worker);
+    void drain(int worker);
+    bool takeLocal(int worker, qsizetype &part);
+    bool steal(int worker, qsizetype &part);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex runMutex;            // один run() за раз
+
+    std::mutex stateMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(qsizetype, int)> *currentTask = nullptr;
+    quint64 generation = 0;
+    qsizetype pending = 0;          // невыполненные части
+    int busyWorkers = 0;            // потоки внутри drain()
+    bool stopping = false;
+};
+
+} // namespace clip
@@ -0,0 +1,319 @@
+#include "tileclipper.h"
+#include "clipstats.h"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace clip {
+
+namespace {
+
+// наименьшая часть входа при раскладке по окнам (отрезков)
+constexpr qsizetype kMinBinPartSize = 16384;
+
+// предел вспомогательной сетки по каждой оси
+constexpr int kMaxCellsPerAxis = 4096;
+
+struct Box
+{
+    double xmin, ymin, xmax, ymax;
+};
+
+inline Box boxOf(const QLineF &s)
+{
+    return Box { std::min(s.x1(), s.x2()), std::min(s.y1(), s.y2()),
+                 std::max(s.x1(), s.x2()), std::max(s.y1(), s.y2()) };
+}
+
+// окно с NaN или бесконечностью в сетку не кладётся и пар не получает
+inline bool isFinite(const Box &b)
+{
+    return std::isfinite(b.xmin) && std::isfinite(b.ymin) &&
+           std::isfinite(b.xmax) && std::isfinite(b.ymax);
+}
+
+inline bool overlaps(const Box &a, const Box &b)
+{
+    return a.xmax >= b.xmin && a.xmin <= b.xmax &&
+           a.ymax >= b.ymin && a.ymin <= b.ymax;
+}
+
+// Равномерная сетка над окнами: около одного окна на ячейку. Окно
+// записано во все ячейки, которые накрывает.
+class WindowGrid
+{
+public:
+    explicit WindowGrid(const QVector<QRectF> &windows)
+    {
+        const qsizetype m = windows.size();
+        boxes.resize(m);
+        for (qsizetype w = 0; w < m; ++w) {
+            const QRectF r = windows[w].normalized();
+            boxes[w] = Box { r.left(), r.top(), r.right(), r.bottom() };
+        }
+        const double inf = std::numeric_limits<double>::infinity();
+        bounds = Box { inf, inf, -inf, -inf };
+        for (const Box &b : std::as_const(boxes)) {
+            if (!isFinite(b))
+                continue;
+            bounds.xmin = std::min(bounds.xmin, b.xmin);
+            bounds.ymin = std::min(bounds.ymin, b.ymin);
+            bounds.xmax = std::max(bounds.xmax, b.xmax);
+            bounds.ymax = std::max(bounds.ymax, b.ymax);
+        }
+        if (bounds.xmin > bounds.xmax)
+            return;
+
+        const double w = std::max(bounds.xmax - bounds.xmin, 1e-9);
+        const double h = std::max(bounds.ymax - bounds.ymin, 1e-9);
+        const double cells = double(m);
+        nx = std::clamp(int(std::ceil(std::sqrt(cells * w / h))), 1, kMaxCellsPerAxis);
+        ny = std::clamp(int(std::ceil(cells / nx)), 1, kMaxCellsPerAxis);
+        invCellW = nx / w;
+        invCellH = ny / h;
+
+        // CSR: подсчёт, сдвиги, раскладка
+        const qsizetype cellCount = qsizetype(nx) * ny;
+        cellStart.fill(0, cellCount + 1);
+        for (const Box &b : std::as_const(boxes))
+            if (isFinite(b))
+                forCells(b, [this](qsizetype c) { ++cellStart[c + 1]; });
+        for (qsizetype c = 0; c < cellCount; ++c)
+            cellStart[c + 1] += cellStart[c];
+
+        cellItems.resize(cellStart[cellCount]);
+        QVector<qsizetype> next(cellStart.constBegin(), cellStart.constEnd() - 1);
+        for (qsizetype k = 0; k < m; ++k)
+            if (isFinite(boxes[k]))
+                forCells(boxes[k], [&](qsizetype c) { cellItems[next[c]++] = quint32(k); });
+    }
+
+    const Box &window(qsizetype w) const { return boxes[w]; }
+
+    // visit(w) для каждого окна, которое задевает b, ровно один раз
+    template<class Visit>
+    void forWindows(const Box &b, Visit visit) const
+    {
+        if (nx == 0 || !overlaps(b, bounds))
+            return;
+
+        const qsizetype *start = cellStart.constData();
+        const quint32 *items = cellItems.constData();
+        const Box *win = boxes.constData();
+
+        const int cx0 = cellX(b.xmin), cx1 = cellX(b.xmax);
+        const int cy0 = cellY(b.ymin), cy1 = cellY(b.ymax);
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                const qsizetype c = qsizetype(cy) * nx + cx;
+                for (qsizetype k = start[c]; k < start[c + 1]; ++k) {
+                    const quint32 w = items[k];
+                    const Box &W = win[w];
+                    if (!overlaps(b, W))
+                        continue;
+                    // пара — только в ячейке нижнего левого угла пересечения
+                    if (cellX(std::max(b.xmin, W.xmin)) != cx ||
+                        cellY(std::max(b.ymin, W.ymin)) != cy)
+                        continue;
+                    visit(w);
+                }
+            }
+        }
+    }
+
+private:
+    int cellX(double x) const
+    {
+        return int(std::clamp(std::floor((x - bounds.xmin) * invCellW), 0.0, double(nx - 1)));
+    }
+
+    int cellY(double y) const
+    {
+        return int(std::clamp(std::floor((y - bounds.ymin) * invCellH), 0.0, double(ny - 1)));
+    }
+
+    template<class Visit>
+    void forCells(const Box &b, Visit visit) const
+    {
+        const int cx0 = cellX(b.xmin), cx1 = cellX(b.xmax);
+        const int cy0 = cellY(b.ymin), cy1 = cellY(b.ymax);
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx)
+                visit(qsizetype(cy) * nx + cx);
+    }
+
+    QVector<Box>     boxes;
+    Box              bounds {};
+    double           invCellW = 0, invCellH = 0;
+    int              nx = 0, ny = 0;
+    QVector<qsizetype> cellStart;
+    QVector<quint32> cellItems;
+};
+
+} // namespace
+
+QVector<QRectF> tileGrid(const QRectF &area, int columns, int rows)
+{
+    QVector<QRectF> tiles;
+    if (columns < 1 || rows < 1)
+        return tiles;
+
+    // границы считаются от краёв области, чтобы соседние окна сходились
+    // точно, без накопления ошибки
+    const QRectF r = area.normalized();
+    auto xAt = [&](int i) { return r.left() + r.width() * i / columns; };
+    auto yAt = [&](int j) { return r.top() + r.height() * j / rows; };
+
+    tiles.reserve(qsizetype(columns) * rows);
+    for (int j = 0; j < rows; ++j)
+        for (int i = 0; i < columns; ++i)
+            tiles.append(QRectF(QPointF(xAt(i), yAt(j)), QPointF(xAt(i + 1), yAt(j + 1))));
+    return tiles;
+}
+
+qsizetype clipSegmentsTiled(const QVector<QLineF> &segments,
+                            const QVector<QRectF> &windows,
+                            const SegmentEngine &engine,
+                            QVector<SegmentClipResult> &results,
+                            WorkStealingPool &pool)
+{
+    CLIP_STAT_TIMER(Clip);
+    const qsizetype n = segments.size();
+    const qsizetype m = windows.size();
+    results.resize(m);
+    for (SegmentClipResult &r : results) {
+        r.visible.clear();
+        r.intersections.clear();
+    }
+    if (n == 0 || m == 0)
+        return 0;
+
+    const WindowGrid grid(windows);
+    const QLineF *seg = segments.constData();
+
+    // --- раскладка: части входа, у каждой свои счётчики по окнам ---
+    const qsizetype parts = std::clamp<qsizetype>((n + kMinBinPartSize - 1) / kMinBinPartSize,
+                                                  1, qsizetype(pool.threadCount()) * 4);
+    auto partBegin = [n, parts](qsizetype part) { return n * part / parts; };
+
+    // счётчики, места и номера — qsizetype: пар «отрезок — окно» бывает
+    // больше 2^32 даже при умеренных n и m
+    QVector<qsizetype> slot(parts * m, 0);   // [part][окно]: счётчик, затем место
+    qsizetype *counts = slot.data();
+    pool.run(parts, [&](qsizetype part, int) {
+        qsizetype *own = counts + part * m;
+        for (qsizetype i = partBegin(part); i < partBegin(part + 1); ++i)
+            grid.forWindows(boxOf(seg[i]), [own](quint32 w) { ++own[w]; });
+    });
+
+    // места: окно за окном, внутри окна — части по порядку
+    QVector<qsizetype> tileStart(m + 1, 0);
+    qsizetype pairs = 0;
+    for (qsizetype w = 0; w < m; ++w) {
+        tileStart[w] = pairs;
+        for (qsizetype part = 0; part < parts; ++part) {
+            const qsizetype c = counts[part * m + w];
+            counts[part * m + w] = pairs;
+            pairs += c;
+        }
+    }
+    tileStart[m] = pairs;
+
+    QVector<qsizetype> ids(pairs);
+    qsizetype *idOut = ids.data();
+    pool.run(parts, [&](qsizetype part, int) {
+        qsizetype *next = counts + part * m;
+        for (qsizetype i = partBegin(part); i < partBegin(part + 1); ++i)
+            grid.forWindows(boxOf(seg[i]), [&](quint32 w) { idOut[next[w]++] = i; });
+    });
+
+    // --- отсечение: окно целиком в одном потоке, отрезки окна подряд ---
+    QVector<QVector<QLineF>> scratch(pool.threadCount());
+    pool.run(m, [&](qsizetype w, int worker) {
+        QVector<QLineF> &buffer = scratch[worker];
+        buffer.resize(tileStart[w + 1] - tileStart[w]);
+        QLineF *dst = buffer.data();
+        for (qsizetype k = tileStart[w]; k < tileStart[w + 1]; ++k)
+            *dst++ = seg[ids[k]];
+
+        const Box &b = grid.window(w);
+        const QRectF window(QPointF(b.xmin, b.ymin), QPointF(b.xmax, b.ymax));
+        engine.clipRange(buffer.constData(), buffer.size(), window, results[w]);
+    });
+
+    return pairs;
+}
+
+bool loadTileWindows(const QString &fileName, QVector<QRectF> &windows,
+                     ParseError *error)
+{
+    NumberText text;
+    ParseError e;
+    bool ok = parseNumbersFile(fileName, text, e);
+
+    if (ok && text.numbers.isEmpty()) {
+        e = text.errorAtEnd("файл пуст");
+        ok = false;
+    }
+
+    qsizetype k = 0;
+    if (ok) {
+        const double v = text.numbers[0];
+        if (!isCount(v, 1)) {
+            e = ParseError { 0, 0,
+                QString("первое число (%1) должно быть целым и не меньше 1").arg(v) };
+            ok = false;
+        } else {
+            k = qsizetype(v);
+        }
+    }
+    if (ok && text.numbers.size() < 1 + 4 * k) {
+        e = text.errorAtEnd(QString("ожидалось %1 чисел, в файле %2")
+                                .arg(1 + 4 * k).arg(text.numbers.size()));
+        ok = false;
+    }
+
+    if (!ok) {
+        if (error)
+            *error = e;
+        return false;
+    }
+
+    const double *v = text.numbers.constData() + 1;
+    windows.resize(k);
+    for (qsizetype i = 0; i < k; ++i, v += 4)
+        windows[i] = QRectF(QPointF(v[0], v[1]), QPointF(v[2], v[3]));
+    return true;
+}
+
+bool saveTiledSegments(const QString &fileName,
+                       const QVector<QRectF> &windows,
+                       const QVector<SegmentClipResult> &results)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out.setRealNumberPrecision(12);
+
+    out << windows.size() << '\n';
+    for (qsizetype w = 0; w < windows.size(); ++w) {
+        const QRectF &r = windows[w];
+        out << r.left() << ' ' << r.top() << ' '
+            << r.right() << ' ' << r.bottom() << '\n';
+
+        const QVector<QLineF> &visible = results[w].visible;
+        out << visible.size() << '\n';
+        for (const QLineF &s : visible)
+            out << s.x1() << ' ' << s.y1() << "   "
+                << s.x2() << ' ' << s.y2() << '\n';
+    }
+
+    out.flush();
+    return out.status() == QTextStream::Ok;
+}
+
+} // namespace clip
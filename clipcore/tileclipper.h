@@ -0,0 +1,42 @@
+#pragma once
+#include "segmentengine.h"
+#include "textparser.h"
+#include "threadpool.h"
+
+namespace clip {
+
+// Отсечение одного набора отрезков сразу многими окнами (тайлами).
+//
+// Окна раскладываются по вспомогательной равномерной сетке. Отрезок
+// относится ко всем окнам, которые задевает его ограничивающий
+// прямоугольник; пара «отрезок — окно» учитывается в одной ячейке — там,
+// где лежит нижний левый угол пересечения их прямоугольников, поэтому
+// повторов нет. Номера отрезков по окнам собираются в два прохода
+// (подсчёт, затем запись на место) параллельно по частям входа, затем
+// окна отсекаются параллельно, каждое в свой буфер.
+//
+// Отрезки в буфере окна идут в порядке входа, так что результат окна
+// совпадает с engine.clipAll() всего набора по одному этому окну.
+
+// columns × rows равных окон, покрывающих area; строками снизу вверх
+QVector<QRectF> tileGrid(const QRectF &area, int columns, int rows);
+
+// results[k] — видимые части и точки пересечения для windows[k];
+// возвращает число пар «отрезок — окно», прошедших отбор
+qsizetype clipSegmentsTiled(const QVector<QLineF> &segments,
+                            const QVector<QRectF> &windows,
+                            const SegmentEngine &engine,
+                            QVector<SegmentClipResult> &results,
+                            WorkStealingPool &pool = WorkStealingPool::global());
+
+// Файл окон (текст): k, затем k строк "xmin ymin xmax ymax"
+bool loadTileWindows(const QString &fileName, QVector<QRectF> &windows,
+                     ParseError *error = nullptr);
+
+// Результат (текст): k, затем для каждого окна строка окна,
+// число видимых частей n и n строк "x1 y1 x2 y2"
+bool saveTiledSegments(const QString &fileName,
+                       const QVector<QRectF> &windows,
+                       const QVector<SegmentClipResult> &results);
+
+} // namespace clip
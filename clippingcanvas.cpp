@@ -1,22 +1,35 @@
 #include "clippingcanvas.h"
+#include "clipcore/clipstats.h"
+#include "clipcore/qtpointtraits.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QMouseEvent>
 #include <QWheelEvent>
-#include <QFile>
-#include <QTextStream>
 #include <cmath>
 #include <algorithm>
 #include <QToolTip>
+#include <QElapsedTimer>
+#include <QThread>
 
 
 ClippingCanvas::ClippingCanvas(QWidget *parent)
     : QWidget(parent)
+    , segmentEngine(clip::createSegmentEngine(clip::SegmentAlgorithm::Midpoint))
 {
     setMouseTracking(true);
     setMinimumSize(800, 600);
 }
 
+ClippingCanvas::~ClippingCanvas()
+{
+    // отменённые задания доходят до ближайшей проверки и завершаются
+    stopJob();
+    for (QThread *thread : std::as_const(jobThreads)) {
+        thread->wait();
+        delete thread;
+    }
+}
+
 // ---------- координаты ----------
 QPointF ClippingCanvas::originPx() const
 {
@@ -45,292 +58,544 @@ QPointF ClippingCanvas::screenToGridF(QPoint s) const
     return screenToGridF(QPointF(s));
 }
 
-// ---------- загрузка данных ----------
-
-bool ClippingCanvas::loadSegmentsFromFile(const QString &fileName)
+QRectF ClippingCanvas::visibleGridRect(qreal margin) const
 {
-    QFile f(fileName);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
-        return false;
-
-    QTextStream in(&f);
-
-    int n;
-    in >> n;
-    if (in.status() != QTextStream::Ok)
-        return false;
-
-    segmentsOriginal.clear();
-    segmentsClipped.clear();
-    polygonOriginal.clear();
-    polygonClipped.clear();
+    const QPointF a = screenToGridF(QPointF(-margin, -margin));
+    const QPointF b = screenToGridF(QPointF(width() + margin, height() + margin));
+    return QRectF(a, b).normalized();
+}
 
-    for (int i = 0; i < n; ++i)
-    {
-        double x1, y1, x2, y2;
-        in >> x1 >> y1 >> x2 >> y2;
-        if (in.status() != QTextStream::Ok)
-            return false;
+// ---------- фоновое задание ----------
 
-        segmentsOriginal.append(QLineF(QPointF(x1, y1), QPointF(x2, y2)));
-    }
+// Результат задания по отрезкам: клиппер со своим движком, который после
+// завершения целиком переходит к холсту. При окне-многоугольнике region
+// клиппер не отсекает, а только строит сетку; пачки считаются по segments.
+struct ClippingCanvas::SegmentJobResult
+{
+    std::unique_ptr<clip::SegmentEngine> engine;
+    clip::IncrementalClipper             clipper;
+    QRectF                               window;
+    clip::ConvexWindow                   region;
+    QVector<QLineF>                      segments;
+};
+
+// work(generation, cancel) выполняется в новом потоке; прежнее задание
+// отменяется, его уже отправленные результаты отбросит post()
+template<class Work>
+void ClippingCanvas::startJob(Work work)
+{
+    stopJob();
+    const quint64 generation = jobGeneration;
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    jobCancel = cancel;
+
+    QThread *thread = QThread::create([work, generation, cancel] {
+        work(generation, *cancel);
+    });
+    jobThreads.append(thread);
+    connect(thread, &QThread::finished, this, [this, thread] {
+        jobThreads.removeOne(thread);
+        thread->deleteLater();
+    });
+    thread->start();
+
+    setJobRunning(true);
+    emit jobProgress(0, 0);
+}
 
-    double xmin, ymin, xmax, ymax;
-    in >> xmin >> ymin >> xmax >> ymax;
-    if (in.status() != QTextStream::Ok)
-        return false;
+// fn выполнится в потоке GUI, если задание generation к тому времени
+// не отменено; вызывается из фонового потока
+template<class Fn>
+void ClippingCanvas::post(quint64 generation, Fn fn)
+{
+    QMetaObject::invokeMethod(this, [this, generation, fn] {
+        if (generation == jobGeneration)
+            fn();
+    }, Qt::QueuedConnection);
+}
 
-    clipWindow = QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax));
-    hasWindow = true;
-    currentMode = Mode::SegmentsMidpoint;
+// ---------- загрузка данных ----------
 
-    clipAllSegmentsMidpoint();
-    update();
-    return true;
+void ClippingCanvas::loadSegmentsFromFile(const QString &fileName)
+{
+    clearAll();
+    clip::resetStats();
+    auto job = std::make_shared<SegmentJobResult>();
+    job->engine = clip::createSegmentEngine(segmentEngine->algorithm());
+
+    startJob([this, fileName, job](quint64 generation, const std::atomic_bool &cancel) {
+        clip::SegmentScene scene;
+        clip::ParseError error;
+        if (!clip::loadSegmentScene(fileName, scene, &error)) {
+            const QString message = error.toString(fileName);
+            post(generation, [this, message] { failJob(message); });
+            return;
+        }
+        if (cancel)
+            return;
+
+        job->clipper.setSegments(scene.segments);
+        job->window = scene.window;
+        job->region = clip::sceneWindow(scene.window, scene.windowPolygon);
+        job->segments = scene.segments;
+        const clip::GridIndex index = job->clipper.index();
+        post(generation, [this, scene, index] { showLoadedSegments(scene, index); });
+
+        clipSegmentsInBatches(generation, cancel, job);
+    });
 }
 
-bool ClippingCanvas::loadPolygonFromFile(const QString &fileName)
+void ClippingCanvas::loadPolygonFromFile(const QString &fileName)
 {
-    QFile f(fileName);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
-        return false;
+    clearAll();
+    clip::resetStats();
+
+    startJob([this, fileName](quint64 generation, const std::atomic_bool &cancel) {
+        clip::PolygonScene scene;
+        clip::ParseError error;
+        if (!clip::loadPolygonScene(fileName, scene, &error)) {
+            const QString message = error.toString(fileName);
+            post(generation, [this, message] { failJob(message); });
+            return;
+        }
+        if (cancel)
+            return;
+
+        clip::PolygonClipResult result;
+        clip::clipPolygonSutherlandHodgman(scene.polygon,
+                                           clip::sceneWindow(scene.window, scene.windowPolygon),
+                                           result);
+        post(generation, [this, scene, result] { showLoadedPolygon(scene, result); });
+    });
+}
 
-    QTextStream in(&f);
+void ClippingCanvas::loadPolylinesFromFile(const QString &fileName)
+{
+    clearAll();
+    clip::resetStats();
+
+    startJob([this, fileName](quint64 generation, const std::atomic_bool &cancel) {
+        clip::PolylineScene scene;
+        clip::ParseError error;
+        if (!clip::loadPolylineScene(fileName, scene, &error)) {
+            const QString message = error.toString(fileName);
+            post(generation, [this, message] { failJob(message); });
+            return;
+        }
+        if (cancel)
+            return;
+
+        clip::PolylineClipResult result;
+        clip::clipPolylines(scene.chains,
+                            clip::sceneWindow(scene.window, scene.windowPolygon),
+                            result);
+        post(generation, [this, scene, result] { showLoadedPolylines(scene, result); });
+    });
+}
 
-    int n;
-    in >> n;
-    if (in.status() != QTextStream::Ok || n < 3)
+// Снимок результата для фоновой записи. Копии QVector (и
+// IncrementalClipper из них) неглубокие: данные общие с холстом, пока он
+// их не изменит, так что запись читает его буферы без блокировок, а
+// перемещение окна во время записи её не затрагивает.
+struct ClippingCanvas::ExportJob
+{
+    bool                     fromIncremental = false;
+    clip::IncrementalClipper incremental;
+    QVector<QLineF>          segments;    // пачки, пока отсечение не закончено
+    QVector<QPointF>         polygon;
+    clip::PolygonSet         polylines;
+    QVector<QPointF>         points;
+    clip::ExportScene        scene;       // по буферам выше, кроме incremental
+    QRectF                   window;
+    QVector<QPointF>         windowPolygon;
+};
+
+bool ClippingCanvas::exportResult(const QString &fileName, QString *error)
+{
+    // отрезки: пока идёт показ пачками — их буферы, иначе прямо incremental
+    // (видимые части в порядке входа, без сборки в один массив)
+    auto job = std::make_shared<ExportJob>();
+    const QVector<QPointF> *points = nullptr;
+    switch (currentMode) {
+    case Mode::Segments:
+        if (progressive) {
+            job->segments = progressClipped;
+            job->scene = clip::exportSegments(job->segments);
+            points = &intersectionPoints;
+        } else {
+            job->fromIncremental = true;
+            job->incremental = incremental;
+        }
+        break;
+    case Mode::PolygonSuthHodg:
+        job->polygon = polygonClip.polygon;
+        job->scene = clip::exportPolygon(job->polygon);
+        points = &polygonClip.intersections;
+        break;
+    case Mode::Polylines:
+        job->polylines = polylineClip.chains;
+        job->scene = clip::exportPointSets(clip::SceneKind::Polyline, job->polylines);
+        points = &polylineClip.intersections;
+        break;
+    case Mode::None:
+        if (error)
+            *error = "Нет результата отсечения";
         return false;
-
-    polygonOriginal.clear();
-    polygonClipped.clear();
-    segmentsOriginal.clear();
-    segmentsClipped.clear();
-
-    for (int i = 0; i < n; ++i)
-    {
-        double x, y;
-        in >> x >> y;
-        if (in.status() != QTextStream::Ok)
-            return false;
-
-        polygonOriginal.append(QPointF(x, y));
     }
 
-    double xmin, ymin, xmax, ymax;
-    in >> xmin >> ymin >> xmax >> ymax;
-    if (in.status() != QTextStream::Ok)
-        return false;
-
-    clipWindow = QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax));
-    hasWindow = true;
-    currentMode = Mode::PolygonSuthHodg;
-
-    clipPolygonSutherlandHodgman();
-    update();
+    if (points) {
+        job->points = *points;
+        job->scene.points = job->points.constData();
+        job->scene.pointCount = job->points.size();
+    }
+    job->window = clipWindow;
+    if (!convexWindow.isRect())
+        job->windowPolygon = convexWindow.vertices();
+
+    startJob([this, fileName, job](quint64 generation, const std::atomic_bool &cancel) {
+        // у incremental число видимых частей и точек считается проходом
+        // по его буферам — тоже здесь, в фоне
+        clip::ExportScene scene = job->fromIncremental
+            ? clip::exportSegments(job->incremental) : job->scene;
+        scene.window = job->window;
+        scene.windowPolygon = job->windowPolygon;
+
+        QString message;
+        const bool ok = clip::exportScene(fileName, clip::exportFormatForFile(fileName),
+                                          scene, &message, clip::ColumnPrecision::Float64,
+                                          clip::WorkStealingPool::global(), &cancel);
+        if (ok)
+            message.clear();
+        const bool cancelled = !ok && cancel;
+
+        // не через post(): об отменённой записи тоже нужно сообщить, а
+        // занятость снимается, только если за ней не начато новое задание
+        QMetaObject::invokeMethod(this, [this, generation, fileName, message, cancelled] {
+            if (generation == jobGeneration)
+                setJobRunning(false);
+            emit exportFinished(fileName, message, cancelled);
+        }, Qt::QueuedConnection);
+    });
     return true;
 }
 
 void ClippingCanvas::clearAll()
 {
+    cancelJob();
     segmentsOriginal.clear();
-    segmentsClipped.clear();
+    intersectionPoints.clear();
+    hoverPoints.clear();
+    incremental.clear();
+    progressive = false;
+    progressIndex.clear();
+    progressClipped.clear();
     polygonOriginal.clear();
-    polygonClipped.clear();
+    polygonClip.polygon.clear();
+    polygonClip.intersections.clear();
+    polylineOriginal.clear();
+    polylineClip.clear();
     hasWindow = false;
+    convexWindow.setRect(QRectF());
     currentMode = Mode::None;
+    invalidateScreenCache();
     update();
 }
 
-// ---------- логические проверки для алгоритмов ----------
+// ---------- фоновое задание: отмена, пачки, результаты ----------
 
-bool ClippingCanvas::pointInside(const QPointF &P) const
+void ClippingCanvas::stopJob()
 {
-    if (!hasWindow) return false;
-    return (P.x() >= clipWindow.left()  &&
-            P.x() <= clipWindow.right() &&
-            P.y() >= clipWindow.top()   &&
-            P.y() <= clipWindow.bottom());
+    if (jobCancel)
+        *jobCancel = true;
+    jobCancel.reset();
+    ++jobGeneration;
 }
 
-// полностью вне окна: обе точки по одну сторону
-bool ClippingCanvas::segOutside(const QPointF &A, const QPointF &B) const
+void ClippingCanvas::cancelJob()
 {
-    if (!hasWindow) return true;
-
-    if (A.x() < clipWindow.left()  && B.x() < clipWindow.left())  return true;
-    if (A.x() > clipWindow.right() && B.x() > clipWindow.right()) return true;
-    if (A.y() < clipWindow.top()   && B.y() < clipWindow.top())   return true;
-    if (A.y() > clipWindow.bottom()&& B.y() > clipWindow.bottom())return true;
-
-    return false;
+    stopJob();
+    setJobRunning(false);
 }
 
-// ---------- Алгоритм средней точки ----------
-
-void ClippingCanvas::clipMidpoint(const QPointF &A,
-                                  const QPointF &B,
-                                  QVector<QLineF> &outLines) const
+void ClippingCanvas::setJobRunning(bool on)
 {
-    double dx = B.x() - A.x();
-    double dy = B.y() - A.y();
-    double len2 = dx * dx + dy * dy;
-
-    if (len2 < 1e-3)
+    if (jobRunning == on)
         return;
+    jobRunning = on;
+    emit busyChanged(on);
+}
 
-    if (segOutside(A, B))
-        return;
-
-    bool Ainside = pointInside(A);
-    bool Binside = pointInside(B);
-
-    // Оба inside → целиком видно
-    if (Ainside && Binside) {
-        outLines.append(QLineF(A, B));
+void ClippingCanvas::clipSegmentsInBatches(quint64 generation,
+                                           const std::atomic_bool &cancel,
+                                           std::shared_ptr<SegmentJobResult> job)
+{
+    if (!job->region.isRect()) {
+        // окно-многоугольник: пачки отсекаются прямо по отрезкам и
+        // остаются на холсте, клиппер не передаётся
+        const qsizetype total = job->segments.size();
+        for (qsizetype first = 0; first < total; first += kJobBatchSize) {
+            if (cancel)
+                return;
+            const qsizetype last = std::min(first + kJobBatchSize, total);
+            clip::SegmentClipResult batch;
+            {
+                CLIP_STAT_TIMER(Clip);
+                job->engine->clipRange(job->segments.constData() + first, last - first,
+                                       job->region, batch);
+            }
+            post(generation, [this, batch, last, total] {
+                appendSegmentBatch(batch.visible, batch.intersections, last, total);
+            });
+        }
+        if (!cancel)
+            post(generation, [this] { setJobRunning(false); });
         return;
     }
 
-    // Середина
-    QPointF M((A.x() + B.x()) / 2.0, (A.y() + B.y()) / 2.0);
-
+    clip::IncrementalClipper &clipper = job->clipper;
+    clipper.begin(job->window, *job->engine);
+
+    const qsizetype total = clipper.size();
+    for (qsizetype first = 0; first < total; first += kJobBatchSize) {
+        if (cancel)
+            return;
+        const qsizetype last = std::min(first + kJobBatchSize, total);
+        clipper.clipRange(first, last);
+
+        // пачка — свои буферы; в поток GUI уходят без копирования
+        QVector<QLineF> visible;
+        QVector<QPointF> points;
+        for (qsizetype i = first; i < last; ++i) {
+            QLineF fragment;
+            if (clipper.visible(i, fragment))
+                visible.append(fragment);
+            const QPointF *p;
+            const int n = clipper.intersections(i, p);
+            for (int k = 0; k < n; ++k)
+                points.append(p[k]);
+        }
+        post(generation, [this, visible, points, last, total] {
+            appendSegmentBatch(visible, points, last, total);
+        });
+    }
 
-    // Рекурсивное деление
-    clipMidpoint(A, M, outLines);
-    clipMidpoint(M, B, outLines);
+    if (!cancel)
+        post(generation, [this, job] { finishSegmentJob(job); });
 }
 
-void ClippingCanvas::clipAllSegmentsMidpoint()
+// полное отсечение уже загруженных отрезков текущим алгоритмом и окном
+void ClippingCanvas::startSegmentClipJob()
 {
-    segmentsClipped.clear();
+    if (!progressive) {
+        progressIndex = incremental.index();
+        progressive = true;
+    }
+    incremental.clear();
+    progressClipped.clear();
     intersectionPoints.clear();
-    if (!hasWindow) return;
+    hoverPoints.clear();
+    invalidateScreenCache();
+    update();
 
-    QVector<QLineF> visible;
+    auto job = std::make_shared<SegmentJobResult>();
+    job->engine = clip::createSegmentEngine(segmentEngine->algorithm());
+    job->window = clipWindow;
+    job->region = convexWindow;
+    job->segments = segmentsOriginal;
+    const QVector<QLineF> segments = segmentsOriginal;
+    const clip::GridIndex index = progressIndex;
+
+    startJob([this, job, segments, index](quint64 generation, const std::atomic_bool &cancel) {
+        job->clipper.setSegments(segments, index);
+        clipSegmentsInBatches(generation, cancel, job);
+    });
+}
+
+void ClippingCanvas::showLoadedSegments(const clip::SegmentScene &scene,
+                                        const clip::GridIndex &index)
+{
+    segmentsOriginal = scene.segments;
+    clipWindow = scene.window;
+    convexWindow = clip::sceneWindow(scene.window, scene.windowPolygon);
+    hasWindow = true;
+    currentMode = Mode::Segments;
 
-    for (const QLineF &s : std::as_const(segmentsOriginal)) {
+    progressive = true;
+    progressIndex = index;
 
-        // --- добавляем реальные точки пересечения ---
-        QVector<QPointF> realPts = findRealIntersections(s.p1(), s.p2());
-        for (const QPointF &pt : realPts)
-            intersectionPoints.append(pt);
+    invalidateScreenCache();
+    update();
+}
 
-        // --- запускаем midpoint ---
-        clipMidpoint(s.p1(), s.p2(), visible);
+void ClippingCanvas::appendSegmentBatch(const QVector<QLineF> &visible,
+                                        const QVector<QPointF> &points,
+                                        qsizetype done, qsizetype total)
+{
+    progressClipped += visible;
+    intersectionPoints += points;
+    hoverPoints.insert(points);
+
+    // готовые экранные буферы дополняются, а не строятся заново
+    if (screen.valid) {
+        for (const QLineF &s : visible) {
+            if (screen.view.intersects(QRectF(s.p1(), s.p2()).normalized()))
+                screen.clipped.append(screen.map(s));
+        }
+        for (const QPointF &pt : points) {
+            if (screen.view.contains(pt))
+                screen.points.append(screen.map(pt));
+        }
     }
 
-    segmentsClipped = visible;
+    emit jobProgress(done, total);
+    update();
 }
 
+void ClippingCanvas::finishSegmentJob(const std::shared_ptr<SegmentJobResult> &job)
+{
+    // движок переходит вместе с клиппером, который на него ссылается
+    segmentEngine = std::move(job->engine);
+    incremental = std::move(job->clipper);
 
-// ---------- Сазерленд–Ходжман ----------
+    progressive = false;
+    progressIndex.clear();
+    progressClipped.clear();
+    updateIntersectionPoints();
 
-bool ClippingCanvas::insideEdge(const QPointF &P, Edge edge) const
+    setJobRunning(false);
+    invalidateScreenCache();
+    update();
+}
+
+void ClippingCanvas::showLoadedPolygon(const clip::PolygonScene &scene,
+                                       const clip::PolygonClipResult &result)
 {
-    switch (edge) {
-    case Edge::Left:   return P.x() >= clipWindow.left();
-    case Edge::Right:  return P.x() <= clipWindow.right();
-    case Edge::Bottom: return P.y() >= clipWindow.top();    // Y вверх
-    case Edge::Top:    return P.y() <= clipWindow.bottom();
-    }
-    return false;
+    polygonOriginal = scene.polygon;
+    polygonClip = result;
+    hoverPoints.clear();
+    hoverPoints.insert(polygonClip.intersections);
+
+    clipWindow = scene.window;
+    convexWindow = clip::sceneWindow(scene.window, scene.windowPolygon);
+    hasWindow = true;
+    currentMode = Mode::PolygonSuthHodg;
+
+    setJobRunning(false);
+    invalidateScreenCache();
+    update();
 }
 
-QPointF ClippingCanvas::intersectWithEdge(const QPointF &S,
-                                          const QPointF &E,
-                                          Edge edge) const
+void ClippingCanvas::showLoadedPolylines(const clip::PolylineScene &scene,
+                                         const clip::PolylineClipResult &result)
 {
-    double dx = E.x() - S.x();
-    double dy = E.y() - S.y();
-    double t = 0.0;
+    polylineOriginal = scene.chains;
+    polylineClip = result;
+    hoverPoints.clear();
+    hoverPoints.insert(polylineClip.intersections);
 
-    switch (edge) {
-    case Edge::Left: {
-        double x = clipWindow.left();
-        t = (dx == 0.0) ? 0.0 : (x - S.x()) / dx;
-        return QPointF(x, S.y() + t * dy);
-    }
-    case Edge::Right: {
-        double x = clipWindow.right();
-        t = (dx == 0.0) ? 0.0 : (x - S.x()) / dx;
-        return QPointF(x, S.y() + t * dy);
-    }
-    case Edge::Bottom: {
-        double y = clipWindow.top();
-        t = (dy == 0.0) ? 0.0 : (y - S.y()) / dy;
-        return QPointF(S.x() + t * dx, y);
-    }
-    case Edge::Top: {
-        double y = clipWindow.bottom();
-        t = (dy == 0.0) ? 0.0 : (y - S.y()) / dy;
-        return QPointF(S.x() + t * dx, y);
-    }
-    }
-    return S;
+    clipWindow = scene.window;
+    convexWindow = clip::sceneWindow(scene.window, scene.windowPolygon);
+    hasWindow = true;
+    currentMode = Mode::Polylines;
+
+    setJobRunning(false);
+    invalidateScreenCache();
+    update();
 }
 
-QVector<QPointF> ClippingCanvas::clipAgainstEdge(const QVector<QPointF> &poly,
-                                                 Edge edge)
+void ClippingCanvas::failJob(const QString &message)
 {
-    QVector<QPointF> out;
-    if (poly.isEmpty())
-        return out;
+    loadError = message;
+    setJobRunning(false);
+    emit loadFailed();
+}
 
-    const int n = poly.size();
-    for (int i = 0; i < n; ++i) {
-        QPointF S = poly[i];
-        QPointF E = poly[(i + 1) % n];
+// ---------- запуск алгоритмов ----------
+
+void ClippingCanvas::setSegmentAlgorithm(clip::SegmentAlgorithm algorithm)
+{
+    if (segmentEngine->algorithm() == algorithm)
+        return;
 
-        bool Sin = insideEdge(S, edge);
-        bool Ein = insideEdge(E, edge);
+    segmentEngine = clip::createSegmentEngine(algorithm);
+    if (currentMode == Mode::Segments)
+        startSegmentClipJob();
+}
 
-        if (Sin && Ein) {
-            // 1) внутри -> внутри: добавляем E
-            out.append(E);
-        } else if (Sin && !Ein) {
-            // 2) внутри -> вне: добавляем точку пересечения
-            QPointF I = intersectWithEdge(S, E, edge);
-            intersectionPointsPolygon.append(I);
-            out.append(I);
-        } else if (!Sin && Ein) {
-            // 3) вне -> внутри: добавляем пересечение и E
-            QPointF I = intersectWithEdge(S, E, edge);
-            intersectionPointsPolygon.append(I);
-            out.append(I);
-            out.append(E);
-        } else {
-            // 4) вне -> вне: ничего
-        }
+void ClippingCanvas::setBatchedPainting(bool on)
+{
+    batched = on;
+    update();
+}
+
+clip::SegmentAlgorithm ClippingCanvas::segmentAlgorithm() const
+{
+    return segmentEngine->algorithm();
+}
+
+void ClippingCanvas::updateIntersectionPoints()
+{
+    intersectionPoints.clear();
+    for (qsizetype i = 0; i < incremental.size(); ++i) {
+        const QPointF *points;
+        const int n = incremental.intersections(i, points);
+        for (int k = 0; k < n; ++k)
+            intersectionPoints.append(points[k]);
     }
-    return out;
+    hoverPoints.clear();
+    hoverPoints.insert(intersectionPoints);
 }
 
 void ClippingCanvas::clipPolygonSutherlandHodgman()
 {
-    intersectionPointsPolygon.clear();
-    polygonClipped = polygonOriginal;
-    if (!hasWindow || polygonClipped.isEmpty())
+    if (!hasWindow) {
+        polygonClip.polygon = polygonOriginal;
+        polygonClip.intersections.clear();
+        hoverPoints.clear();
         return;
+    }
 
-    polygonClipped = clipAgainstEdge(polygonClipped, Edge::Left);
-    polygonClipped = clipAgainstEdge(polygonClipped, Edge::Right);
-    polygonClipped = clipAgainstEdge(polygonClipped, Edge::Bottom);
-    polygonClipped = clipAgainstEdge(polygonClipped, Edge::Top);
+    // пишем в те же буферы: повторное отсечение не выделяет память
+    if (convexWindow.isRect())
+        clip::clipPolygonSutherlandHodgman(polygonOriginal, clipWindow, polygonClip);
+    else
+        clip::clipPolygonSutherlandHodgman(polygonOriginal, convexWindow, polygonClip);
+
+    hoverPoints.clear();
+    hoverPoints.insert(polygonClip.intersections);
+}
+
+void ClippingCanvas::clipPolylineChains()
+{
+    if (!hasWindow) {
+        polylineClip.clear();
+        hoverPoints.clear();
+        return;
+    }
+
+    if (convexWindow.isRect())
+        clip::clipPolylines(polylineOriginal, clipWindow, polylineClip);
+    else
+        clip::clipPolylines(polylineOriginal, convexWindow, polylineClip);
+
+    hoverPoints.clear();
+    hoverPoints.insert(polylineClip.intersections);
 }
 
 // ---------- отрисовка ----------
 
-void ClippingCanvas::drawGridAndAxes(QPainter &p)
+// area — рисуемая область в координатах виджета (может выходить за него)
+void ClippingCanvas::drawGridAndAxes(QPainter &p, const QRect &area)
 {
     // фон
-    p.fillRect(rect(), Qt::white);
+    p.fillRect(area, Qt::white);
 
     // ---------- Сетка ----------
     p.save();
 
-    // логические границы области, которую видим
-    QPointF gLT = screenToGridF(QPoint(0, 0));
-    QPointF gRB = screenToGridF(QPoint(width(), height()));
+    // логические границы области, которую рисуем
+    QPointF gLT = screenToGridF(area.topLeft());
+    QPointF gRB = screenToGridF(area.bottomRight() + QPoint(1, 1));
     int gxMin = std::floor(std::min(gLT.x(), gRB.x()));
     int gxMax = std::ceil (std::max(gLT.x(), gRB.x()));
     int gyMin = std::floor(std::min(gLT.y(), gRB.y()));
@@ -380,8 +645,8 @@ void ClippingCanvas::drawGridAndAxes(QPainter &p)
     qreal ox = originPx().x() + panPx.x();
     qreal oy = originPx().y() + panPx.y();
 
-    p.drawLine(QPointF(0, oy), QPointF(width(), oy));   // ось X
-    p.drawLine(QPointF(ox, 0), QPointF(ox, height()));  // ось Y
+    p.drawLine(QPointF(area.left(), oy), QPointF(area.right() + 1, oy));   // ось X
+    p.drawLine(QPointF(ox, area.top()), QPointF(ox, area.bottom() + 1));   // ось Y
     p.restore();
 
     // ---------- Подписи делений ----------
@@ -416,13 +681,55 @@ void ClippingCanvas::drawGridAndAxes(QPainter &p)
 }
 
 
+void ClippingCanvas::drawBackground(QPainter &p)
+{
+    const QPointF shift = panPx - gridCachePan;
+    const bool valid = !gridCache.isNull() &&
+                       gridCacheCell == cellSize &&
+                       gridCacheSize == size() &&
+                       std::abs(shift.x()) <= kGridCacheMargin &&
+                       std::abs(shift.y()) <= kGridCacheMargin;
+
+    if (!valid) {
+        const qreal dpr = devicePixelRatioF();
+        const QRect area = rect().adjusted(-kGridCacheMargin, -kGridCacheMargin,
+                                           kGridCacheMargin, kGridCacheMargin);
+        gridCache = QPixmap(area.size() * dpr);
+        gridCache.setDevicePixelRatio(dpr);
+
+        QPainter cp(&gridCache);
+        cp.translate(-area.topLeft());
+        drawGridAndAxes(cp, area);
+
+        gridCachePan = panPx;
+        gridCacheCell = cellSize;
+        gridCacheSize = size();
+    }
+
+    // сетка и подписи сдвигаются вместе с panPx целиком
+    p.drawPixmap(QPointF(-kGridCacheMargin, -kGridCacheMargin) + panPx - gridCachePan,
+                 gridCache);
+}
+
 void ClippingCanvas::paintEvent(QPaintEvent *)
 {
+    CLIP_STAT_TIMER(Paint);
+    QElapsedTimer timer;
+    timer.start();
+
     QPainter p(this);
-    drawGridAndAxes(p);
+    drawBackground(p);
 
     // --- окно отсечения ---
-    if (hasWindow) {
+    if (hasWindow && !convexWindow.isRect()) {
+        p.save();
+        p.setPen(QPen(Qt::blue, 2));
+        QPolygonF outline;
+        for (const QPointF &v : convexWindow.vertices())
+            outline.append(gridToScreenF(v));
+        p.drawPolygon(outline);
+        p.restore();
+    } else if (hasWindow) {
         p.save();
         p.setPen(QPen(Qt::blue, 2));
         QPointF tl = gridToScreenF(clipWindow.topLeft());
@@ -435,13 +742,204 @@ void ClippingCanvas::paintEvent(QPaintEvent *)
         p.restore();
     }
 
-    // --- режим: отрезки (Midpoint subdivision) ---
-    if (currentMode == Mode::SegmentsMidpoint) {
+    if (batched)
+        drawScene(p);
+    else
+        drawScenePerPrimitive(p);
+
+    p.end();
+    emit frameRendered(timer.nsecsElapsed() / 1e6);
+}
+
+// ---------- пакетная отрисовка ----------
+
+void ClippingCanvas::updateScreenCache()
+{
+    const QPointF shift = panPx - screen.pan;
+    if (screen.valid &&
+        screen.cell == cellSize &&
+        screen.size == size() &&
+        std::abs(shift.x()) <= kGridCacheMargin &&
+        std::abs(shift.y()) <= kGridCacheMargin)
+        return;
+
+    screen.cell = cellSize;
+    screen.pan = panPx;
+    screen.size = size();
+    screen.origin = originPx() + panPx;
+    screen.valid = true;
+
+    // запас: сдвиг в пределах kGridCacheMargin, толщина пера и радиус точек
+    const QRectF view = visibleGridRect(kGridCacheMargin + 6);
+    screen.view = view;
+
+    // Многоугольник сначала отсекается видимой областью (шаблон
+    // Сазерленда–Ходжмана для QPointF): при сильном увеличении вершины не
+    // уходят в огромные экранные координаты, а новые рёбра по краю области
+    // остаются за пределами виджета.
+    auto polygonToScreen = [this, &view](const QVector<QPointF> &in, QPolygonF &out) {
+        QVector<QPointF> &visible = screen.polygonVisible;
+        visible.clear();
+        clip::generic::Discard<QPointF> noPoints;
+        clip::generic::appendPolygonSutherlandHodgman(in.constData(), size_t(in.size()),
+                                                      clip::generic::boxOf(view),
+                                                      visible, noPoints);
+        out.resize(visible.size());
+        for (qsizetype i = 0; i < visible.size(); ++i)
+            out[i] = screen.map(visible[i]);
+    };
+
+    // ломаные — так же: подцепочки в view, затем в пиксели; смещения
+    // подцепочек не меняются
+    auto polylinesToScreen = [this, &view](const clip::PolylineSet &in, clip::PolylineSet &out) {
+        clip::PolylineClipResult &visible = screen.polylineVisible;
+        clip::clipPolylines(in, view, visible);
+        out.offsets = visible.chains.offsets;
+        out.vertices.resize(visible.chains.vertices.size());
+        for (qsizetype i = 0; i < out.vertices.size(); ++i)
+            out.vertices[i] = screen.map(visible.chains.vertices[i]);
+    };
+
+    screen.original.clear();
+    screen.clipped.clear();
+    screen.points.clear();
+
+    if (progressive) {
+        // задание не завершено: исходные — по сетке, готовые пачки — все
+        progressIndex.query(view, visibleIds);
+        for (quint32 id : std::as_const(visibleIds))
+            screen.original.append(screen.map(segmentsOriginal[id]));
+        for (const QLineF &s : std::as_const(progressClipped)) {
+            if (view.intersects(QRectF(s.p1(), s.p2()).normalized()))
+                screen.clipped.append(screen.map(s));
+        }
+        for (const QPointF &pt : std::as_const(intersectionPoints)) {
+            if (view.contains(pt))
+                screen.points.append(screen.map(pt));
+        }
+    } else {
+        // видимая часть и точки лежат на исходном отрезке, поэтому
+        // хватает одного запроса по исходным
+        incremental.index().query(view, visibleIds);
+        for (quint32 id : std::as_const(visibleIds)) {
+            screen.original.append(screen.map(segmentsOriginal[id]));
+
+            QLineF fragment;
+            if (incremental.visible(id, fragment))
+                screen.clipped.append(screen.map(fragment));
+
+            const QPointF *points;
+            const int n = incremental.intersections(id, points);
+            for (int k = 0; k < n; ++k)
+                screen.points.append(screen.map(points[k]));
+        }
+    }
+
+    polygonToScreen(currentMode == Mode::PolygonSuthHodg ? polygonOriginal
+                                                         : QVector<QPointF>(),
+                    screen.polygonOriginal);
+    polygonToScreen(polygonClip.polygon, screen.polygonClipped);
+
+    screen.polygonPoints.clear();
+    for (const QPointF &pt : std::as_const(polygonClip.intersections)) {
+        if (view.contains(pt))
+            screen.polygonPoints.append(screen.map(pt));
+    }
+
+    screen.polylineOriginal.clear();
+    screen.polylineClipped.clear();
+    screen.polylinePoints.clear();
+    if (currentMode == Mode::Polylines) {
+        polylinesToScreen(polylineOriginal, screen.polylineOriginal);
+        polylinesToScreen(polylineClip.chains, screen.polylineClipped);
+        for (const QPointF &pt : std::as_const(polylineClip.intersections)) {
+            if (view.contains(pt))
+                screen.polylinePoints.append(screen.map(pt));
+        }
+    }
+}
+
+void ClippingCanvas::drawScene(QPainter &p)
+{
+    updateScreenCache();
+
+    // буферы построены для screen.pan; малый сдвиг — переносом
+    p.save();
+    p.translate(panPx - screen.pan);
+
+    // кружки точек пересечения — круглые точки толстого пера
+    auto drawDots = [&p](const QPolygonF &points, const QColor &color) {
+        if (points.isEmpty())
+            return;
+        p.save();
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setPen(QPen(color, 10, Qt::SolidLine, Qt::RoundCap));
+        p.drawPoints(points);
+        p.restore();
+    };
+
+    if (currentMode == Mode::Segments) {
+        p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        p.drawLines(screen.original);
+
+        p.setPen(QPen(Qt::red, 2));
+        p.drawLines(screen.clipped);
+    }
+
+    if (currentMode == Mode::PolygonSuthHodg) {
+        p.setPen(QPen(QColor(200, 80, 80), 2, Qt::DashLine));
+        p.setBrush(Qt::NoBrush);
+        if (!screen.polygonOriginal.isEmpty())
+            p.drawPolygon(screen.polygonOriginal);
+
+        drawDots(screen.polygonPoints, QColor(120, 150, 255, 200));
+
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setPen(QPen(QColor(0, 150, 0), 3));
+        p.setBrush(QColor(0, 150, 0, 40));
+        if (!screen.polygonClipped.isEmpty())
+            p.drawPolygon(screen.polygonClipped);
+    }
+
+    if (currentMode == Mode::Segments)
+        drawDots(screen.points, QColor(255, 120, 120, 180));
+
+    // подцепочка — один вызов drawPolyline по диапазону общего буфера
+    if (currentMode == Mode::Polylines) {
+        auto drawChains = [&p](const clip::PolylineSet &chains) {
+            for (qsizetype i = 0; i < chains.count(); ++i)
+                p.drawPolyline(chains.polygon(i), int(chains.size(i)));
+        };
+
+        p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        drawChains(screen.polylineOriginal);
+
+        p.setPen(QPen(Qt::red, 2));
+        drawChains(screen.polylineClipped);
+
+        drawDots(screen.polylinePoints, QColor(255, 120, 120, 180));
+    }
+
+    p.restore();
+}
+
+// ---------- отрисовка по одному примитиву ----------
+
+void ClippingCanvas::drawScenePerPrimitive(QPainter &p)
+{
+    // --- режим: отрезки ---
+    if (currentMode == Mode::Segments) {
+
+        // рисуется только то, что индекс нашёл в видимой области
+        const QRectF view = visibleGridRect(2);
+
+        (progressive ? progressIndex : incremental.index()).query(view, visibleIds);
 
         // исходные отрезки — пунктир, серые
         p.save();
         p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
-        for (const QLineF &s : std::as_const(segmentsOriginal)) {
+        for (quint32 id : std::as_const(visibleIds)) {
+            const QLineF &s = segmentsOriginal[id];
             p.drawLine(gridToScreenF(s.p1()), gridToScreenF(s.p2()));
         }
         p.restore();
@@ -449,8 +947,15 @@ void ClippingCanvas::paintEvent(QPaintEvent *)
         // видимые части — красные
         p.save();
         p.setPen(QPen(Qt::red, 2));
-        for (const QLineF &s : std::as_const(segmentsClipped)) {
-            p.drawLine(gridToScreenF(s.p1()), gridToScreenF(s.p2()));
+        if (progressive) {
+            for (const QLineF &s : std::as_const(progressClipped))
+                p.drawLine(gridToScreenF(s.p1()), gridToScreenF(s.p2()));
+        } else {
+            for (quint32 id : std::as_const(visibleIds)) {
+                QLineF s;
+                if (incremental.visible(id, s))
+                    p.drawLine(gridToScreenF(s.p1()), gridToScreenF(s.p2()));
+            }
         }
         p.restore();
     }
@@ -474,7 +979,7 @@ void ClippingCanvas::paintEvent(QPaintEvent *)
         p.setBrush(QColor(120, 150, 255, 200)); // нежно-синий
         p.setPen(Qt::NoPen);
 
-        for (const QPointF &pt : intersectionPointsPolygon) {
+        for (const QPointF &pt : polygonClip.intersections) {
             QPointF S = gridToScreenF(pt);
             p.drawEllipse(S, 5, 5);
         }
@@ -484,35 +989,144 @@ void ClippingCanvas::paintEvent(QPaintEvent *)
         p.save();
         p.setPen(QPen(QColor(0, 150, 0), 3));
         p.setBrush(QColor(0, 150, 0, 40));
-        if (!polygonClipped.isEmpty()) {
+        if (!polygonClip.polygon.isEmpty()) {
             QPainterPath path;
-            path.moveTo(gridToScreenF(polygonClipped[0]));
-            for (int i = 1; i < polygonClipped.size(); ++i)
-                path.lineTo(gridToScreenF(polygonClipped[i]));
+            path.moveTo(gridToScreenF(polygonClip.polygon[0]));
+            for (int i = 1; i < polygonClip.polygon.size(); ++i)
+                path.lineTo(gridToScreenF(polygonClip.polygon[i]));
             path.closeSubpath();
             p.drawPath(path);
         }
         p.restore();
     }
 
-    // --- точки пересечения (только для Midpoint) ---
-    if (currentMode == Mode::SegmentsMidpoint) {
+    // --- точки пересечения (только для отрезков) ---
+    if (currentMode == Mode::Segments) {
         p.save();
         p.setRenderHint(QPainter::Antialiasing, true);
         p.setBrush(QColor(255, 120, 120, 180));  // мягкий красный
         p.setPen(Qt::NoPen);
 
-        for (const QPointF &pt : intersectionPoints) {
-            QPointF S = gridToScreenF(pt);
-            p.drawEllipse(S, 5, 5); // аккуратный кружочек
+        if (progressive) {
+            for (const QPointF &pt : std::as_const(intersectionPoints))
+                p.drawEllipse(gridToScreenF(pt), 5, 5);
+        } else {
+            incremental.index().query(visibleGridRect(6), visibleIds);
+            for (quint32 id : std::as_const(visibleIds)) {
+                const QPointF *points;
+                const int n = incremental.intersections(id, points);
+                for (int k = 0; k < n; ++k)
+                    p.drawEllipse(gridToScreenF(points[k]), 5, 5); // аккуратный кружочек
+            }
         }
 
         p.restore();
     }
+
+    // --- режим: ломаные, по ребру ---
+    if (currentMode == Mode::Polylines) {
+        auto drawEdges = [this, &p](const clip::PolylineSet &chains) {
+            for (qsizetype i = 0; i < chains.count(); ++i) {
+                const QPointF *v = chains.polygon(i);
+                for (qsizetype k = 1; k < chains.size(i); ++k)
+                    p.drawLine(gridToScreenF(v[k - 1]), gridToScreenF(v[k]));
+            }
+        };
+
+        p.save();
+        p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        drawEdges(polylineOriginal);
+        p.setPen(QPen(Qt::red, 2));
+        drawEdges(polylineClip.chains);
+
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setBrush(QColor(255, 120, 120, 180));
+        p.setPen(Qt::NoPen);
+        for (const QPointF &pt : std::as_const(polylineClip.intersections))
+            p.drawEllipse(gridToScreenF(pt), 5, 5);
+        p.restore();
+    }
 }
 
 
 
+// ---------- редактирование окна отсечения ----------
+
+// что под курсором: набор граней (угол — две) или GripMove внутри окна
+int ClippingCanvas::windowGripAt(const QPointF &pos) const
+{
+    // окно-многоугольник не редактируется
+    if (!hasWindow || currentMode == Mode::None || !convexWindow.isRect())
+        return 0;
+
+    // Y вверх: ymin — нижняя грань на экране, ymax — верхняя
+    const QPointF lb = gridToScreenF(QPointF(clipWindow.left(), clipWindow.top()));
+    const QPointF rt = gridToScreenF(QPointF(clipWindow.right(), clipWindow.bottom()));
+    if (pos.x() < lb.x() - kGripPx || pos.x() > rt.x() + kGripPx ||
+        pos.y() < rt.y() - kGripPx || pos.y() > lb.y() + kGripPx)
+        return 0;
+
+    int grip = 0;
+    if (std::abs(pos.x() - lb.x()) <= kGripPx)
+        grip |= GripLeft;
+    else if (std::abs(pos.x() - rt.x()) <= kGripPx)
+        grip |= GripRight;
+    if (std::abs(pos.y() - lb.y()) <= kGripPx)
+        grip |= GripBottom;
+    else if (std::abs(pos.y() - rt.y()) <= kGripPx)
+        grip |= GripTop;
+
+    return grip ? grip : GripMove;
+}
+
+void ClippingCanvas::updateGripCursor(int grip)
+{
+    switch (grip) {
+    case GripLeft:
+    case GripRight:
+        setCursor(Qt::SizeHorCursor);
+        break;
+    case GripBottom:
+    case GripTop:
+        setCursor(Qt::SizeVerCursor);
+        break;
+    case GripLeft | GripTop:
+    case GripRight | GripBottom:
+        setCursor(Qt::SizeFDiagCursor);
+        break;
+    case GripLeft | GripBottom:
+    case GripRight | GripTop:
+        setCursor(Qt::SizeBDiagCursor);
+        break;
+    case GripMove:
+        setCursor(Qt::SizeAllCursor);
+        break;
+    default:
+        unsetCursor();
+    }
+}
+
+void ClippingCanvas::moveClipWindow(const QRectF &window)
+{
+    if (window == clipWindow)
+        return;
+    clipWindow = window;
+
+    // отрезки — пересчёт только задетых; многоугольник и ломаные — целиком,
+    // в те же буферы
+    if (currentMode == Mode::Segments && progressive)
+        startSegmentClipJob();          // отменяет идущее задание
+    else if (currentMode == Mode::Segments)
+        incremental.setWindow(clipWindow);
+    else if (currentMode == Mode::PolygonSuthHodg)
+        clipPolygonSutherlandHodgman();
+    else if (currentMode == Mode::Polylines)
+        clipPolylineChains();
+
+    invalidateScreenCache();
+    update();
+}
+
 // ---------- взаимодействие мышью / зум ----------
 
 void ClippingCanvas::mouseMoveEvent(QMouseEvent *e)
@@ -524,48 +1138,44 @@ void ClippingCanvas::mouseMoveEvent(QMouseEvent *e)
         return;
     }
 
-    QPointF g = screenToGridF(e->pos());
-    bool hovering = false;
-
-    // --- точки пересечения отрезков ---
-    for (const QPointF &pt : intersectionPoints) {
-        QPointF S = gridToScreenF(pt);
-        if (QLineF(S, e->pos()).length() < 8) {
-
-            QToolTip::showText(
-                e->globalPosition().toPoint(),
-                QString("(%1, %2)").arg(pt.x(), 0, 'f', 2)
-                    .arg(pt.y(), 0, 'f', 2),
-                this
-                );
-
-            hovering = true;
-            break;
+    if (dragGrip) {
+        const QPointF d = screenToGridF(e->position()) - dragStartGrid;
+        const double minSize = 2 * kGripPx / cellSize;
+        double xmin = dragStartWindow.left(),  xmax = dragStartWindow.right();
+        double ymin = dragStartWindow.top(),   ymax = dragStartWindow.bottom();
+
+        if (dragGrip == GripMove) {
+            xmin += d.x(); xmax += d.x();
+            ymin += d.y(); ymax += d.y();
+        } else {
+            // противоположная грань остаётся на месте, окно не выворачивается
+            if (dragGrip & GripLeft)   xmin = std::min(xmin + d.x(), xmax - minSize);
+            if (dragGrip & GripRight)  xmax = std::max(xmax + d.x(), xmin + minSize);
+            if (dragGrip & GripBottom) ymin = std::min(ymin + d.y(), ymax - minSize);
+            if (dragGrip & GripTop)    ymax = std::max(ymax + d.y(), ymin + minSize);
         }
-    }
 
-    // --- если не нашли в отрезках → проверяем многоугольник ---
-    if (!hovering) {
-        for (const QPointF &pt : intersectionPointsPolygon) {
-            QPointF S = gridToScreenF(pt);
-            if (QLineF(S, e->pos()).length() < 8) {
+        moveClipWindow(QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax)));
+        emit cursorGridPosChanged(screenToGridF(e->pos()));
+        return;
+    }
 
-                QToolTip::showText(
-                    e->globalPosition().toPoint(),
-                    QString("(%1, %2)").arg(pt.x(), 0, 'f', 2)
-                        .arg(pt.y(), 0, 'f', 2),
-                    this
-                    );
+    updateGripCursor(windowGripAt(e->position()));
 
-                hovering = true;
-                break;
-            }
-        }
-    }
+    QPointF g = screenToGridF(e->pos());
 
-    // --- если ни одна точка не подсвечена → скрыть tooltip ---
-    if (!hovering)
+    // --- точка пересечения под курсором (отрезков или многоугольника) ---
+    QPointF pt;
+    if (hoverPoints.nearest(g, kHoverPx / cellSize, pt)) {
+        QToolTip::showText(
+            e->globalPosition().toPoint(),
+            QString("(%1, %2)").arg(pt.x(), 0, 'f', 2)
+                .arg(pt.y(), 0, 'f', 2),
+            this
+            );
+    } else {
         QToolTip::hideText();
+    }
 
     emit cursorGridPosChanged(g);
 }
@@ -577,13 +1187,27 @@ void ClippingCanvas::mousePressEvent(QMouseEvent *e)
     if (e->button() == Qt::RightButton) {
         panning = true;
         lastMouse = e->pos();
+    } else if (e->button() == Qt::LeftButton) {
+        dragGrip = windowGripAt(e->position());
+        if (dragGrip) {
+            dragStartGrid = screenToGridF(e->position());
+            dragStartWindow = clipWindow;
+            QToolTip::hideText();
+        }
     }
 }
 
 void ClippingCanvas::mouseReleaseEvent(QMouseEvent *e)
 {
-    if (e->button() == Qt::RightButton)
+    if (e->button() == Qt::RightButton) {
         panning = false;
+    } else if (e->button() == Qt::LeftButton && dragGrip) {
+        // точки для подсказок собираются один раз, по окончании
+        dragGrip = 0;
+        if (currentMode == Mode::Segments && !progressive)
+            updateIntersectionPoints();
+        updateGripCursor(windowGripAt(e->position()));
+    }
 }
 
 void ClippingCanvas::wheelEvent(QWheelEvent *e)
@@ -602,50 +1226,3 @@ void ClippingCanvas::wheelEvent(QWheelEvent *e)
     update();
 }
 
-
-QVector<QPointF> ClippingCanvas::findRealIntersections(const QPointF &A, const QPointF &B)
-{
-    QVector<QPointF> pts;
-
-    auto intersect = [&](const QPointF &P1, const QPointF &P2,
-                         const QPointF &Q1, const QPointF &Q2,
-                         QPointF &R) -> bool
-    {
-        QLineF line1(P1, P2);
-        QLineF line2(Q1, Q2);
-        QPointF ip;
-        if (line1.intersects(line2, &ip) == QLineF::BoundedIntersection) {
-            R = ip;
-            return true;
-        }
-        return false;
-    };
-
-    QPointF R;
-
-    // левая грань
-    if (intersect(A, B,
-                  QPointF(clipWindow.left(), clipWindow.top()),
-                  QPointF(clipWindow.left(), clipWindow.bottom()), R))
-        pts.append(R);
-
-    // правая грань
-    if (intersect(A, B,
-                  QPointF(clipWindow.right(), clipWindow.top()),
-                  QPointF(clipWindow.right(), clipWindow.bottom()), R))
-        pts.append(R);
-
-    // верхняя грань
-    if (intersect(A, B,
-                  QPointF(clipWindow.left(), clipWindow.top()),
-                  QPointF(clipWindow.right(), clipWindow.top()), R))
-        pts.append(R);
-
-    // нижняя грань
-    if (intersect(A, B,
-                  QPointF(clipWindow.left(), clipWindow.bottom()),
-                  QPointF(clipWindow.right(), clipWindow.bottom()), R))
-        pts.append(R);
-
-    return pts;
-}
@@ -1,24 +1,78 @@
 #pragma once
 #include <QWidget>
+#include <QPixmap>
+#include <QPolygonF>
 #include <QVector>
 #include <QLineF>
 #include <QRectF>
+#include <QList>
+#include <atomic>
+#include <memory>
+#include "clipcore/segmentengine.h"
+#include "clipcore/polygonclipper.h"
+#include "clipcore/incrementalclipper.h"
+#include "clipcore/clipio.h"
+#include "clipcore/pointhash.h"
+#include "clipcore/resultexport.h"
+
+class QThread;
 
 class ClippingCanvas : public QWidget
 {
     Q_OBJECT
 public:
     explicit ClippingCanvas(QWidget *parent = nullptr);
+    ~ClippingCanvas() override;
+
+    // Загрузка идёт в фоновом потоке: разбор файла, затем отсечение
+    // пачками, которые показываются по мере готовности. Новая загрузка,
+    // смена окна или алгоритма отменяют незавершённое задание. Об ошибке
+    // сообщает loadFailed().
+    void loadSegmentsFromFile(const QString &fileName);
+    void loadPolygonFromFile(const QString &fileName);
+    void loadPolylinesFromFile(const QString &fileName);
 
-    bool loadSegmentsFromFile(const QString &fileName);
+    // описание ошибки последней неудачной загрузки (строка:столбец: причина)
+    QString lastLoadError() const { return loadError; }
 
-    bool loadPolygonFromFile(const QString &fileName);
+    // остановить фоновое задание; готовая часть остаётся на экране
+    void cancelJob();
+    bool isBusy() const { return jobRunning; }
 
     void clearAll();
 
+    // Запись текущего результата отсечения (видимые части, окно и точки
+    // пересечения) прямо из буферов холста; формат — по расширению
+    // fileName (см. clipcore/resultexport.h). Пишется фоновым заданием,
+    // как идёт загрузка; отмена задания (кнопкой, новой загрузкой, сменой
+    // алгоритма) прерывает запись и удаляет файл. Каждая запись кончается
+    // ровно одним exportFinished(). false — результата нет, причина в error.
+    bool exportResult(const QString &fileName, QString *error = nullptr);
+
+    // выбор алгоритма отсечения отрезков; текущая сцена пересчитывается
+    void setSegmentAlgorithm(clip::SegmentAlgorithm algorithm);
+    clip::SegmentAlgorithm segmentAlgorithm() const;
+
+    // пакетная отрисовка из экранных буферов (по умолчанию) или прежняя,
+    // по одному вызову на примитив — для сравнения времени кадра
+    void setBatchedPainting(bool on);
+    bool batchedPainting() const { return batched; }
+
 signals:
     void cursorGridPosChanged(const QPointF &logicalPos);
 
+    // время последнего paintEvent, мс
+    void frameRendered(double ms);
+
+    // фоновое задание началось / закончилось (или отменено)
+    void busyChanged(bool busy);
+    // отсечено done отрезков из total; total == 0 — идёт разбор файла
+    void jobProgress(qint64 done, qint64 total);
+    void loadFailed();
+    // запись exportResult() закончена: error пуст — успешно; cancelled —
+    // прервана отменой задания, файла нет
+    void exportFinished(const QString &fileName, const QString &error, bool cancelled);
+
 protected:
     void paintEvent(QPaintEvent *) override;
     void mouseMoveEvent(QMouseEvent *) override;
@@ -33,9 +87,13 @@ private:
     bool   panning = false;
     QPoint lastMouse;
     QVector<QPointF> intersectionPoints;
-    QVector<QPointF> intersectionPointsPolygon;
 
-    QVector<QPointF> findRealIntersections(const QPointF &A, const QPointF &B);
+    // Точки пересечения (отрезков или многоугольника) для подсказок под
+    // курсором. Ячейка — одна клетка сетки: при наименьшем масштабе круг
+    // kHoverPx задевает не больше 5 × 5 ячеек. Строится заново после
+    // отсечения, точки пачек фонового задания дописываются.
+    static constexpr qreal kHoverPx = 8;
+    clip::PointHash hoverPoints { 1.0 };
 
     QPointF originPx() const;
     QPointF gridToScreenF(QPointF g) const;
@@ -43,41 +101,159 @@ private:
     QPointF screenToGridF(QPointF s) const;
     QPointF screenToGridF(QPoint s) const;
 
+    // видимая область в логических координатах, с запасом margin пикселей
+    QRectF  visibleGridRect(qreal margin = 0) const;
+
     // --- данные для отрезков ---
     QVector<QLineF> segmentsOriginal;
-    QVector<QLineF> segmentsClipped;
+
+    // результат по каждому отрезку: при перемещении окна пересчитываются
+    // только задетые отрезки; его сетка отбирает видимое в paintEvent
+    clip::IncrementalClipper incremental;
+    QVector<quint32> visibleIds;
+
+    // Пока фоновое задание не отдало готовый incremental, отрезки рисуются
+    // отсюда: сетка исходных и видимые части уже пришедших пачек (точки —
+    // в intersectionPoints). Пачки приходят очередными вызовами в поток
+    // GUI, поэтому paintEvent читает только свои буферы, без блокировок.
+    bool            progressive = false;
+    clip::GridIndex progressIndex;
+    QVector<QLineF> progressClipped;
+
+    // --- фоновое задание ---
+    struct SegmentJobResult;
+    struct ExportJob;
+    static constexpr qsizetype kJobBatchSize = 1 << 16;   // отрезков в пачке
+    quint64 jobGeneration = 0;     // результаты прежних заданий отбрасываются
+    std::shared_ptr<std::atomic_bool> jobCancel;
+    bool jobRunning = false;
+    QList<QThread *> jobThreads;   // ещё не завершившиеся, в т.ч. отменённые
+
+    template<class Work> void startJob(Work work);
+    template<class Fn> void post(quint64 generation, Fn fn);
+    void stopJob();
+    void setJobRunning(bool on);
+
+    // выполняются в фоновом потоке
+    void clipSegmentsInBatches(quint64 generation, const std::atomic_bool &cancel,
+                               std::shared_ptr<SegmentJobResult> job);
+
+    // выполняются в потоке GUI
+    void startSegmentClipJob();
+    void showLoadedSegments(const clip::SegmentScene &scene,
+                            const clip::GridIndex &index);
+    void appendSegmentBatch(const QVector<QLineF> &visible,
+                            const QVector<QPointF> &points,
+                            qsizetype done, qsizetype total);
+    void finishSegmentJob(const std::shared_ptr<SegmentJobResult> &job);
+    void showLoadedPolygon(const clip::PolygonScene &scene,
+                           const clip::PolygonClipResult &result);
+    void showLoadedPolylines(const clip::PolylineScene &scene,
+                             const clip::PolylineClipResult &result);
+    void failJob(const QString &message);
 
     // --- данные для многоугольников ---
     QVector<QPointF> polygonOriginal;
-    QVector<QPointF> polygonClipped;
+    clip::PolygonClipResult polygonClip;   // результат и точки пересечения;
+                                           // буферы переиспользуются
+
+    // --- данные для ломаных ---
+    clip::PolylineSet        polylineOriginal;
+    clip::PolylineClipResult polylineClip;  // видимые подцепочки и точки входа/выхода
+
+    QString loadError;
 
     // --- окно отсечения ---
     QRectF clipWindow;
     bool   hasWindow = false;
 
+    // Окно-многоугольник из файла (clipWindow — его ограничивающий
+    // прямоугольник). Пока convexWindow.isRect(), окно задаёт clipWindow.
+    // Такое окно мышью не редактируется, а отрезки остаются в пачках
+    // (progressive): IncrementalClipper работает только с прямоугольником.
+    clip::ConvexWindow convexWindow;
+
+    // --- перетаскивание окна левой кнопкой: за грань, угол или целиком ---
+    enum WindowGrip {
+        GripLeft   = 1,     // xmin
+        GripRight  = 2,     // xmax
+        GripBottom = 4,     // ymin
+        GripTop    = 8,     // ymax
+        GripMove   = 16     // внутри окна — перенос
+    };
+    static constexpr qreal kGripPx = 6;    // допуск попадания в грань
+    int     dragGrip = 0;
+    QPointF dragStartGrid;
+    QRectF  dragStartWindow;
+
+    int  windowGripAt(const QPointF &pos) const;
+    void updateGripCursor(int grip);
+    void moveClipWindow(const QRectF &window);
+
     // --- режимы ---
-    enum class Mode { None, SegmentsMidpoint, PolygonSuthHodg };
+    enum class Mode { None, Segments, PolygonSuthHodg, Polylines };
     Mode currentMode = Mode::None;
 
-    // === Алгоритм средней точки (отрезки) ===
-    void clipAllSegmentsMidpoint();
-    void clipMidpoint(const QPointF &A,
-                      const QPointF &B,
-                      QVector<QLineF> &outLines) const;
-
-    bool segOutside(const QPointF &A, const QPointF &B) const;
-    bool pointInside(const QPointF &P) const;
+    // === Отрезки: средняя точка / Коэн–Сазерленд / Лианг–Барски ===
+    std::unique_ptr<clip::SegmentEngine> segmentEngine;
+    void updateIntersectionPoints();   // intersectionPoints из incremental
 
-    // === Сазерленд–Ходжман (многоугольник) ===
+    // === Сазерленд–Ходжман (многоугольник), см. clipcore/polygonclipper ===
     void clipPolygonSutherlandHodgman();
 
-    enum class Edge { Left, Right, Bottom, Top };
-    QVector<QPointF> clipAgainstEdge(const QVector<QPointF> &poly,
-                                     Edge edge);
-    bool insideEdge(const QPointF &P, Edge edge) const;
-    QPointF intersectWithEdge(const QPointF &S, const QPointF &E,
-                              Edge edge) const;
+    // === Ломаные: цепочка за один проход, см. clipcore/polylineclipper ===
+    void clipPolylineChains();
 
     // вспомогательное
-    void drawGridAndAxes(QPainter &p);
+    void drawGridAndAxes(QPainter &p, const QRect &area);
+
+    // --- кэш фона (сетка, оси, подписи) ---
+    // Рисуется с запасом kGridCacheMargin пикселей с каждой стороны;
+    // при сдвиге в пределах запаса выводится со смещением, перерисовывается
+    // только при смене масштаба, размера или большом сдвиге.
+    static constexpr int kGridCacheMargin = 256;
+    QPixmap gridCache;
+    QPointF gridCachePan;
+    qreal   gridCacheCell = 0;
+    QSize   gridCacheSize;
+    void drawBackground(QPainter &p);
+
+    // --- экранные буферы для пакетной отрисовки ---
+    // Видимые (с тем же запасом, что и у фона) примитивы, уже переведённые
+    // в пиксели. Пересчитываются при смене данных, масштаба, размера или
+    // большом сдвиге; малый сдвиг — перенос системы координат painter'а.
+    struct ScreenCache
+    {
+        QVector<QLineF>  original;
+        QVector<QLineF>  clipped;
+        QPolygonF        points;            // точки пересечения отрезков
+        QPolygonF        polygonOriginal;
+        QPolygonF        polygonClipped;
+        QPolygonF        polygonPoints;
+        QVector<QPointF> polygonVisible;    // многоугольник в view, логич. (буфер)
+        clip::PolylineSet polylineOriginal; // подцепочки в view, в пикселях
+        clip::PolylineSet polylineClipped;
+        QPolygonF        polylinePoints;
+        clip::PolylineClipResult polylineVisible;  // ломаные в view, логич. (буфер)
+        qreal            cell = 0;
+        QPointF          pan;
+        QSize            size;
+        QPointF          origin;            // originPx() + pan
+        QRectF           view;              // отобранная область, логич.
+        bool             valid = false;
+
+        // тот же перевод, что gridToScreenF, для pan
+        QPointF map(const QPointF &g) const
+        {
+            return QPointF(origin.x() + g.x() * cell, origin.y() - g.y() * cell);
+        }
+        QLineF map(const QLineF &s) const { return QLineF(map(s.p1()), map(s.p2())); }
+    };
+    ScreenCache screen;
+    bool batched = true;
+
+    void updateScreenCache();
+    void invalidateScreenCache() { screen.valid = false; }
+    void drawScene(QPainter &p);          // пакетно
+    void drawScenePerPrimitive(QPainter &p);
 };
@@ -1,11 +1,17 @@
 #include "mainwindow.h"
 #include "clippingcanvas.h"
+#include "clipcore/clipstats.h"
 
 #include <QMenuBar>
+#include <QActionGroup>
 #include <QStatusBar>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QFile>
+#include <QFileInfo>
 #include <QApplication>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -33,6 +39,67 @@ MainWindow::MainWindow(QWidget *parent)
                         .arg(pt.x(), 0, 'f', 2)
                         .arg(pt.y(), 0, 'f', 2));
             });
+
+    frameLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(frameLabel);
+    connect(canvas, &ClippingCanvas::frameRendered,
+            this, [this](double ms){
+                frameLabel->setText(QString("Кадр: %1 мс").arg(ms, 0, 'f', 2));
+                showStats();
+            });
+
+    // счётчики отсечения есть только в сборке с CLIP_ENABLE_STATS
+    if (clip::kStatsEnabled) {
+        statsLabel = new QLabel(this);
+        statusBar()->addPermanentWidget(statsLabel);
+    }
+
+    jobProgress = new QProgressBar(this);
+    jobProgress->setMaximumWidth(200);
+    jobProgress->setVisible(false);
+    jobCancel = new QPushButton("Отмена", this);
+    jobCancel->setVisible(false);
+    statusBar()->addPermanentWidget(jobProgress);
+    statusBar()->addPermanentWidget(jobCancel);
+
+    connect(jobCancel, &QPushButton::clicked,
+            canvas, &ClippingCanvas::cancelJob);
+    connect(canvas, &ClippingCanvas::busyChanged,
+            this, [this](bool busy){
+                jobProgress->setVisible(busy);
+                jobCancel->setVisible(busy);
+                showStats();
+            });
+    connect(canvas, &ClippingCanvas::jobProgress,
+            this, [this](qint64 done, qint64 total){
+                // пока разбирается файл, объём неизвестен — «бегущая» полоса
+                if (total <= 0) {
+                    jobProgress->setRange(0, 0);
+                } else {
+                    jobProgress->setRange(0, 1000);
+                    jobProgress->setValue(int(done * 1000 / total));
+                }
+            });
+    connect(canvas, &ClippingCanvas::loadFailed,
+            this, [this]{
+                QMessageBox::warning(this, "Ошибка",
+                                     loadFailureText + "\n\n" +
+                                     canvas->lastLoadError());
+            });
+    connect(canvas, &ClippingCanvas::exportFinished,
+            this, [this](const QString &fileName, const QString &error, bool cancelled){
+                if (cancelled) {
+                    statusBar()->showMessage("Экспорт в " + fileName + " отменён", 5000);
+                    return;
+                }
+                if (!error.isEmpty()) {
+                    statusBar()->clearMessage();
+                    QMessageBox::warning(this, "Ошибка",
+                                         "Не удалось экспортировать результат.\n\n" + error);
+                    return;
+                }
+                statusBar()->showMessage("Результат записан в " + fileName, 5000);
+            });
 }
 
 void MainWindow::createMenus()
@@ -48,6 +115,16 @@ void MainWindow::createMenus()
     connect(openPolyAct, &QAction::triggered,
             this, &MainWindow::openPolygonFile);
 
+    QAction *openChainAct = fileMenu->addAction("Открыть ломаные...");
+    connect(openChainAct, &QAction::triggered,
+            this, &MainWindow::openPolylineFile);
+
+    fileMenu->addSeparator();
+
+    QAction *exportAct = fileMenu->addAction("Экспорт результата...");
+    connect(exportAct, &QAction::triggered,
+            this, &MainWindow::exportResult);
+
     fileMenu->addSeparator();
 
     QAction *clearAct = fileMenu->addAction("Очистить");
@@ -57,6 +134,39 @@ void MainWindow::createMenus()
     fileMenu->addSeparator();
     fileMenu->addAction("Выход", this, &QWidget::close);
 
+    // --- Алгоритм (отрезки) ---
+    QMenu *algoMenu = menuBar()->addMenu("Алгоритм");
+    QActionGroup *algoGroup = new QActionGroup(this);
+    algoGroup->setExclusive(true);
+
+    const struct {
+        const char *title;
+        clip::SegmentAlgorithm algorithm;
+    } algorithms[] = {
+        { "Средняя точка",   clip::SegmentAlgorithm::Midpoint },
+        { "Коэн–Сазерленд",  clip::SegmentAlgorithm::CohenSutherland },
+        { "Лианг–Барски",    clip::SegmentAlgorithm::LiangBarsky },
+    };
+
+    for (const auto &a : algorithms) {
+        QAction *act = algoMenu->addAction(a.title);
+        act->setCheckable(true);
+        act->setChecked(canvas->segmentAlgorithm() == a.algorithm);
+        algoGroup->addAction(act);
+
+        const clip::SegmentAlgorithm algorithm = a.algorithm;
+        connect(act, &QAction::triggered,
+                this, [this, algorithm]{ canvas->setSegmentAlgorithm(algorithm); });
+    }
+
+    // --- Вид ---
+    QMenu *viewMenu = menuBar()->addMenu("Вид");
+    QAction *batchedAct = viewMenu->addAction("Пакетная отрисовка");
+    batchedAct->setCheckable(true);
+    batchedAct->setChecked(canvas->batchedPainting());
+    connect(batchedAct, &QAction::toggled,
+            canvas, &ClippingCanvas::setBatchedPainting);
+
     // --- Справка ---
     QMenu *helpMenu = menuBar()->addMenu("Справка");
     helpMenu->addAction("О программе", this, &MainWindow::showAbout);
@@ -68,15 +178,13 @@ void MainWindow::openSegmentsFile()
         this,
         "Открыть файл с отрезками",
         "/data",
-        "Text files (*.txt);;All files (*.*)");
+        "Scene files (*.txt *.scb);;Text files (*.txt);;Binary files (*.scb);;All files (*.*)");
 
     if (fn.isEmpty())
         return;
 
-    if (!canvas->loadSegmentsFromFile(fn)) {
-        QMessageBox::warning(this, "Ошибка",
-                             "Не удалось загрузить файл с отрезками.");
-    }
+    loadFailureText = "Не удалось загрузить файл с отрезками.";
+    canvas->loadSegmentsFromFile(fn);
 }
 
 void MainWindow::openPolygonFile()
@@ -85,18 +193,76 @@ void MainWindow::openPolygonFile()
         this,
         "Открыть файл с многоугольником",
         "/data",
+        "Scene files (*.txt *.scb);;Text files (*.txt);;Binary files (*.scb);;All files (*.*)");
+
+    if (fn.isEmpty())
+        return;
+
+    loadFailureText = "Не удалось загрузить файл с многоугольником.";
+    canvas->loadPolygonFromFile(fn);
+}
+
+void MainWindow::openPolylineFile()
+{
+    QString fn = QFileDialog::getOpenFileName(
+        this,
+        "Открыть файл с ломаными",
+        "/data",
         "Text files (*.txt);;All files (*.*)");
 
     if (fn.isEmpty())
         return;
 
-    if (!canvas->loadPolygonFromFile(fn)) {
+    loadFailureText = "Не удалось загрузить файл с ломаными.";
+    canvas->loadPolylinesFromFile(fn);
+}
+
+void MainWindow::exportResult()
+{
+    if (canvas->isBusy()) {
+        QMessageBox::information(this, "Экспорт",
+                                 "Дождитесь окончания отсечения или отмените его.");
+        return;
+    }
+
+    QString filter;
+    QString fn = QFileDialog::getSaveFileName(
+        this,
+        "Экспорт результата отсечения",
+        "/data",
+        "Text files (*.txt);;Binary files (*.scb);;SVG images (*.svg)",
+        &filter);
+
+    if (fn.isEmpty())
+        return;
+
+    // формат выбирается по расширению; без него — по выбранному фильтру
+    if (QFileInfo(fn).suffix().isEmpty())
+        fn += filter.startsWith("SVG") ? ".svg"
+            : filter.startsWith("Binary") ? ".scb" : ".txt";
+
+    // запись идёт в фоне, итог — exportFinished
+    QString error;
+    if (!canvas->exportResult(fn, &error)) {
         QMessageBox::warning(this, "Ошибка",
-                             "Не удалось загрузить файл с многоугольником.");
+                             "Не удалось экспортировать результат.\n\n" + error);
+        return;
     }
+    statusBar()->showMessage("Запись в " + fn + "...");
 }
 
 
+// разбор, отсечение и отрисовка с последней загрузки файла;
+// подробности — во всплывающей подсказке
+void MainWindow::showStats()
+{
+    if (!statsLabel)
+        return;
+    const clip::StatsSnapshot stats = clip::statsSnapshot();
+    statsLabel->setText(clip::statsSummary(stats));
+    statsLabel->setToolTip(clip::statsDetails(stats));
+}
+
 void MainWindow::clearScene()
 {
     canvas->clearAll();
@@ -108,7 +274,8 @@ void MainWindow::showAbout()
         this,
         "О программе",
         "Алгоритмы отсечения отрезков и многоугольников\n\n"
-        "Часть 1: алгоритм средней точки (Midpoint subdivision)\n"
+        "Часть 1: алгоритм средней точки (Midpoint subdivision);\n"
+        "для сравнения доступны Коэн–Сазерленд и Лианг–Барски\n"
         "Часть 2: алгоритм Сазерленда–Ходжмана для выпуклого многоугольника\n"
         "относительно прямоугольного окна.\n\n"
         "Вариант: 9 (отрезки — алгоритм средней точки; "
@@ -2,6 +2,9 @@
 #include <QMainWindow>
 
 class ClippingCanvas;
+class QLabel;
+class QProgressBar;
+class QPushButton;
 
 class MainWindow : public QMainWindow
 {
@@ -12,11 +15,21 @@ public:
 private slots:
     void openSegmentsFile();
     void openPolygonFile();
+    void openPolylineFile();
+    void exportResult();
     void clearScene();
     void showAbout();
 
 private:
     ClippingCanvas *canvas = nullptr;
+    QLabel *frameLabel = nullptr;   // время кадра в строке состояния
+    QLabel *statsLabel = nullptr;   // счётчики clipcore (если собраны)
+
+    // ход фоновой загрузки / отсечения
+    QProgressBar *jobProgress = nullptr;
+    QPushButton  *jobCancel = nullptr;
+    QString       loadFailureText;  // заголовок сообщения об ошибке загрузки
 
     void createMenus();
+    void showStats();
 };
@@ -0,0 +1,774 @@
+// clip-batch — пакетное отсечение файлов без запуска GUI.
+//
+//   clip-batch [-a <алгоритм>] [-j <потоки>] [-o <каталог>] [-f <формат>] [--points]
+//              [--stats <файл.json>] <файл|каталог>...
+//   clip-batch convert [--float32] <вход.txt> <выход.scb>
+//   clip-batch stream [--window xmin ymin xmax ymax] [--polygon] [-a <алгоритм>]
+//                     [-j <потоки>] [--chunk <n>] <вход> <выход.txt>
+//   clip-batch tiles (--grid <столбцов> <строк> | --windows <файл>)
+//                    [-a <алгоритм>] [-j <потоки>] [-o <каталог>] <вход>
+//   clip-batch render [--size <ш>x<в>] [--tile <пикс>] [--no-grid]
+//                     [-a <алгоритм>] [-j <потоки>] <вход> <выход.png>
+//
+// Тип каждого файла (отрезки или многоугольник) определяется по количеству
+// чисел в нём, файл с меткой "P" — несколько многоугольников, с меткой
+// "L" — ломаные. Для каталогов обрабатываются все *.txt и *.scb верхнего уровня.
+// Окно может быть выпуклым многоугольником (см. clipio.h); тогда отрезки
+// отсекаются Кирусом–Беком независимо от -a.
+// stream отсекает вход любого размера порциями, не загружая его в память;
+// окно задаётся ключом или берётся из заголовка *.scb.
+// tiles отсекает отрезки сразу многими окнами: сеткой, делящей окно сцены,
+// или списком из файла (k, затем k строк "xmin ymin xmax ymax").
+// render рисует сцену и результат отсечения в файл изображения без дисплея
+// (платформа offscreen, см. scenerenderer.h); формат — по расширению.
+// Двоичные файлы с отрезками при -a liang-barsky отсекаются прямо по
+// отображённым в память столбцам.
+// -f выбирает формат результатов (см. resultexport.h): text, binary или svg;
+// без него результат — текст, а у двоичных отрезков — снова *.scb.
+// --points добавляет точки пересечения: в SVG — маркерами, иначе — файлом
+// <имя>.clipped.points.txt рядом с результатом.
+// --stats записывает счётчики и таймеры clipcore (clipstats.h) в JSON;
+// ненулевыми они будут только в сборке с CLIP_ENABLE_STATS.
+
+#include "clipcore/binaryformat.h"
+#include "clipcore/clipio.h"
+#include "clipcore/clipstats.h"
+#include "clipcore/parallelclipper.h"
+#include "clipcore/polygonbatch.h"
+#include "clipcore/polygonclipper.h"
+#include "clipcore/resultexport.h"
+#include "clipcore/streamclipper.h"
+#include "clipcore/tileclipper.h"
+#include "scenerenderer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+struct BatchOptions
+{
+    QString     outputDir;   // пусто — результаты не записываются
+    QString     statsFile;   // пусто — счётчики не записываются
+    QStringList inputs;
+    clip::SegmentAlgorithm algorithm = clip::SegmentAlgorithm::Midpoint;
+    int         threads = 0;  // 0 — по числу ядер
+    clip::ExportFormat format = clip::ExportFormat::Text;
+    bool        formatSet = false;   // -f задан явно
+    bool        points = false;      // записывать точки пересечения
+};
+
+void printUsage(QTextStream &err)
+{
+    err << "Использование: clip-batch [-a <алгоритм>] [-j <потоки>] [-o <каталог>]\n"
+           "                          [-f <формат>] [--points] [--stats <файл.json>]\n"
+           "                          <файл|каталог>...\n"
+           "               clip-batch convert [--float32] <вход.txt> <выход.scb>\n"
+           "               clip-batch stream [--window xmin ymin xmax ymax] [--polygon]\n"
+           "                                 [-a <алгоритм>] [-j <потоки>] [--chunk <n>] <вход> <выход.txt>\n"
+           "               clip-batch tiles (--grid <столбцов> <строк> | --windows <файл>)\n"
+           "                                [-a <алгоритм>] [-j <потоки>] [-o <каталог>] <вход>\n"
+           "               clip-batch render [--size <ш>x<в>] [--tile <пикс>] [--no-grid]\n"
+           "                                 [-a <алгоритм>] [-j <потоки>] <вход> <выход.png>\n"
+           "  -a, --algorithm <имя>   алгоритм для отрезков: "
+        << clip::segmentAlgorithmNames().join(", ") << " (midpoint)\n"
+           "  -j, --threads <число>   потоков для отрезков (по умолчанию — по числу ядер)\n"
+           "  -o, --output <каталог>  записать результаты в <имя>.clipped.txt (.scb, .svg)\n"
+           "  -f, --format <формат>   формат результатов: "
+        << clip::exportFormatNames().join(", ") << " (text; у *.scb — binary)\n"
+           "  --points                записать и точки пересечения\n"
+           "  --stats <файл.json>     записать счётчики и время разбора и отсечения\n"
+           "  -h, --help              показать эту справку\n"
+           "  --float32               (convert) хранить координаты в float32\n"
+           "  --window x1 y1 x2 y2    (stream) окно; для текстового входа обязательно\n"
+           "  --polygon               (stream) текстовый вход — многоугольник\n"
+           "  --chunk <n>             (stream) отрезков или вершин в порции\n"
+           "  --grid <c> <r>          (tiles) окно сцены делится на c × r окон\n"
+           "  --windows <файл>        (tiles) окна из файла\n"
+           "  --size <ш>x<в>          (render) размер рисунка, пикселей (2048x2048)\n"
+           "  --tile <пикс>           (render) сторона плитки (1024)\n"
+           "  --no-grid               (render) без сетки и подписей\n";
+}
+
+QStringList collectFiles(const QStringList &inputs)
+{
+    QStringList files;
+    for (const QString &path : inputs) {
+        QFileInfo fi(path);
+        if (fi.isDir()) {
+            const QFileInfoList entries =
+                QDir(path).entryInfoList(QStringList() << "*.txt" << "*.scb",
+                                         QDir::Files, QDir::Name);
+            for (const QFileInfo &e : entries)
+                files.append(e.filePath());
+        } else {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+QString outputPath(const BatchOptions &opt, const QString &input,
+                   const QString &suffix = ".clipped.txt")
+{
+    return QDir(opt.outputDir).filePath(
+        QFileInfo(input).completeBaseName() + suffix);
+}
+
+// запись результата прямо из буферов клиппера, с окном сцены и (при
+// --points) точками пересечения
+bool writeResult(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                 const QString &file, clip::ExportFormat format,
+                 clip::ExportScene result, const QRectF &window,
+                 const QVector<QPointF> &windowPolygon,
+                 const QPointF *points, qsizetype pointCount, QTextStream &err,
+                 clip::ColumnPrecision precision = clip::ColumnPrecision::Float64)
+{
+    if (opt.outputDir.isEmpty())
+        return true;
+
+    result.window = window;
+    result.windowPolygon = windowPolygon;
+    if (opt.points) {
+        result.points = points;
+        result.pointCount = pointCount;
+    }
+
+    QString message;
+    if (!clip::exportScene(outputPath(opt, file, ".clipped" + clip::exportSuffix(format)),
+                           format, result, &message, precision, pool)) {
+        err << message << '\n';
+        return false;
+    }
+    return true;
+}
+
+// Отрезки из двоичного файла без копирования в QVector<QLineF>.
+bool processMappedSegments(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                           const QString &file, const clip::MappedScene &scene,
+                           QTextStream &out, QTextStream &err)
+{
+    clip::SegmentArrays clipped;
+    QVector<quint8> mask;
+    clip::clipMappedSegments(scene, clipped, mask, pool);
+
+    // точки пересечения с окном — по частям, как при отсечении
+    const qsizetype n = scene.count();
+    const QRectF window = scene.window();
+    const qsizetype parts = (n + clip::kParallelChunkSize - 1) / clip::kParallelChunkSize;
+    QVector<qsizetype> partIntersections(parts, 0);
+    QVector<QVector<QPointF>> partPoints(opt.points ? parts : 0);
+    qsizetype *counts = partIntersections.data();
+    pool.run(parts, [&](qsizetype part, int) {
+        const qsizetype begin = part * clip::kParallelChunkSize;
+        const qsizetype end = std::min(begin + clip::kParallelChunkSize, n);
+        // без --points точки только считаются: буфер части переиспользуется
+        QVector<QPointF> scratch;
+        QVector<QPointF> &found = opt.points ? partPoints[part] : scratch;
+        for (qsizetype i = begin; i < end; ++i) {
+            const QLineF s = scene.segment(i);
+            const qsizetype before = found.size();
+            clip::appendRealIntersections(s.p1(), s.p2(), window, found);
+            counts[part] += found.size() - before;
+            if (!opt.points)
+                found.clear();
+        }
+    });
+
+    qsizetype intersections = 0;
+    for (qsizetype c : partIntersections)
+        intersections += c;
+
+    QVector<QPointF> points;
+    points.reserve(opt.points ? intersections : 0);
+    for (const QVector<QPointF> &part : std::as_const(partPoints))
+        points += part;
+
+    // видимые части — к началу столбцов
+    qsizetype visible = 0;
+    for (qsizetype i = 0; i < n; ++i) {
+        if (!mask[i])
+            continue;
+        clipped.x1[visible] = clipped.x1[i];
+        clipped.y1[visible] = clipped.y1[i];
+        clipped.x2[visible] = clipped.x2[i];
+        clipped.y2[visible] = clipped.y2[i];
+        ++visible;
+    }
+
+    out << file << "\tsegments\t" << n << '\t' << visible
+        << '\t' << intersections << '\n';
+
+    if (opt.outputDir.isEmpty())
+        return true;
+
+    clipped.resize(visible);
+    return writeResult(opt, pool, file, opt.formatSet ? opt.format : clip::ExportFormat::Binary,
+                       clip::exportSegments(clipped.columns()), window, {},
+                       points.constData(), points.size(), err, scene.precision());
+}
+
+bool processSegments(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                     const QString &file, const clip::SegmentScene &scene,
+                     QTextStream &out, QTextStream &err)
+{
+    clip::SegmentClipResult result;
+    clip::clipSegmentsParallel(scene.segments,
+                               clip::sceneWindow(scene.window, scene.windowPolygon),
+                               *clip::createSegmentEngine(opt.algorithm),
+                               result, pool);
+
+    out << file << "\tsegments\t" << scene.segments.size()
+        << '\t' << result.visible.size()
+        << '\t' << result.intersections.size() << '\n';
+
+    return writeResult(opt, pool, file, opt.format, clip::exportSegments(result.visible),
+                       scene.window, scene.windowPolygon,
+                       result.intersections.constData(), result.intersections.size(), err);
+}
+
+bool processPolygon(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                    const QString &file, const clip::PolygonScene &scene,
+                    QTextStream &out, QTextStream &err)
+{
+    clip::PolygonClipResult result;
+    clip::clipPolygonSutherlandHodgman(scene.polygon,
+                                       clip::sceneWindow(scene.window, scene.windowPolygon),
+                                       result);
+
+    out << file << "\tpolygon\t" << scene.polygon.size()
+        << '\t' << result.polygon.size()
+        << '\t' << result.intersections.size() << '\n';
+
+    return writeResult(opt, pool, file, opt.format, clip::exportPolygon(result.polygon),
+                       scene.window, scene.windowPolygon,
+                       result.intersections.constData(), result.intersections.size(), err);
+}
+
+bool processMultiPolygon(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                         const QString &file, const clip::MultiPolygonScene &scene,
+                         QTextStream &out, QTextStream &err)
+{
+    clip::PolygonSetClipResult result;
+    clip::PolygonBatchClipper(pool).clip(scene.polygons,
+                                         clip::sceneWindow(scene.window, scene.windowPolygon),
+                                         result);
+
+    out << file << "\tpolygons\t" << scene.polygons.count()
+        << '\t' << result.polygons.vertices.size()
+        << '\t' << result.intersections.vertices.size() << '\n';
+
+    return writeResult(opt, pool, file, opt.format,
+                       clip::exportPointSets(clip::SceneKind::MultiPolygon, result.polygons),
+                       scene.window, scene.windowPolygon,
+                       result.intersections.vertices.constData(),
+                       result.intersections.vertices.size(), err);
+}
+
+bool processPolylines(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                      const QString &file, const clip::PolylineScene &scene,
+                      QTextStream &out, QTextStream &err)
+{
+    clip::PolylineClipResult result;
+    clip::clipPolylines(scene.chains,
+                        clip::sceneWindow(scene.window, scene.windowPolygon),
+                        result);
+
+    out << file << "\tpolylines\t" << scene.chains.count()
+        << '\t' << result.chains.count()
+        << '\t' << result.intersections.size() << '\n';
+
+    return writeResult(opt, pool, file, opt.format,
+                       clip::exportPointSets(clip::SceneKind::Polyline, result.chains),
+                       scene.window, scene.windowPolygon,
+                       result.intersections.constData(), result.intersections.size(), err);
+}
+
+bool processBinaryFile(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                       const QString &file, QTextStream &out, QTextStream &err)
+{
+    clip::MappedScene mapped;
+    QString message;
+    if (!mapped.open(file, &message)) {
+        err << file << ": " << message << '\n';
+        return false;
+    }
+
+    if (mapped.kind() == clip::SceneKind::Polygon) {
+        const clip::PolygonScene scene { mapped.polygon(), mapped.window(), {} };
+        return processPolygon(opt, pool, file, scene, out, err);
+    }
+    if (opt.algorithm == clip::SegmentAlgorithm::LiangBarsky)
+        return processMappedSegments(opt, pool, file, mapped, out, err);
+
+    const clip::SegmentScene scene { mapped.segments(), mapped.window(), {} };
+    return processSegments(opt, pool, file, scene, out, err);
+}
+
+bool processFile(const BatchOptions &opt, clip::WorkStealingPool &pool,
+                 const QString &file, QTextStream &out, QTextStream &err)
+{
+    if (clip::isBinarySceneFile(file))
+        return processBinaryFile(opt, pool, file, out, err);
+
+    clip::NumberText text;
+    clip::ParseError error;
+    if (!clip::parseNumbersFile(file, text, error, pool)) {
+        err << error.toString(file) << '\n';
+        return false;
+    }
+
+    switch (clip::detectSceneKind(text)) {
+    case clip::SceneKind::Segments: {
+        clip::SegmentScene scene;
+        if (!clip::segmentSceneFromNumbers(text, scene, error)) {
+            err << error.toString(file) << '\n';
+            return false;
+        }
+        return processSegments(opt, pool, file, scene, out, err);
+    }
+    case clip::SceneKind::Polygon: {
+        clip::PolygonScene scene;
+        if (!clip::polygonSceneFromNumbers(text, scene, error)) {
+            err << error.toString(file) << '\n';
+            return false;
+        }
+        return processPolygon(opt, pool, file, scene, out, err);
+    }
+    case clip::SceneKind::MultiPolygon: {
+        clip::MultiPolygonScene scene;
+        if (!clip::multiPolygonSceneFromNumbers(text, scene, error)) {
+            err << error.toString(file) << '\n';
+            return false;
+        }
+        return processMultiPolygon(opt, pool, file, scene, out, err);
+    }
+    case clip::SceneKind::Polyline: {
+        clip::PolylineScene scene;
+        if (!clip::polylineSceneFromNumbers(text, scene, error)) {
+            err << error.toString(file) << '\n';
+            return false;
+        }
+        return processPolylines(opt, pool, file, scene, out, err);
+    }
+    case clip::SceneKind::Unknown:
+        break;
+    }
+
+    err << file << ": количество чисел не подходит ни под отрезки, "
+                   "ни под многоугольник\n";
+    return false;
+}
+
+// счётчики clipcore за весь прогон и его итог — в JSON
+bool writeStats(const QString &fileName, qsizetype files, int failed,
+                qint64 elapsedMs, QTextStream &err)
+{
+    if (!clip::kStatsEnabled)
+        err << "Счётчики не собраны: пересоберите с -DCLIP_ENABLE_STATS=ON\n";
+
+    QJsonObject root = clip::statsToJson(clip::statsSnapshot());
+    root.insert("files", double(files));
+    root.insert("failed", failed);
+    root.insert("elapsed_ms", double(elapsedMs));
+
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        f.write(QJsonDocument(root).toJson()) < 0) {
+        err << "Не удалось записать " << fileName << '\n';
+        return false;
+    }
+    return true;
+}
+
+// clip-batch convert [--float32] <вход.txt> <выход.scb>
+int runConvert(int argc, char *argv[], QTextStream &err)
+{
+    clip::ColumnPrecision precision = clip::ColumnPrecision::Float64;
+    QStringList paths;
+    for (int i = 2; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--float32")
+            precision = clip::ColumnPrecision::Float32;
+        else
+            paths.append(arg);
+    }
+
+    if (paths.size() != 2) {
+        printUsage(err);
+        return 2;
+    }
+
+    QString message;
+    if (!clip::convertTextToBinary(paths[0], paths[1], precision, &message)) {
+        err << message << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+// clip-batch stream ... <вход> <выход.txt>
+int runStream(int argc, char *argv[], QTextStream &out, QTextStream &err)
+{
+    clip::StreamOptions options;
+    clip::SegmentAlgorithm algorithm = clip::SegmentAlgorithm::Midpoint;
+    int threads = 0;
+    QStringList paths;
+
+    for (int i = 2; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        bool ok = true;
+        if (arg == "--window") {
+            double v[4];
+            for (int k = 0; k < 4 && ok; ++k)
+                v[k] = ++i < argc ? QString::fromLocal8Bit(argv[i]).toDouble(&ok) : (ok = false, 0.0);
+            options.hasWindow = ok;
+            options.window = QRectF(QPointF(v[0], v[1]), QPointF(v[2], v[3]));
+        } else if (arg == "--polygon") {
+            options.textKind = clip::SceneKind::Polygon;
+        } else if (arg == "--chunk") {
+            ok = false;
+            if (++i < argc)
+                options.chunkSize = QString::fromLocal8Bit(argv[i]).toLongLong(&ok);
+            ok = ok && options.chunkSize > 0;
+        } else if (arg == "-a" || arg == "--algorithm") {
+            ok = ++i < argc &&
+                 clip::segmentAlgorithmFromName(QString::fromLocal8Bit(argv[i]), algorithm);
+        } else if (arg == "-j" || arg == "--threads") {
+            ok = false;
+            if (++i < argc)
+                threads = QString::fromLocal8Bit(argv[i]).toInt(&ok);
+            ok = ok && threads > 0;
+        } else {
+            paths.append(arg);
+        }
+        if (!ok) {
+            printUsage(err);
+            return 2;
+        }
+    }
+
+    if (paths.size() != 2) {
+        printUsage(err);
+        return 2;
+    }
+
+    std::unique_ptr<clip::WorkStealingPool> ownPool;
+    if (threads > 0)
+        ownPool = std::make_unique<clip::WorkStealingPool>(threads);
+    clip::WorkStealingPool &pool = ownPool ? *ownPool : clip::WorkStealingPool::global();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    clip::StreamStats stats;
+    clip::ParseError error;
+    if (!clip::clipStream(paths[0], paths[1], options,
+                          *clip::createSegmentEngine(algorithm), stats, error, pool)) {
+        err << error.toString(paths[0]) << '\n';
+        return 1;
+    }
+
+    out << paths[0] << '\t'
+        << (stats.kind == clip::SceneKind::Polygon ? "polygon" : "segments")
+        << '\t' << stats.inputCount << '\t' << stats.outputCount
+        << '\t' << stats.intersections << '\n';
+    err << "время: " << timer.elapsed() << " мс\n";
+    return 0;
+}
+
+// clip-batch tiles ... <вход>
+int runTiles(int argc, char *argv[], QTextStream &out, QTextStream &err)
+{
+    BatchOptions opt;
+    int columns = 0, rows = 0;
+    QString windowsFile;
+
+    for (int i = 2; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        bool ok = true;
+        if (arg == "--grid") {
+            bool okRows = false;
+            ok = i + 2 < argc;
+            if (ok) {
+                columns = QString::fromLocal8Bit(argv[++i]).toInt(&ok);
+                rows = QString::fromLocal8Bit(argv[++i]).toInt(&okRows);
+            }
+            ok = ok && okRows && columns > 0 && rows > 0;
+        } else if (arg == "--windows") {
+            ok = ++i < argc;
+            if (ok)
+                windowsFile = QString::fromLocal8Bit(argv[i]);
+        } else if (arg == "-a" || arg == "--algorithm") {
+            ok = ++i < argc &&
+                 clip::segmentAlgorithmFromName(QString::fromLocal8Bit(argv[i]), opt.algorithm);
+        } else if (arg == "-j" || arg == "--threads") {
+            ok = false;
+            if (++i < argc)
+                opt.threads = QString::fromLocal8Bit(argv[i]).toInt(&ok);
+            ok = ok && opt.threads > 0;
+        } else if (arg == "-o" || arg == "--output") {
+            ok = ++i < argc;
+            if (ok)
+                opt.outputDir = QString::fromLocal8Bit(argv[i]);
+        } else {
+            opt.inputs.append(arg);
+        }
+        if (!ok) {
+            printUsage(err);
+            return 2;
+        }
+    }
+
+    // ровно один способ задать окна и один вход
+    if (opt.inputs.size() != 1 || (columns > 0) == !windowsFile.isEmpty()) {
+        printUsage(err);
+        return 2;
+    }
+    const QString file = opt.inputs.first();
+
+    if (!opt.outputDir.isEmpty() && !QDir().mkpath(opt.outputDir)) {
+        err << "Не удалось создать каталог " << opt.outputDir << '\n';
+        return 1;
+    }
+
+    std::unique_ptr<clip::WorkStealingPool> ownPool;
+    if (opt.threads > 0)
+        ownPool = std::make_unique<clip::WorkStealingPool>(opt.threads);
+    clip::WorkStealingPool &pool = ownPool ? *ownPool : clip::WorkStealingPool::global();
+
+    clip::SegmentScene scene;
+    clip::ParseError error;
+    if (!clip::loadSegmentScene(file, scene, &error)) {
+        err << error.toString(file) << '\n';
+        return 1;
+    }
+
+    QVector<QRectF> windows;
+    if (columns > 0) {
+        windows = clip::tileGrid(scene.window, columns, rows);
+    } else if (!clip::loadTileWindows(windowsFile, windows, &error)) {
+        err << error.toString(windowsFile) << '\n';
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<clip::SegmentClipResult> results;
+    const qsizetype pairs =
+        clip::clipSegmentsTiled(scene.segments, windows,
+                                *clip::createSegmentEngine(opt.algorithm),
+                                results, pool);
+
+    qsizetype visible = 0, intersections = 0;
+    for (const clip::SegmentClipResult &r : std::as_const(results)) {
+        visible += r.visible.size();
+        intersections += r.intersections.size();
+    }
+
+    out << file << "\ttiles\t" << windows.size() << '\t' << scene.segments.size()
+        << '\t' << pairs << '\t' << visible << '\t' << intersections << '\n';
+    err << "время: " << timer.elapsed() << " мс\n";
+
+    if (!opt.outputDir.isEmpty() &&
+        !clip::saveTiledSegments(outputPath(opt, file, ".tiles.txt"), windows, results)) {
+        err << "Не удалось записать " << outputPath(opt, file, ".tiles.txt") << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+// clip-batch render ... <вход> <выход.png>
+int runRender(int argc, char *argv[], QTextStream &out, QTextStream &err)
+{
+    render::Options options;
+    clip::SegmentAlgorithm algorithm = clip::SegmentAlgorithm::Midpoint;
+    int threads = 0;
+    QStringList paths;
+
+    for (int i = 2; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        bool ok = true;
+        if (arg == "--size") {
+            const QStringList wh = ++i < argc
+                ? QString::fromLocal8Bit(argv[i]).split('x') : QStringList();
+            bool okHeight = false;
+            ok = wh.size() == 2;
+            if (ok)
+                options.size = QSize(wh[0].toInt(&ok), wh[1].toInt(&okHeight));
+            ok = ok && okHeight && !options.size.isEmpty();
+        } else if (arg == "--tile") {
+            ok = false;
+            if (++i < argc)
+                options.tileSize = QString::fromLocal8Bit(argv[i]).toInt(&ok);
+            ok = ok && options.tileSize > 0;
+        } else if (arg == "--no-grid") {
+            options.grid = false;
+        } else if (arg == "-a" || arg == "--algorithm") {
+            ok = ++i < argc &&
+                 clip::segmentAlgorithmFromName(QString::fromLocal8Bit(argv[i]), algorithm);
+        } else if (arg == "-j" || arg == "--threads") {
+            ok = false;
+            if (++i < argc)
+                threads = QString::fromLocal8Bit(argv[i]).toInt(&ok);
+            ok = ok && threads > 0;
+        } else {
+            paths.append(arg);
+        }
+        if (!ok) {
+            printUsage(err);
+            return 2;
+        }
+    }
+
+    if (paths.size() != 2) {
+        printUsage(err);
+        return 2;
+    }
+
+    // шрифты и растеризация без дисплея
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    std::unique_ptr<clip::WorkStealingPool> ownPool;
+    if (threads > 0)
+        ownPool = std::make_unique<clip::WorkStealingPool>(threads);
+    clip::WorkStealingPool &pool = ownPool ? *ownPool : clip::WorkStealingPool::global();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    render::Scene scene;
+    QString message;
+    if (!render::loadScene(paths[0], algorithm, scene, message, pool)) {
+        err << message << '\n';
+        return 1;
+    }
+    const qint64 loadMs = timer.restart();
+
+    const QImage image = render::renderScene(scene, options, pool);
+    if (image.isNull()) {
+        err << "Не удалось выделить рисунок " << options.size.width() << 'x'
+            << options.size.height() << '\n';
+        return 1;
+    }
+    const qint64 renderMs = timer.restart();
+
+    if (!image.save(paths[1])) {
+        err << "Не удалось записать " << paths[1] << '\n';
+        return 1;
+    }
+
+    out << paths[0] << "\trender\t" << image.width() << 'x' << image.height() << '\n';
+    err << "загрузка и отсечение: " << loadMs << " мс, рисование: " << renderMs
+        << " мс, запись: " << timer.elapsed() << " мс\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (argc > 1 && QString::fromLocal8Bit(argv[1]) == "convert")
+        return runConvert(argc, argv, err);
+    if (argc > 1 && QString::fromLocal8Bit(argv[1]) == "stream")
+        return runStream(argc, argv, out, err);
+    if (argc > 1 && QString::fromLocal8Bit(argv[1]) == "tiles")
+        return runTiles(argc, argv, out, err);
+    if (argc > 1 && QString::fromLocal8Bit(argv[1]) == "render")
+        return runRender(argc, argv, out, err);
+
+    BatchOptions opt;
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "-h" || arg == "--help") {
+            printUsage(out);
+            return 0;
+        } else if (arg == "-o" || arg == "--output") {
+            if (++i >= argc) {
+                printUsage(err);
+                return 2;
+            }
+            opt.outputDir = QString::fromLocal8Bit(argv[i]);
+        } else if (arg == "-f" || arg == "--format") {
+            if (++i >= argc ||
+                !clip::exportFormatFromName(QString::fromLocal8Bit(argv[i]), opt.format)) {
+                printUsage(err);
+                return 2;
+            }
+            opt.formatSet = true;
+        } else if (arg == "--points") {
+            opt.points = true;
+        } else if (arg == "--stats") {
+            if (++i >= argc) {
+                printUsage(err);
+                return 2;
+            }
+            opt.statsFile = QString::fromLocal8Bit(argv[i]);
+        } else if (arg == "-a" || arg == "--algorithm") {
+            if (++i >= argc ||
+                !clip::segmentAlgorithmFromName(QString::fromLocal8Bit(argv[i]),
+                                                opt.algorithm)) {
+                printUsage(err);
+                return 2;
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            bool ok = false;
+            if (++i < argc)
+                opt.threads = QString::fromLocal8Bit(argv[i]).toInt(&ok);
+            if (!ok || opt.threads < 1) {
+                printUsage(err);
+                return 2;
+            }
+        } else {
+            opt.inputs.append(arg);
+        }
+    }
+
+    if (opt.inputs.isEmpty()) {
+        printUsage(err);
+        return 2;
+    }
+
+    if (!opt.outputDir.isEmpty() && !QDir().mkpath(opt.outputDir)) {
+        err << "Не удалось создать каталог " << opt.outputDir << '\n';
+        return 1;
+    }
+
+    std::unique_ptr<clip::WorkStealingPool> ownPool;
+    if (opt.threads > 0)
+        ownPool = std::make_unique<clip::WorkStealingPool>(opt.threads);
+    clip::WorkStealingPool &pool = ownPool ? *ownPool : clip::WorkStealingPool::global();
+
+    QElapsedTimer timer;
+    timer.start();
+    clip::resetStats();
+
+    int failed = 0;
+    const QStringList files = collectFiles(opt.inputs);
+    for (const QString &file : files) {
+        if (!processFile(opt, pool, file, out, err))
+            ++failed;
+    }
+
+    err << "Файлов: " << files.size() << ", ошибок: " << failed
+        << ", время: " << timer.elapsed() << " мс\n";
+
+    if (!opt.statsFile.isEmpty() &&
+        !writeStats(opt.statsFile, files.size(), failed, timer.elapsed(), err))
+        return 1;
+    return failed == 0 ? 0 : 1;
+}
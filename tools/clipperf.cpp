@@ -0,0 +1,1170 @@
+// clip-perf — проверки для CTest: скорость и число выделений памяти на
+// фиксированных нагрузках против эталона в репозитории и геометрия
+// отсечения всех файлов testfiles/ против ожидаемой.
+//
+//   clip-perf run --baseline <файл.json> [--workload <имя>] [--repeat <n>]
+//                 [--tolerance <доля>] [--update]
+//   clip-perf geometry --expected <каталог> [--update] <каталог|файл>...
+//   clip-perf generic
+//   clip-perf render --clip-batch <путь> <файл>...
+//
+// run: каждая нагрузка порождается из одного и того же seed и выполняется
+// repeat раз после прогревочного. Медиана пропускной способности не должна
+// опуститься ниже эталонной больше чем на throughput_tolerance, а наибольшее
+// за прогон число выделений памяти — превысить эталонное больше чем на
+// allocation_tolerance и ещё allocation_slack штук. Скорость не сравнивается,
+// если эталон снят на сборке другого типа (release/debug) или в сборке
+// включены счётчики CLIP_ENABLE_STATS; выделения считаются только с glibc.
+// --update записывает измеренное в эталон, сохраняя допуски.
+//
+// geometry: видимые части, многоугольники и точки пересечения для каждого
+// файла (отрезки — каждым алгоритмом) сравниваются с <каталог>/<имя>.txt
+// с точностью kGeometryEps; --update переписывает эти файлы. Берутся *.txt
+// и *.scb; файл, который не удалось загрузить, даёт один пустой раздел
+// "error" — так повреждённые входы проверяются на отказ.
+//
+// generic: экземпляры шаблонов genericclipper.h, которые clipcore сам не
+// собирает (float, сетка std::int32_t, окна FixedBox), сравниваются с
+// экземпляром для double на одних и тех же отрезках и многоугольниках.
+//
+// render: каждый файл рисуется командой clip-batch render плитками и одной
+// плиткой. На рисунке без сетки грани окна должны быть синими, а видимые
+// части отрезков и ломаных — красными (по преобладающему каналу, не точным
+// цветом); рисунок плитками должен совпасть с рисунком одной плиткой с
+// допуском, кроме пикселей у штриховых исходных примитивов.
+//
+// Код возврата: 0 — всё в допуске, 1 — превышение или расхождение,
+// 2 — неверные аргументы.
+
+#include "clipcore/clipio.h"
+#include "clipcore/clipstats.h"
+#include "clipcore/genericclipper.h"
+#include "clipcore/polygonbatch.h"
+#include "clipcore/polygonclipper.h"
+#include "clipcore/segmentengine.h"
+#include "scenerenderer.h"
+#include "workloads.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// ---------- счёт выделений памяти ----------
+
+namespace {
+
+std::atomic<bool> countingAllocations { false };
+std::atomic<quint64> allocationCount { 0 };
+
+inline void noteAllocation()
+{
+    if (countingAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// Контейнеры Qt выделяют память через malloc, а не operator new, поэтому
+// перехватывается malloc (operator new libstdc++ тоже идёт через него).
+// Освобождение и выровненные выделения остаются у glibc.
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    noteAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    noteAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) noexcept
+{
+    noteAllocation();
+    return __libc_realloc(p, size);
+}
+}
+constexpr bool kCountsAllocations = true;
+#else
+constexpr bool kCountsAllocations = false;
+#endif
+
+namespace {
+
+// окно всех нагрузок
+const QRectF kWindow(QPointF(-50, -50), QPointF(50, 50));
+
+constexpr quint32 kSeed = 20240601;
+
+// допуски по умолчанию, если в эталоне их нет
+constexpr double kThroughputTolerance = 0.40;
+constexpr double kAllocationTolerance = 0.10;
+constexpr qint64 kAllocationSlack = 16;
+
+// расхождение координат, которое ещё считается совпадением
+constexpr double kGeometryEps = 1e-5;
+
+#ifdef NDEBUG
+const char *const kBuildType = "release";
+#else
+const char *const kBuildType = "debug";
+#endif
+
+void printUsage(QTextStream &err)
+{
+    err << "Использование: clip-perf run --baseline <файл.json> [--workload <имя>] [--repeat <n>]\n"
+           "                             [--tolerance <доля>] [--update]\n"
+           "               clip-perf geometry --expected <каталог> [--update] <каталог|файл>...\n"
+           "               clip-perf generic\n"
+           "               clip-perf render --clip-batch <путь> <файл>...\n"
+           "  --baseline <файл>   эталон скорости и выделений памяти\n"
+           "  --workload <имя>    только эта нагрузка (по умолчанию — все)\n"
+           "  --repeat <n>        прогонов каждой нагрузки, в отчёт — медиана (7)\n"
+           "  --tolerance <доля>  допустимое падение скорости вместо записанного в эталоне\n"
+           "  --expected <кат.>   каталог с ожидаемой геометрией\n"
+           "  --clip-batch <путь> исполняемый файл clip-batch для проверки render\n"
+           "  --update            записать измеренное как новый эталон\n";
+}
+
+// ---------- нагрузки ----------
+
+// Данные нагрузки принадлежат замыканию run; count — примитивов за прогон.
+struct Workload
+{
+    qsizetype count = 0;
+    std::function<void()> run;
+};
+
+struct WorkloadInfo
+{
+    const char *name;
+    const char *unit;
+    Workload (*make)();
+};
+
+// сумма размеров результатов — чтобы работу не выбросил оптимизатор
+qint64 checksum = 0;
+
+Workload loadTextSegments()
+{
+    // свой временный каталог на нагрузку: живёт, пока жива она,
+    // параллельные запуски clip-perf не делят один файл
+    struct Data
+    {
+        QTemporaryDir dir;
+        QString file = dir.filePath("segments.txt");
+        clip::SegmentScene scene;
+    };
+
+    std::mt19937 rng(kSeed);
+    const qsizetype n = 100000;
+    auto data = std::make_shared<Data>();
+    clip::saveSegmentScene(data->file,
+                           workload::randomSegments(rng, n, { 0.3, 0.3, 0.3 }, kWindow),
+                           kWindow);
+    return { n, [data] {
+        clip::loadSegmentScene(data->file, data->scene);
+        checksum += data->scene.segments.size();
+    } };
+}
+
+Workload midpointSegments(QVector<QLineF> segments)
+{
+    struct Data
+    {
+        QVector<QLineF> segments;
+        QVector<QLineF> out;
+    };
+
+    auto data = std::make_shared<Data>();
+    data->segments = std::move(segments);
+    data->out.reserve(data->segments.size());
+    return { data->segments.size(), [data] {
+        data->out.clear();
+        for (const QLineF &s : std::as_const(data->segments))
+            clip::clipMidpoint(s.p1(), s.p2(), kWindow, data->out);
+        checksum += data->out.size();
+    } };
+}
+
+Workload midpointMixed()
+{
+    std::mt19937 rng(kSeed + 1);
+    return midpointSegments(workload::randomSegments(rng, 200000, { 0.3, 0.3, 0.3 }, kWindow));
+}
+
+Workload midpointDiagonals()
+{
+    std::mt19937 rng(kSeed + 2);
+    return midpointSegments(workload::longDiagonals(rng, 100000, kWindow));
+}
+
+Workload sutherlandHodgmanZigZag()
+{
+    struct Data
+    {
+        QVector<QPointF> polygon;
+        clip::PolygonClipResult result;
+    };
+
+    std::mt19937 rng(kSeed + 3);
+    auto data = std::make_shared<Data>();
+    data->polygon = workload::zigZagPolygon(rng, 1000000, kWindow);
+    return { data->polygon.size(), [data] {
+        clip::clipPolygonSutherlandHodgman(data->polygon, kWindow, data->result);
+        checksum += data->result.polygon.size() + data->result.intersections.size();
+    } };
+}
+
+const WorkloadInfo kWorkloads[] = {
+    { "load/text/segments",                "segment", loadTextSegments },
+    { "segment/midpoint/mixed",            "segment", midpointMixed },
+    { "segment/midpoint/diagonals",        "segment", midpointDiagonals },
+    { "polygon/sutherland-hodgman/zigzag", "vertex",  sutherlandHodgmanZigZag },
+};
+
+struct Measurement
+{
+    double  perSecond = 0;      // примитивов в секунду, медиана
+    qint64  allocations = 0;    // наибольшее число выделений за прогон
+};
+
+Measurement measure(const Workload &w, int repeat)
+{
+    w.run();
+
+    QVector<double> times;
+    qint64 allocations = 0;
+    for (int r = 0; r < repeat; ++r) {
+        allocationCount.store(0, std::memory_order_relaxed);
+        countingAllocations.store(true, std::memory_order_relaxed);
+        QElapsedTimer timer;
+        timer.start();
+        w.run();
+        const qint64 ns = timer.nsecsElapsed();
+        countingAllocations.store(false, std::memory_order_relaxed);
+        times.append(double(ns));
+        allocations = std::max(allocations, qint64(allocationCount.load(std::memory_order_relaxed)));
+    }
+
+    std::sort(times.begin(), times.end());
+    const double median = std::max(times[times.size() / 2], 1.0);
+    return { 1e9 * double(w.count) / median, allocations };
+}
+
+// ---------- run ----------
+
+struct RunOptions
+{
+    QString baselineFile;
+    QString workload;          // пусто — все
+    int     repeat = 7;
+    double  tolerance = -1;    // < 0 — из эталона
+    bool    update = false;
+};
+
+bool readJson(const QString &fileName, QJsonObject &root)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject())
+        return false;
+    root = doc.object();
+    return true;
+}
+
+bool writeJson(const QString &fileName, const QJsonObject &root)
+{
+    const QByteArray json = QJsonDocument(root).toJson();
+    QFile f(fileName);
+    return f.open(QIODevice::WriteOnly | QIODevice::Truncate) && f.write(json) == json.size();
+}
+
+int runPerf(const RunOptions &opt, QTextStream &out, QTextStream &err)
+{
+    QJsonObject baseline;
+    if (!readJson(opt.baselineFile, baseline) && !opt.update) {
+        err << "Не удалось прочитать эталон " << opt.baselineFile << '\n';
+        return 1;
+    }
+
+    const double throughputTolerance = opt.tolerance >= 0
+        ? opt.tolerance
+        : baseline.value("throughput_tolerance").toDouble(kThroughputTolerance);
+    const double allocationTolerance =
+        baseline.value("allocation_tolerance").toDouble(kAllocationTolerance);
+    const qint64 allocationSlack =
+        baseline.value("allocation_slack").toInteger(kAllocationSlack);
+
+    // скорость сравнима только со сборкой того же типа и без счётчиков
+    const bool compareSpeed = !clip::kStatsEnabled &&
+        baseline.value("build").toString() == QLatin1String(kBuildType);
+    if (!opt.update && !compareSpeed)
+        err << "Скорость не сравнивается: эталон снят на сборке "
+            << baseline.value("build").toString() << ", эта — " << kBuildType
+            << (clip::kStatsEnabled ? " со счётчиками" : "") << '\n';
+    if (!opt.update && !kCountsAllocations)
+        err << "Выделения памяти не считаются: нужна glibc\n";
+
+    QJsonObject entries = baseline.value("workloads").toObject();
+    int failed = 0;
+    bool found = false;
+
+    for (const WorkloadInfo &info : kWorkloads) {
+        if (!opt.workload.isEmpty() && opt.workload != QLatin1String(info.name))
+            continue;
+        found = true;
+
+        const Workload w = info.make();
+        const Measurement m = measure(w, opt.repeat);
+        out << info.name << '\t' << QString::number(m.perSecond, 'f', 0) << ' '
+            << info.unit << "/s\t" << m.allocations << " alloc\n";
+
+        if (opt.update) {
+            QJsonObject e;
+            e.insert("unit", info.unit);
+            e.insert("count", qint64(w.count));
+            e.insert("per_second", std::round(m.perSecond));
+            e.insert("allocations", m.allocations);
+            entries.insert(info.name, e);
+            continue;
+        }
+
+        const QJsonObject e = entries.value(info.name).toObject();
+        if (e.isEmpty()) {
+            err << info.name << ": нет в эталоне, запустите с --update\n";
+            ++failed;
+            continue;
+        }
+
+        const double expectedSpeed = e.value("per_second").toDouble();
+        if (compareSpeed && m.perSecond < expectedSpeed * (1 - throughputTolerance)) {
+            err << info.name << ": скорость " << QString::number(m.perSecond, 'f', 0)
+                << ' ' << info.unit << "/s, эталон " << QString::number(expectedSpeed, 'f', 0)
+                << " (допуск " << throughputTolerance * 100 << "%)\n";
+            ++failed;
+        }
+
+        const qint64 expectedAllocations = e.value("allocations").toInteger();
+        const qint64 allowed = qint64(std::floor(double(expectedAllocations) * (1 + allocationTolerance)))
+                             + allocationSlack;
+        if (kCountsAllocations && m.allocations > allowed) {
+            err << info.name << ": выделений за прогон " << m.allocations
+                << ", эталон " << expectedAllocations << " (допустимо до " << allowed << ")\n";
+            ++failed;
+        }
+    }
+
+    if (!found) {
+        err << "Нет нагрузки " << opt.workload << '\n';
+        return 2;
+    }
+
+    if (opt.update) {
+        baseline.insert("tool", "clip-perf");
+        baseline.insert("build", kBuildType);
+        if (!baseline.contains("throughput_tolerance"))
+            baseline.insert("throughput_tolerance", kThroughputTolerance);
+        if (!baseline.contains("allocation_tolerance"))
+            baseline.insert("allocation_tolerance", kAllocationTolerance);
+        if (!baseline.contains("allocation_slack"))
+            baseline.insert("allocation_slack", kAllocationSlack);
+        baseline.insert("workloads", entries);
+        if (!writeJson(opt.baselineFile, baseline)) {
+            err << "Не удалось записать " << opt.baselineFile << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    out << "checksum " << checksum << '\n';
+    return failed == 0 ? 0 : 1;
+}
+
+// ---------- geometry ----------
+
+// Именованный набор строк чисел: "midpoint visible" — строки x1 y1 x2 y2,
+// "sutherland-hodgman polygon" — строки x y и т.п.
+struct Section
+{
+    QString name;
+    QVector<QVector<double>> rows;
+};
+
+void addPoints(QVector<Section> &sections, const QString &name,
+               const QPointF *points, qsizetype count)
+{
+    Section s { name, {} };
+    for (qsizetype i = 0; i < count; ++i)
+        s.rows.append({ points[i].x(), points[i].y() });
+    sections.append(s);
+}
+
+void addLines(QVector<Section> &sections, const QString &name, const QVector<QLineF> &lines)
+{
+    Section s { name, {} };
+    for (const QLineF &l : lines)
+        s.rows.append({ l.x1(), l.y1(), l.x2(), l.y2() });
+    sections.append(s);
+}
+
+// результат отсечения файла всеми подходящими алгоритмами
+bool clipFile(const QString &file, QVector<Section> &sections, QString &message)
+{
+    clip::ParseError error;
+    switch (clip::detectSceneKind(file)) {
+    case clip::SceneKind::Segments: {
+        clip::SegmentScene scene;
+        if (!clip::loadSegmentScene(file, scene, &error))
+            break;
+        const clip::ConvexWindow window = clip::sceneWindow(scene.window, scene.windowPolygon);
+        for (const QString &name : clip::segmentAlgorithmNames()) {
+            clip::SegmentAlgorithm algorithm;
+            clip::segmentAlgorithmFromName(name, algorithm);
+            clip::SegmentClipResult result;
+            clip::createSegmentEngine(algorithm)->clipAll(scene.segments, window, result);
+            addLines(sections, name + " visible", result.visible);
+            addPoints(sections, name + " points",
+                      result.intersections.constData(), result.intersections.size());
+        }
+        return true;
+    }
+    case clip::SceneKind::Polygon: {
+        clip::PolygonScene scene;
+        if (!clip::loadPolygonScene(file, scene, &error))
+            break;
+        clip::PolygonClipResult result;
+        clip::clipPolygonSutherlandHodgman(scene.polygon,
+                                           clip::sceneWindow(scene.window, scene.windowPolygon),
+                                           result);
+        addPoints(sections, "sutherland-hodgman polygon",
+                  result.polygon.constData(), result.polygon.size());
+        addPoints(sections, "sutherland-hodgman points",
+                  result.intersections.constData(), result.intersections.size());
+        return true;
+    }
+    case clip::SceneKind::MultiPolygon: {
+        clip::MultiPolygonScene scene;
+        if (!clip::loadMultiPolygonScene(file, scene, &error))
+            break;
+        clip::PolygonSetClipResult result;
+        clip::PolygonBatchClipper(clip::WorkStealingPool::global())
+            .clip(scene.polygons, clip::sceneWindow(scene.window, scene.windowPolygon), result);
+        for (qsizetype i = 0; i < result.polygons.count(); ++i)
+            addPoints(sections, QString("sutherland-hodgman polygon %1").arg(i),
+                      result.polygons.polygon(i), result.polygons.size(i));
+        addPoints(sections, "sutherland-hodgman points",
+                  result.intersections.vertices.constData(),
+                  result.intersections.vertices.size());
+        return true;
+    }
+    case clip::SceneKind::Polyline: {
+        clip::PolylineScene scene;
+        if (!clip::loadPolylineScene(file, scene, &error))
+            break;
+        clip::PolylineClipResult result;
+        clip::clipPolylines(scene.chains, clip::sceneWindow(scene.window, scene.windowPolygon),
+                            result);
+        for (qsizetype j = 0; j < result.chains.count(); ++j)
+            addPoints(sections, QString("polyline %1 from %2").arg(j).arg(result.source[j]),
+                      result.chains.polygon(j), result.chains.size(j));
+        addPoints(sections, "polyline points",
+                  result.intersections.constData(), result.intersections.size());
+        return true;
+    }
+    case clip::SceneKind::Unknown:
+        message = file + ": количество чисел не подходит ни под отрезки, ни под многоугольник";
+        return false;
+    }
+
+    message = error.toString(file);
+    return false;
+}
+
+// Формат: строка "@ <строк> <имя раздела>", затем строки чисел.
+bool writeSections(const QString &fileName, const QVector<Section> &sections)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QTextStream ts(&f);
+    for (const Section &s : sections) {
+        ts << "@ " << s.rows.size() << ' ' << s.name << '\n';
+        for (const QVector<double> &row : s.rows) {
+            for (qsizetype k = 0; k < row.size(); ++k)
+                ts << (k ? " " : "") << QString::number(row[k], 'g', 12);
+            ts << '\n';
+        }
+    }
+    return ts.status() == QTextStream::Ok;
+}
+
+bool readSections(const QString &fileName, QVector<Section> &sections)
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QTextStream ts(&f);
+    while (!ts.atEnd()) {
+        const QString line = ts.readLine();
+        if (line.isEmpty())
+            continue;
+        if (line.startsWith("@ ")) {
+            const QString header = line.mid(2);
+            const qsizetype space = header.indexOf(' ');
+            if (space < 0)
+                return false;
+            sections.append(Section { header.mid(space + 1), {} });
+            continue;
+        }
+        if (sections.isEmpty())
+            return false;
+        QVector<double> row;
+        for (const QString &v : line.split(' ', Qt::SkipEmptyParts)) {
+            bool ok = false;
+            row.append(v.toDouble(&ok));
+            if (!ok)
+                return false;
+        }
+        sections.last().rows.append(row);
+    }
+    return true;
+}
+
+// первое расхождение или пустая строка
+QString compareSections(const QVector<Section> &actual, const QVector<Section> &expected)
+{
+    if (actual.size() != expected.size())
+        return QString("разделов %1, ожидалось %2").arg(actual.size()).arg(expected.size());
+
+    for (qsizetype i = 0; i < actual.size(); ++i) {
+        const Section &a = actual[i];
+        const Section &e = expected[i];
+        if (a.name != e.name)
+            return QString("раздел \"%1\", ожидался \"%2\"").arg(a.name, e.name);
+        if (a.rows.size() != e.rows.size())
+            return QString("%1: строк %2, ожидалось %3")
+                .arg(a.name).arg(a.rows.size()).arg(e.rows.size());
+        for (qsizetype r = 0; r < a.rows.size(); ++r) {
+            const QVector<double> &x = a.rows[r];
+            const QVector<double> &y = e.rows[r];
+            bool same = x.size() == y.size();
+            for (qsizetype k = 0; same && k < x.size(); ++k)
+                same = std::abs(x[k] - y[k]) <= kGeometryEps * std::max(1.0, std::abs(y[k]));
+            if (!same)
+                return QString("%1: строка %2 отличается").arg(a.name).arg(r + 1);
+        }
+    }
+    return QString();
+}
+
+int runGeometry(const QString &expectedDir, const QStringList &inputs, bool update,
+                QTextStream &out, QTextStream &err)
+{
+    QStringList files;
+    for (const QString &path : inputs) {
+        if (QFileInfo(path).isDir()) {
+            for (const QFileInfo &e :
+                 QDir(path).entryInfoList(QStringList() << "*.txt" << "*.scb",
+                                          QDir::Files, QDir::Name))
+                files.append(e.filePath());
+        } else {
+            files.append(path);
+        }
+    }
+    if (files.isEmpty()) {
+        err << "Нет входных файлов\n";
+        return 1;
+    }
+    if (update && !QDir().mkpath(expectedDir)) {
+        err << "Не удалось создать каталог " << expectedDir << '\n';
+        return 1;
+    }
+
+    int failed = 0;
+    for (const QString &file : std::as_const(files)) {
+        const QString expectedFile =
+            QDir(expectedDir).filePath(QFileInfo(file).completeBaseName() + ".txt");
+
+        QVector<Section> actual;
+        QString message;
+        if (!clipFile(file, actual, message))
+            actual = { Section { "error", {} } };
+
+        if (update) {
+            if (!message.isEmpty())
+                err << message << '\n';
+            if (!writeSections(expectedFile, actual)) {
+                err << "Не удалось записать " << expectedFile << '\n';
+                ++failed;
+            }
+            continue;
+        }
+
+        QVector<Section> expected;
+        if (!readSections(expectedFile, expected)) {
+            err << file << ": нет ожидаемого результата " << expectedFile
+                << ", запустите с --update\n";
+            ++failed;
+            continue;
+        }
+        const QString diff = compareSections(actual, expected);
+        if (!diff.isEmpty()) {
+            err << file << ": " << diff << '\n';
+            if (!message.isEmpty())
+                err << message << '\n';
+            ++failed;
+        }
+    }
+
+    out << "Файлов: " << files.size() << ", расхождений: " << failed << '\n';
+    return failed == 0 ? 0 : 1;
+}
+
+// ---------- generic ----------
+
+namespace g = clip::generic;
+
+// узлов сетки int32 на единицу координат: окно kWindow — ±50000 узлов
+constexpr double kGridScale = 1000;
+
+using FixedGridBox  = g::FixedBox<-50000, -50000, 50000, 50000>;
+using FixedFloatBox = g::FixedBox<-50, -50, 50, 50>;
+
+// перевод координат double <-> тип экземпляра и допуск сравнения с double
+struct FloatCoords
+{
+    using T = float;
+    static float from(double v) { return float(v); }
+    static double to(float v) { return v; }
+    static constexpr double eps = 1e-3;
+};
+
+// середины на сетке отходят от отрезка до 3–4 узлов (см. CoordTraits)
+struct GridCoords
+{
+    using T = std::int32_t;
+    static std::int32_t from(double v) { return std::int32_t(std::lround(v * kGridScale)); }
+    static double to(std::int32_t v) { return v / kGridScale; }
+    static constexpr double eps = 4 / kGridScale;
+};
+
+struct GenericReport
+{
+    QTextStream &err;
+    int checks = 0;
+    int failed = 0;
+
+    // первые расхождения каждого экземпляра — в err
+    void check(bool ok, const QString &name, const QString &what)
+    {
+        ++checks;
+        if (ok)
+            return;
+        if (++failed <= 5)
+            err << name << ": " << what << '\n';
+    }
+};
+
+template<class C>
+bool nearPoint(const g::Point2<typename C::T> &p, const g::Point2<double> &ref)
+{
+    return std::abs(C::to(p.x) - ref.x) <= C::eps && std::abs(C::to(p.y) - ref.y) <= C::eps;
+}
+
+// Конец видимой части p против конца ref у double (отрезок ab, окно box).
+// Поперёк отрезка p отходит на C::eps, а вдоль грани — на C::eps / sin угла
+// между ними, поэтому координаты не сравниваются напрямую: p должен быть
+// у прямой ab и у той же грани (или того же конца отрезка), что и ref.
+template<class C>
+bool sameEnd(const g::Point2<typename C::T> &p, const g::Point2<double> &ref,
+             const g::Point2<double> &a, const g::Point2<double> &b, const g::Box<double> &box)
+{
+    const double x = C::to(p.x), y = C::to(p.y);
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    if (std::abs(dx * (y - a.y) - dy * (x - a.x)) > C::eps * std::hypot(dx, dy))
+        return false;
+
+    if ((ref.x == a.x && ref.y == a.y) || (ref.x == b.x && ref.y == b.y))
+        return std::abs(x - ref.x) <= C::eps && std::abs(y - ref.y) <= C::eps;
+
+    constexpr double onEdge = 1e-5;   // двоичный поиск double останавливается в 1e-6
+    auto sameEdge = [&](double v, double refV, double edge) {
+        return std::abs(refV - edge) > onEdge || std::abs(v - edge) <= C::eps;
+    };
+    return sameEdge(x, ref.x, box.xmin) && sameEdge(x, ref.x, box.xmax) &&
+           sameEdge(y, ref.y, box.ymin) && sameEdge(y, ref.y, box.ymax);
+}
+
+template<class C, class Points, class RefPoints>
+bool nearPoints(const Points &points, const RefPoints &ref)
+{
+    if (points.size() != ref.size())
+        return false;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (!nearPoint<C>(points[i], ref[i]))
+            return false;
+    }
+    return true;
+}
+
+// Отрезки, точки пересечения и многоугольники экземпляром C в окне window
+// против double на тех же (уже переведённых в C) координатах.
+template<class C, class W>
+GenericReport checkInstantiation(const QString &name, const W &window,
+                                 const QVector<QLineF> &segments,
+                                 const QVector<QVector<QPointF>> &polygons, QTextStream &err)
+{
+    using P = g::Point2<typename C::T>;
+    using D = g::Point2<double>;
+    const g::Box<double> box { C::to(typename C::T(window.xmin)), C::to(typename C::T(window.ymin)),
+                               C::to(typename C::T(window.xmax)), C::to(typename C::T(window.ymax)) };
+    auto point = [](const QPointF &q) { return P { C::from(q.x()), C::from(q.y()) }; };
+    auto refPoint = [](const P &p) { return D { C::to(p.x), C::to(p.y) }; };
+    auto length2 = [](const D &a, const D &b) {
+        return (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
+    };
+
+    GenericReport report { err };
+    for (qsizetype i = 0; i < segments.size(); ++i) {
+        const P a = point(segments[i].p1()), b = point(segments[i].p2());
+        const D ra = refPoint(a), rb = refPoint(b);
+
+        P s, e;
+        D rs, re;
+        const bool visible = g::clipMidpoint(a, b, window, s, e);
+        const bool refVisible = g::clipMidpoint(ra, rb, box, rs, re);
+        if (visible != refVisible) {
+            // пороги длины у типов разные: расходиться могут только обрывки
+            const double l2 = visible ? length2(refPoint(s), refPoint(e)) : length2(rs, re);
+            report.check(l2 < 4 * clip::kMinLength2, name,
+                         QString("отрезок %1: видимость %2, у double %3")
+                             .arg(i).arg(visible).arg(refVisible));
+        } else {
+            report.check(!visible || (sameEnd<C>(s, rs, ra, rb, box) &&
+                                      sameEnd<C>(e, re, ra, rb, box)), name,
+                         QString("отрезок %1: видимая часть отличается").arg(i));
+        }
+
+        std::vector<P> points;
+        std::vector<D> refPoints;
+        g::appendRealIntersections(a, b, window, points);
+        g::appendRealIntersections(ra, rb, box, refPoints);
+        report.check(nearPoints<C>(points, refPoints), name,
+                     QString("отрезок %1: точки пересечения отличаются").arg(i));
+    }
+
+    for (qsizetype k = 0; k < polygons.size(); ++k) {
+        std::vector<P> in;
+        std::vector<D> refIn;
+        for (const QPointF &q : polygons[k]) {
+            in.push_back(point(q));
+            refIn.push_back(refPoint(in.back()));
+        }
+        std::vector<P> out, points;
+        std::vector<D> refOut, refPoints;
+        g::appendPolygonSutherlandHodgman(in.data(), in.size(), window, out, points);
+        g::appendPolygonSutherlandHodgman(refIn.data(), refIn.size(), box, refOut, refPoints);
+        report.check(nearPoints<C>(out, refOut) && nearPoints<C>(points, refPoints), name,
+                     QString("многоугольник %1 отличается").arg(k));
+    }
+    return report;
+}
+
+// Сетка int32 на всём диапазоне: разность концов — 33 бита, квадрат длины
+// не помещается в int64.
+GenericReport checkGridRange(QTextStream &err)
+{
+    using P = g::Point2<std::int32_t>;
+    const g::Box<std::int32_t> window { -2000000000, -2000000000, 2000000000, 2000000000 };
+    GenericReport report { err };
+
+    P s, e;
+    const bool visible = g::clipMidpoint(P { -2100000000, 0 }, P { 2100000000, 5 }, window, s, e);
+    report.check(visible && s.x == window.xmin && e.x == window.xmax &&
+                 std::abs(s.y - 0) <= 1 && std::abs(e.y - 5) <= 1,
+                 "int32/range", "отрезок через всё окно отсечён неверно");
+
+    // ромб с вершинами за гранями: в результате — восьмиугольник
+    const P diamond[] = { { 0, -2100000000 }, { 2100000000, 0 },
+                          { 0, 2100000000 }, { -2100000000, 0 } };
+    std::vector<P> out;
+    g::Discard<P> noPoints;
+    g::appendPolygonSutherlandHodgman(diamond, 4, window, out, noPoints);
+    bool inside = out.size() == 8;
+    for (const P &p : out)
+        inside = inside && g::pointInside(p, window);
+    report.check(inside, "int32/range",
+                 QString("ромб вокруг окна: %1 вершин, ожидалось 8 в окне").arg(out.size()));
+    return report;
+}
+
+int runGeneric(QTextStream &out, QTextStream &err)
+{
+    std::mt19937 rng(kSeed);
+    QVector<QLineF> segments =
+        workload::randomSegments(rng, 2000, workload::SegmentMix { 0.3, 0.3, 0.3 }, kWindow);
+    segments += workload::longDiagonals(rng, 200, kWindow);
+    const QVector<QVector<QPointF>> polygons = {
+        workload::zigZagPolygon(rng, 64, kWindow),
+        workload::convexNgon(64, kWindow),
+    };
+
+    const g::Box<float> floatBox { -50, -50, 50, 50 };
+    const g::Box<std::int32_t> gridBox { -50000, -50000, 50000, 50000 };
+
+    int failed = 0;
+    auto summary = [&](const QString &name, const GenericReport &report) {
+        out << name << ": проверок " << report.checks
+            << ", расхождений " << report.failed << '\n';
+        failed += report.failed;
+    };
+    summary("float/box",
+            checkInstantiation<FloatCoords>("float/box", floatBox, segments, polygons, err));
+    summary("float/fixed",
+            checkInstantiation<FloatCoords>("float/fixed", FixedFloatBox {}, segments, polygons, err));
+    summary("int32/box",
+            checkInstantiation<GridCoords>("int32/box", gridBox, segments, polygons, err));
+    summary("int32/fixed",
+            checkInstantiation<GridCoords>("int32/fixed", FixedGridBox {}, segments, polygons, err));
+    summary("int32/range", checkGridRange(err));
+    return failed == 0 ? 0 : 1;
+}
+
+// ---------- отрисовка clip-batch render ----------
+
+// 256 × 256 плитками по 64 пикселя (наименьшая плитка): 16 плиток, по три
+// шва на ось
+const QSize kRenderSize(256, 256);
+constexpr int kRenderTile = 64;
+
+// Штрих Qt начинает заново там, где обрезает линию по своей плитке, поэтому
+// у штриховых исходных примитивов рисунки плитками и одной плиткой законно
+// расходятся (и полупрозрачные кружки поверх них тоже). Такие пиксели не
+// сравниваются; у остальных допускается разница каналов до kRenderTolerance.
+constexpr double kDashedSkipPx    = 2.0;
+constexpr int    kRenderTolerance = 16;
+
+bool renderWithClipBatch(const QString &clipBatch, const QString &file,
+                         const QStringList &options, const QString &png,
+                         QImage &image, QTextStream &err)
+{
+    QProcess process;
+    process.start(clipBatch, QStringList { "render" } + options + QStringList { file, png });
+    if (!process.waitForFinished(60000) || process.exitStatus() != QProcess::NormalExit ||
+        process.exitCode() != 0) {
+        err << file << ": clip-batch render " << options.join(' ')
+            << " завершился с ошибкой\n"
+            << QString::fromLocal8Bit(process.readAllStandardError());
+        return false;
+    }
+    if (!image.load(png) || image.size() != kRenderSize) {
+        err << png << ": рисунок не прочитан или не того размера\n";
+        return false;
+    }
+    return true;
+}
+
+// Цвет по преобладающему каналу: точное значение у пера толщиной 2 в
+// дробных координатах зависит от растеризатора и версии Qt.
+bool isBlue(QRgb c)
+{
+    return qBlue(c) >= 160 && qRed(c) <= 96 && qGreen(c) <= 96;
+}
+
+bool isRed(QRgb c)
+{
+    return qRed(c) >= 160 && qGreen(c) <= 96 && qBlue(c) <= 96;
+}
+
+// в квадрате 3 × 3 вокруг p есть пиксель, подходящий под match
+bool hasPixel(const QImage &image, const QPointF &p, bool (*match)(QRgb))
+{
+    const int cx = int(std::floor(p.x())), cy = int(std::floor(p.y()));
+    for (int y = cy - 1; y <= cy + 1; ++y) {
+        for (int x = cx - 1; x <= cx + 1; ++x) {
+            if (image.valid(x, y) && match(image.pixel(x, y)))
+                return true;
+        }
+    }
+    return false;
+}
+
+int channelDifference(QRgb a, QRgb b)
+{
+    return std::max({ std::abs(qRed(a) - qRed(b)), std::abs(qGreen(a) - qGreen(b)),
+                      std::abs(qBlue(a) - qBlue(b)) });
+}
+
+double distanceToSegment(const QPointF &p, const QLineF &s)
+{
+    const QPointF d = s.p2() - s.p1();
+    const double len2 = QPointF::dotProduct(d, d);
+    const double t = len2 > 0
+        ? std::clamp(QPointF::dotProduct(p - s.p1(), d) / len2, 0.0, 1.0) : 0.0;
+    const QPointF q = s.p1() + t * d - p;
+    return std::hypot(q.x(), q.y());
+}
+
+int checkRender(const QString &clipBatch, const QString &file,
+                QTextStream &out, QTextStream &err)
+{
+    const QString size = QString("%1x%2").arg(kRenderSize.width()).arg(kRenderSize.height());
+    const QStringList tiled { "--size", size, "--tile", QString::number(kRenderTile) };
+    const QStringList single {
+        "--size", size,
+        "--tile", QString::number(std::max(kRenderSize.width(), kRenderSize.height()))
+    };
+
+    QTemporaryDir dir;
+    QImage tiledImage, singleImage, plainImage;
+    if (!dir.isValid() ||
+        !renderWithClipBatch(clipBatch, file, tiled, dir.filePath("tiled.png"), tiledImage, err) ||
+        !renderWithClipBatch(clipBatch, file, single, dir.filePath("single.png"), singleImage, err) ||
+        !renderWithClipBatch(clipBatch, file, tiled + QStringList { "--no-grid" },
+                             dir.filePath("plain.png"), plainImage, err))
+        return 1;
+
+    render::Scene scene;
+    QString message;
+    if (!render::loadScene(file, clip::SegmentAlgorithm::Midpoint, scene, message)) {
+        err << message << '\n';
+        return 1;
+    }
+    auto px = [&](const QPointF &p) { return render::imagePoint(scene, kRenderSize, p); };
+
+    // видимые части (красные), исходные (серые штриховые) и кружки точек
+    // пересечения — в пикселях
+    QVector<QLineF> visible, dashed;
+    auto addChains = [&](const clip::PolygonSet &chains, QVector<QLineF> &to) {
+        for (qsizetype k = 0; k < chains.count(); ++k) {
+            const QPointF *v = chains.polygon(k);
+            for (qsizetype i = 0; i + 1 < chains.size(k); ++i)
+                to.append(QLineF(px(v[i]), px(v[i + 1])));
+        }
+    };
+    if (scene.kind == clip::SceneKind::Segments) {
+        for (const QLineF &s : std::as_const(scene.clippedSegments))
+            visible.append(QLineF(px(s.p1()), px(s.p2())));
+        for (const QLineF &s : std::as_const(scene.segments))
+            dashed.append(QLineF(px(s.p1()), px(s.p2())));
+    } else if (scene.kind == clip::SceneKind::Polyline) {
+        addChains(scene.clippedShapes, visible);
+        addChains(scene.shapes, dashed);
+    }
+    QVector<QPointF> dots;
+    for (const QPointF &p : std::as_const(scene.points))
+        dots.append(px(p));
+
+    // кружки (радиус 5) рисуются поверх частей, части — поверх окна
+    auto nearDot = [&](const QPointF &p) {
+        for (const QPointF &d : std::as_const(dots)) {
+            if (std::hypot(p.x() - d.x(), p.y() - d.y()) < 8)
+                return true;
+        }
+        return false;
+    };
+    auto nearVisible = [&](const QPointF &p) {
+        for (const QLineF &s : std::as_const(visible)) {
+            if (distanceToSegment(p, s) < 4)
+                return true;
+        }
+        return false;
+    };
+
+    int failed = 0;
+    qsizetype windowChecks = 0, visibleChecks = 0;
+
+    QVector<QPointF> window = scene.windowPolygon;
+    if (window.isEmpty()) {
+        const QRectF &w = scene.window;
+        window = { w.topLeft(), w.topRight(), w.bottomRight(), w.bottomLeft() };
+    }
+    for (qsizetype i = 0; i < window.size(); ++i) {
+        const QPointF a = px(window[i]);
+        const QPointF b = px(window[(i + 1) % window.size()]);
+        for (int k = 0; k < 8; ++k) {
+            const QPointF p = a + (k + 0.5) / 8 * (b - a);
+            if (nearDot(p) || nearVisible(p))
+                continue;
+            ++windowChecks;
+            if (!hasPixel(plainImage, p, isBlue)) {
+                ++failed;
+                err << file << ": грань окна не синяя в (" << p.x() << ", " << p.y() << ")\n";
+            }
+        }
+    }
+
+    for (const QLineF &s : std::as_const(visible)) {
+        const QPointF mid = s.center();
+        if (s.length() < 12 || nearDot(mid))
+            continue;
+        ++visibleChecks;
+        if (!hasPixel(plainImage, mid, isRed)) {
+            ++failed;
+            err << file << ": видимая часть не красная в (" << mid.x() << ", " << mid.y() << ")\n";
+        }
+    }
+    if (windowChecks == 0 || visibleChecks == 0) {
+        ++failed;
+        err << file << ": на рисунке нечего проверить (нужны окно и видимые части)\n";
+    }
+
+    // плитки против одной плитки — по всему рисунку с сеткой
+    auto nearDashed = [&](int x, int y) {
+        const QPointF c(x + 0.5, y + 0.5);
+        for (const QLineF &s : std::as_const(dashed)) {
+            if (distanceToSegment(c, s) < kDashedSkipPx)
+                return true;
+        }
+        return false;
+    };
+    qsizetype tileDiffs = 0;
+    for (int y = 0; y < kRenderSize.height(); ++y) {
+        for (int x = 0; x < kRenderSize.width(); ++x) {
+            const QRgb a = tiledImage.pixel(x, y), b = singleImage.pixel(x, y);
+            if (a != b && channelDifference(a, b) > kRenderTolerance && !nearDashed(x, y))
+                ++tileDiffs;
+        }
+    }
+    if (tileDiffs > 0) {
+        ++failed;
+        err << file << ": " << tileDiffs
+            << " пикселей рисунка плитками отличаются от рисунка одной плиткой\n";
+    }
+
+    out << file << ": окно " << windowChecks << ", видимые части " << visibleChecks
+        << ", отличий от одной плитки " << tileDiffs << '\n';
+    return failed == 0 ? 0 : 1;
+}
+
+int runRenderChecks(const QString &clipBatch, const QStringList &files,
+                    QTextStream &out, QTextStream &err)
+{
+    int failed = 0;
+    for (const QString &file : files)
+        failed += checkRender(clipBatch, file, out, err);
+    out << "Файлов: " << files.size() << ", с ошибками: " << failed << '\n';
+    return failed == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QString command = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString();
+    if (command == "-h" || command == "--help") {
+        printUsage(out);
+        return 0;
+    }
+    if (command != "run" && command != "geometry" && command != "generic" &&
+        command != "render") {
+        printUsage(err);
+        return 2;
+    }
+    if (command == "generic") {
+        if (argc != 2) {
+            printUsage(err);
+            return 2;
+        }
+        return runGeneric(out, err);
+    }
+
+    RunOptions run;
+    QString expectedDir;
+    QString clipBatch;
+    QStringList inputs;
+    bool update = false;
+
+    for (int i = 2; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        auto next = [&](QString &value) {
+            if (++i >= argc)
+                return false;
+            value = QString::fromLocal8Bit(argv[i]);
+            return true;
+        };
+
+        QString value;
+        bool ok = true;
+        if (arg == "--update") {
+            update = true;
+        } else if (command == "run" && arg == "--baseline") {
+            ok = next(run.baselineFile);
+        } else if (command == "run" && arg == "--workload") {
+            ok = next(run.workload);
+        } else if (command == "run" && arg == "--repeat") {
+            ok = next(value);
+            run.repeat = value.toInt(&ok);
+            ok = ok && run.repeat >= 1;
+        } else if (command == "run" && arg == "--tolerance") {
+            ok = next(value);
+            run.tolerance = value.toDouble(&ok);
+            ok = ok && run.tolerance >= 0 && run.tolerance < 1;
+        } else if (command == "geometry" && arg == "--expected") {
+            ok = next(expectedDir);
+        } else if (command == "geometry") {
+            inputs.append(arg);
+        } else if (command == "render" && arg == "--clip-batch") {
+            ok = next(clipBatch);
+        } else if (command == "render") {
+            inputs.append(arg);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            printUsage(err);
+            return 2;
+        }
+    }
+
+    if (command == "run") {
+        if (run.baselineFile.isEmpty()) {
+            printUsage(err);
+            return 2;
+        }
+        run.update = update;
+        return runPerf(run, out, err);
+    }
+
+    if (command == "render") {
+        if (clipBatch.isEmpty() || inputs.isEmpty()) {
+            printUsage(err);
+            return 2;
+        }
+        return runRenderChecks(clipBatch, inputs, out, err);
+    }
+
+    if (expectedDir.isEmpty() || inputs.isEmpty()) {
+        printUsage(err);
+        return 2;
+    }
+    return runGeometry(expectedDir, inputs, update, out, err);
+}
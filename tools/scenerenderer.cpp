@@ -0,0 +1,558 @@
+#include "scenerenderer.h"
+
+#include "clipcore/binaryformat.h"
+#include "clipcore/parallelclipper.h"
+#include "clipcore/polygonbatch.h"
+#include "clipcore/polygonclipper.h"
+#include "clipcore/polylineclipper.h"
+
+#include <QFont>
+#include <QPainter>
+#include <QPen>
+#include <algorithm>
+#include <cmath>
+
+namespace render {
+
+namespace {
+
+// поля вокруг сцены, доля её размера
+constexpr double kMarginFraction = 0.05;
+// линии сетки не гуще, пикселей
+constexpr double kMinGridPx = 8.0;
+// запас при отборе примитивов плитки: половина кружка точки и сглаживание
+constexpr double kCullMarginPx = 8.0;
+
+// ---------- загрузка ----------
+
+void clipSegments(Scene &scene, clip::SegmentAlgorithm algorithm,
+                  clip::WorkStealingPool &pool)
+{
+    clip::SegmentClipResult result;
+    clip::clipSegmentsParallel(scene.segments,
+                               clip::sceneWindow(scene.window, scene.windowPolygon),
+                               *clip::createSegmentEngine(algorithm), result, pool);
+    scene.kind = clip::SceneKind::Segments;
+    scene.clippedSegments = std::move(result.visible);
+    scene.points = std::move(result.intersections);
+}
+
+void clipPolygon(Scene &scene, const QVector<QPointF> &polygon)
+{
+    clip::PolygonClipResult result;
+    clip::clipPolygonSutherlandHodgman(polygon,
+                                       clip::sceneWindow(scene.window, scene.windowPolygon),
+                                       result);
+    scene.kind = clip::SceneKind::Polygon;
+    scene.shapes.append(polygon.constData(), polygon.size());
+    scene.clippedShapes.append(result.polygon.constData(), result.polygon.size());
+    scene.points = std::move(result.intersections);
+}
+
+// ---------- отображение в пиксели ----------
+
+// Логические координаты -> пиксели всего рисунка: сцена вписывается
+// с полями и одинаковым масштабом по осям, Y вверх.
+struct Viewport
+{
+    double  scale = 1.0;
+    QPointF origin;   // пиксель логической точки (0, 0)
+
+    QPointF map(const QPointF &g) const
+    {
+        return QPointF(origin.x() + g.x() * scale, origin.y() - g.y() * scale);
+    }
+    QLineF map(const QLineF &s) const { return QLineF(map(s.p1()), map(s.p2())); }
+
+    QPointF unmap(const QPointF &s) const
+    {
+        return QPointF((s.x() - origin.x()) / scale, (origin.y() - s.y()) / scale);
+    }
+};
+
+QRectF sceneBounds(const Scene &scene)
+{
+    double xmin = scene.window.left(), xmax = scene.window.right();
+    double ymin = scene.window.top(),  ymax = scene.window.bottom();
+    auto add = [&](const QPointF &p) {
+        xmin = std::min(xmin, p.x()); xmax = std::max(xmax, p.x());
+        ymin = std::min(ymin, p.y()); ymax = std::max(ymax, p.y());
+    };
+    for (const QLineF &s : scene.segments) {
+        add(s.p1());
+        add(s.p2());
+    }
+    for (const QPointF &p : scene.shapes.vertices)
+        add(p);
+    return QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax));
+}
+
+Viewport fitViewport(const QRectF &bounds, const QSize &size)
+{
+    double margin = kMarginFraction * std::max(bounds.width(), bounds.height());
+    if (margin <= 0.0)
+        margin = 1.0;
+    const QRectF area = bounds.adjusted(-margin, -margin, margin, margin);
+
+    Viewport v;
+    v.scale = std::min(size.width() / area.width(), size.height() / area.height());
+    // по центру рисунка
+    const QPointF centre = area.center();
+    v.origin = QPointF(size.width() / 2.0 - centre.x() * v.scale,
+                       size.height() / 2.0 + centre.y() * v.scale);
+    return v;
+}
+
+// шаг сетки — 1, 2 или 5 × 10^k, не мельче kMinGridPx пикселей
+double gridStep(double scale)
+{
+    const double base = std::pow(10.0, std::floor(std::log10(kMinGridPx / scale)));
+    for (double m : { 1.0, 2.0, 5.0 }) {
+        if (base * m * scale >= kMinGridPx)
+            return base * m;
+    }
+    return base * 10.0;
+}
+
+// Номера примитивов по плиткам (сжато: начало плитки — в start), в
+// порядке входа. Примитив попадает во все плитки, которые задевает его
+// рамка с запасом kCullMarginPx.
+struct TileBins
+{
+    QVector<qsizetype> start;   // плиток + 1
+    QVector<quint32>   items;
+
+    const quint32 *begin(qsizetype t) const { return items.constData() + start[t]; }
+    const quint32 *end(qsizetype t) const   { return items.constData() + start[t + 1]; }
+};
+
+// Разбиение рисунка на плитки tile × tile: cols × rows, построчно.
+struct TileLayout
+{
+    QSize size;
+    int   tile = 0;
+    int   cols = 0, rows = 0;
+
+    qsizetype count() const { return qsizetype(cols) * rows; }
+    QRect area(qsizetype t) const
+    {
+        return QRect(int(t % cols) * tile, int(t / cols) * tile, tile, tile)
+                   .intersected(QRect(QPoint(0, 0), size));
+    }
+};
+
+// Раскладка n рамок по плиткам за два прохода (подсчёт, затем запись),
+// один раз на рисунок: плитка потом перебирает только своё, а не все
+// примитивы сцены. Рамки целиком вне рисунка и с NaN не попадают никуда.
+template<class BoxOf>
+TileBins binByTile(const TileLayout &layout, qsizetype n, BoxOf boxOf)
+{
+    TileBins bins;
+    bins.start.fill(0, layout.count() + 1);
+
+    const double w = layout.size.width(), h = layout.size.height();
+    const double m = kCullMarginPx;
+    auto forTiles = [&](qsizetype i, auto visit) {
+        const QRectF b = boxOf(i);
+        if (!(b.right() + m >= 0 && b.left() - m <= w && b.bottom() + m >= 0 && b.top() - m <= h))
+            return;
+        auto tileOf = [&](double px, int last) {
+            return int(std::clamp(std::floor(px / layout.tile), 0.0, double(last)));
+        };
+        const int tx0 = tileOf(b.left() - m, layout.cols - 1);
+        const int tx1 = tileOf(b.right() + m, layout.cols - 1);
+        const int ty0 = tileOf(b.top() - m, layout.rows - 1);
+        const int ty1 = tileOf(b.bottom() + m, layout.rows - 1);
+        for (int ty = ty0; ty <= ty1; ++ty)
+            for (int tx = tx0; tx <= tx1; ++tx)
+                visit(qsizetype(ty) * layout.cols + tx);
+    };
+
+    qsizetype *start = bins.start.data();
+    for (qsizetype i = 0; i < n; ++i)
+        forTiles(i, [start](qsizetype t) { ++start[t + 1]; });
+    for (qsizetype t = 0; t < layout.count(); ++t)
+        start[t + 1] += start[t];
+
+    bins.items.resize(start[layout.count()]);
+    quint32 *items = bins.items.data();
+    QVector<qsizetype> fill(bins.start.constBegin(), bins.start.constEnd() - 1);
+    qsizetype *next = fill.data();
+    for (qsizetype i = 0; i < n; ++i)
+        forTiles(i, [&](qsizetype t) { items[next[t]++] = quint32(i); });
+    return bins;
+}
+
+TileBins binLines(const TileLayout &layout, const QVector<QLineF> &lines)
+{
+    const QLineF *l = lines.constData();
+    return binByTile(layout, lines.size(), [l](qsizetype i) {
+        return QRectF(QPointF(std::min(l[i].x1(), l[i].x2()), std::min(l[i].y1(), l[i].y2())),
+                      QPointF(std::max(l[i].x1(), l[i].x2()), std::max(l[i].y1(), l[i].y2())));
+    });
+}
+
+TileBins binBoxes(const TileLayout &layout, const QVector<QRectF> &boxes)
+{
+    const QRectF *b = boxes.constData();
+    return binByTile(layout, boxes.size(), [b](qsizetype i) { return b[i]; });
+}
+
+TileBins binPoints(const TileLayout &layout, const QVector<QPointF> &points)
+{
+    const QPointF *pt = points.constData();
+    return binByTile(layout, points.size(), [pt](qsizetype i) { return QRectF(pt[i], QSizeF(0, 0)); });
+}
+
+// Примитивы в пикселях рисунка, их рамки и раскладка по плиткам; общие
+// для всех плиток и только читаются ими.
+struct ScreenScene
+{
+    QVector<QLineF>  segments;
+    QVector<QLineF>  clippedSegments;
+    clip::PolygonSet shapes;
+    clip::PolygonSet clippedShapes;
+    QVector<QRectF>  shapeBounds;
+    QVector<QRectF>  clippedShapeBounds;
+    QVector<QPointF> points;
+    QVector<QPointF> window;
+
+    TileBins segmentBins, clippedSegmentBins;
+    TileBins shapeBins, clippedShapeBins;
+    TileBins pointBins;
+};
+
+void mapShapes(const Viewport &v, const clip::PolygonSet &in,
+               clip::PolygonSet &out, QVector<QRectF> &bounds)
+{
+    out.offsets = in.offsets;
+    out.vertices.resize(in.vertices.size());
+    for (qsizetype i = 0; i < in.vertices.size(); ++i)
+        out.vertices[i] = v.map(in.vertices[i]);
+
+    bounds.resize(out.count());
+    for (qsizetype k = 0; k < out.count(); ++k) {
+        const QPointF *p = out.polygon(k);
+        const qsizetype n = out.size(k);
+        if (n == 0)
+            continue;
+        double xmin = p[0].x(), xmax = xmin, ymin = p[0].y(), ymax = ymin;
+        for (qsizetype i = 1; i < n; ++i) {
+            xmin = std::min(xmin, p[i].x()); xmax = std::max(xmax, p[i].x());
+            ymin = std::min(ymin, p[i].y()); ymax = std::max(ymax, p[i].y());
+        }
+        bounds[k] = QRectF(QPointF(xmin, ymin), QPointF(xmax, ymax));
+    }
+}
+
+ScreenScene mapScene(const Scene &scene, const Viewport &v, const TileLayout &layout)
+{
+    ScreenScene s;
+    s.segments.reserve(scene.segments.size());
+    for (const QLineF &l : scene.segments)
+        s.segments.append(v.map(l));
+    s.clippedSegments.reserve(scene.clippedSegments.size());
+    for (const QLineF &l : scene.clippedSegments)
+        s.clippedSegments.append(v.map(l));
+
+    mapShapes(v, scene.shapes, s.shapes, s.shapeBounds);
+    mapShapes(v, scene.clippedShapes, s.clippedShapes, s.clippedShapeBounds);
+
+    s.points.reserve(scene.points.size());
+    for (const QPointF &p : scene.points)
+        s.points.append(v.map(p));
+
+    if (scene.windowPolygon.isEmpty()) {
+        const QRectF &w = scene.window;
+        s.window = { v.map(w.topLeft()), v.map(w.topRight()),
+                     v.map(w.bottomRight()), v.map(w.bottomLeft()) };
+    } else {
+        for (const QPointF &p : scene.windowPolygon)
+            s.window.append(v.map(p));
+    }
+
+    s.segmentBins = binLines(layout, s.segments);
+    s.clippedSegmentBins = binLines(layout, s.clippedSegments);
+    s.shapeBins = binBoxes(layout, s.shapeBounds);
+    s.clippedShapeBins = binBoxes(layout, s.clippedShapeBounds);
+    s.pointBins = binPoints(layout, s.points);
+    return s;
+}
+
+// ---------- плитка ----------
+
+// сетка и оси в пикселях area (как drawGridAndAxes холста, без подписей)
+void drawGrid(QPainter &p, const QRect &area, const Viewport &v, double step)
+{
+    const QPointF a = v.unmap(area.topLeft());
+    const QPointF b = v.unmap(area.bottomRight() + QPoint(1, 1));
+    const qint64 kxMin = qint64(std::floor(std::min(a.x(), b.x()) / step));
+    const qint64 kxMax = qint64(std::ceil (std::max(a.x(), b.x()) / step));
+    const qint64 kyMin = qint64(std::floor(std::min(a.y(), b.y()) / step));
+    const qint64 kyMax = qint64(std::ceil (std::max(a.y(), b.y()) / step));
+
+    const QColor fine(235, 235, 235);   // шаг
+    const QColor mid (210, 210, 210);   // 5 шагов
+    const QColor bold(180, 180, 180);   // 10 шагов
+    auto pen = [&](qint64 k) {
+        return QPen(k % 10 == 0 ? bold : k % 5 == 0 ? mid : fine, 1);
+    };
+
+    for (qint64 k = kxMin; k <= kxMax; ++k) {
+        const double x = v.map(QPointF(k * step, 0)).x();
+        p.setPen(pen(k));
+        p.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom() + 1));
+    }
+    for (qint64 k = kyMin; k <= kyMax; ++k) {
+        const double y = v.map(QPointF(0, k * step)).y();
+        p.setPen(pen(k));
+        p.drawLine(QPointF(area.left(), y), QPointF(area.right() + 1, y));
+    }
+
+    p.setPen(QPen(QColor(60, 60, 60), 2));
+    p.drawLine(QPointF(area.left(), v.origin.y()), QPointF(area.right() + 1, v.origin.y()));
+    p.drawLine(QPointF(v.origin.x(), area.top()), QPointF(v.origin.x(), area.bottom() + 1));
+}
+
+// Слои холста (ClippingCanvas::paintEvent) в плитке t: рисуются только
+// примитивы из её раскладки.
+void drawLayers(QPainter &p, const Scene &scene, const ScreenScene &s, qsizetype t)
+{
+    p.setPen(QPen(Qt::blue, 2));
+    p.setBrush(Qt::NoBrush);
+    p.drawPolygon(s.window.constData(), int(s.window.size()));
+
+    QVector<QLineF> lines;
+    auto drawSegments = [&](const QVector<QLineF> &segments, const TileBins &bins) {
+        lines.clear();
+        for (const quint32 *i = bins.begin(t); i != bins.end(t); ++i)
+            lines.append(segments[*i]);
+        p.drawLines(lines.constData(), int(lines.size()));
+    };
+
+    auto drawShapes = [&](const clip::PolygonSet &shapes, const TileBins &bins, bool closed) {
+        for (const quint32 *k = bins.begin(t); k != bins.end(t); ++k) {
+            if (shapes.size(*k) == 0)
+                continue;
+            if (closed)
+                p.drawPolygon(shapes.polygon(*k), int(shapes.size(*k)));
+            else
+                p.drawPolyline(shapes.polygon(*k), int(shapes.size(*k)));
+        }
+    };
+
+    // кружки точек пересечения — круглые точки толстого пера
+    auto drawDots = [&](const QColor &color) {
+        QVector<QPointF> dots;
+        for (const quint32 *i = s.pointBins.begin(t); i != s.pointBins.end(t); ++i)
+            dots.append(s.points[*i]);
+        p.save();
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setPen(QPen(color, 10, Qt::SolidLine, Qt::RoundCap));
+        p.drawPoints(dots.constData(), int(dots.size()));
+        p.restore();
+    };
+
+    switch (scene.kind) {
+    case clip::SceneKind::Segments:
+        p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        drawSegments(s.segments, s.segmentBins);
+        p.setPen(QPen(Qt::red, 2));
+        drawSegments(s.clippedSegments, s.clippedSegmentBins);
+        drawDots(QColor(255, 120, 120, 180));
+        break;
+    case clip::SceneKind::Polygon:
+    case clip::SceneKind::MultiPolygon:
+        p.setPen(QPen(QColor(200, 80, 80), 2, Qt::DashLine));
+        drawShapes(s.shapes, s.shapeBins, true);
+        drawDots(QColor(120, 150, 255, 200));
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setPen(QPen(QColor(0, 150, 0), 3));
+        p.setBrush(QColor(0, 150, 0, 40));
+        drawShapes(s.clippedShapes, s.clippedShapeBins, true);
+        break;
+    case clip::SceneKind::Polyline:
+        p.setPen(QPen(Qt::gray, 1, Qt::DashLine));
+        drawShapes(s.shapes, s.shapeBins, false);
+        p.setPen(QPen(Qt::red, 2));
+        drawShapes(s.clippedShapes, s.clippedShapeBins, false);
+        drawDots(QColor(255, 120, 120, 180));
+        break;
+    case clip::SceneKind::Unknown:
+        break;
+    }
+}
+
+// подписи делений, как на холсте: каждые 2 линии, у частой сетки — 5
+void drawGridLabels(QPainter &p, const QSize &size, const Viewport &v, double step)
+{
+    const double stepPx = step * v.scale;
+    const int every = stepPx < 20 ? 5 : 2;
+    const QPointF a = v.unmap(QPointF(0, 0));
+    const QPointF b = v.unmap(QPointF(size.width(), size.height()));
+
+    QFont f = p.font();
+    f.setPointSize(8);
+    p.setFont(f);
+    p.setPen(Qt::black);
+
+    const double ox = v.origin.x();
+    const double oy = v.origin.y();
+    const qint64 kxMin = qint64(std::floor(std::min(a.x(), b.x()) / step / every)) * every;
+    const qint64 kxMax = qint64(std::ceil (std::max(a.x(), b.x()) / step));
+    for (qint64 k = kxMin; k <= kxMax; k += every) {
+        if (k == 0)
+            continue;
+        const QPointF pt = v.map(QPointF(k * step, 0));
+        p.drawText(QPointF(pt.x() + 2, oy - 2), QString::number(k * step));
+    }
+    const qint64 kyMin = qint64(std::floor(std::min(a.y(), b.y()) / step / every)) * every;
+    const qint64 kyMax = qint64(std::ceil (std::max(a.y(), b.y()) / step));
+    for (qint64 k = kyMin; k <= kyMax; k += every) {
+        const QPointF pt = v.map(QPointF(0, k * step));
+        p.drawText(QPointF(ox + 4, pt.y() - 2), k == 0 ? QString("0") : QString::number(k * step));
+    }
+}
+
+} // namespace
+
+bool loadScene(const QString &fileName, clip::SegmentAlgorithm algorithm,
+               Scene &scene, QString &error, clip::WorkStealingPool &pool)
+{
+    scene = Scene();
+
+    if (clip::isBinarySceneFile(fileName)) {
+        clip::MappedScene mapped;
+        QString message;
+        if (!mapped.open(fileName, &message)) {
+            error = fileName + ": " + message;
+            return false;
+        }
+        scene.window = mapped.window();
+        if (mapped.kind() == clip::SceneKind::Polygon) {
+            clipPolygon(scene, mapped.polygon());
+        } else {
+            scene.segments = mapped.segments();
+            clipSegments(scene, algorithm, pool);
+        }
+        return true;
+    }
+
+    clip::NumberText text;
+    clip::ParseError parseError;
+    if (!clip::parseNumbersFile(fileName, text, parseError, pool)) {
+        error = parseError.toString(fileName);
+        return false;
+    }
+
+    switch (clip::detectSceneKind(text)) {
+    case clip::SceneKind::Segments: {
+        clip::SegmentScene s;
+        if (!clip::segmentSceneFromNumbers(text, s, parseError))
+            break;
+        scene.segments = std::move(s.segments);
+        scene.window = s.window;
+        scene.windowPolygon = s.windowPolygon;
+        clipSegments(scene, algorithm, pool);
+        return true;
+    }
+    case clip::SceneKind::Polygon: {
+        clip::PolygonScene s;
+        if (!clip::polygonSceneFromNumbers(text, s, parseError))
+            break;
+        scene.window = s.window;
+        scene.windowPolygon = s.windowPolygon;
+        clipPolygon(scene, s.polygon);
+        return true;
+    }
+    case clip::SceneKind::MultiPolygon: {
+        clip::MultiPolygonScene s;
+        if (!clip::multiPolygonSceneFromNumbers(text, s, parseError))
+            break;
+        clip::PolygonSetClipResult result;
+        clip::PolygonBatchClipper(pool).clip(s.polygons,
+                                             clip::sceneWindow(s.window, s.windowPolygon),
+                                             result);
+        scene.kind = clip::SceneKind::MultiPolygon;
+        scene.shapes = std::move(s.polygons);
+        scene.clippedShapes = std::move(result.polygons);
+        scene.points = std::move(result.intersections.vertices);
+        scene.window = s.window;
+        scene.windowPolygon = s.windowPolygon;
+        return true;
+    }
+    case clip::SceneKind::Polyline: {
+        clip::PolylineScene s;
+        if (!clip::polylineSceneFromNumbers(text, s, parseError))
+            break;
+        clip::PolylineClipResult result;
+        clip::clipPolylines(s.chains, clip::sceneWindow(s.window, s.windowPolygon), result);
+        scene.kind = clip::SceneKind::Polyline;
+        scene.shapes = std::move(s.chains);
+        scene.clippedShapes = std::move(result.chains);
+        scene.points = std::move(result.intersections);
+        scene.window = s.window;
+        scene.windowPolygon = s.windowPolygon;
+        return true;
+    }
+    case clip::SceneKind::Unknown:
+        error = fileName + ": количество чисел не подходит ни под отрезки, "
+                           "ни под многоугольник";
+        return false;
+    }
+
+    error = parseError.toString(fileName);
+    return false;
+}
+
+QImage renderScene(const Scene &scene, const Options &options, clip::WorkStealingPool &pool)
+{
+    QImage image(options.size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+        return image;
+
+    TileLayout layout;
+    layout.size = options.size;
+    layout.tile = std::max(options.tileSize, 64);
+    layout.cols = (options.size.width() + layout.tile - 1) / layout.tile;
+    layout.rows = (options.size.height() + layout.tile - 1) / layout.tile;
+
+    const Viewport viewport = fitViewport(sceneBounds(scene), options.size);
+    const double step = gridStep(viewport.scale);
+    const ScreenScene screen = mapScene(scene, viewport, layout);
+
+    // bits() до пула: отделяет данные рисунка один раз, в потоках — только запись
+    uchar *bits = image.bits();
+    const qsizetype stride = image.bytesPerLine();
+    const QImage::Format format = image.format();
+
+    pool.run(layout.count(), [&](qsizetype t, int) {
+        const QRect area = layout.area(t);
+
+        // плитка — окно в общий буфер рисунка, без копирования
+        QImage part(bits + area.top() * stride + area.left() * 4,
+                    area.width(), area.height(), stride, format);
+        QPainter p(&part);
+        p.translate(-area.left(), -area.top());
+
+        p.fillRect(area, Qt::white);
+        if (options.grid)
+            drawGrid(p, area, viewport, step);
+
+        drawLayers(p, scene, screen, t);
+    });
+
+    // подписи — одним проходом: текст в потоках пула не рисуется
+    if (options.grid) {
+        QPainter p(&image);
+        drawGridLabels(p, options.size, viewport, step);
+    }
+    return image;
+}
+
+QPointF imagePoint(const Scene &scene, const QSize &size, const QPointF &p)
+{
+    return fitViewport(sceneBounds(scene), size).map(p);
+}
+
+} // namespace render
@@ -0,0 +1,55 @@
+#pragma once
+// Отрисовка сцены без окна и дисплея: те же слои, что на холсте (сетка,
+// окно, исходные и отсечённые примитивы, точки пересечения), в QImage
+// любого размера. Нужен только QGuiApplication (платформа offscreen).
+
+#include "clipcore/clipio.h"
+#include "clipcore/segmentengine.h"
+#include "clipcore/threadpool.h"
+
+#include <QImage>
+#include <QSize>
+
+namespace render {
+
+// Сцена одного вида с результатом отсечения. shapes — многоугольники
+// (Polygon, MultiPolygon; замкнутые) или ломаные (Polyline; открытые).
+struct Scene
+{
+    clip::SceneKind  kind = clip::SceneKind::Unknown;
+    QVector<QLineF>  segments;
+    QVector<QLineF>  clippedSegments;
+    clip::PolygonSet shapes;
+    clip::PolygonSet clippedShapes;
+    QVector<QPointF> points;          // точки пересечения
+    QRectF           window;
+    QVector<QPointF> windowPolygon;   // пусто — окно-прямоугольник window
+};
+
+// загрузка файла (текст или *.scb) и отсечение — как в clip-batch;
+// при ошибке в error — причина
+bool loadScene(const QString &fileName, clip::SegmentAlgorithm algorithm,
+               Scene &scene, QString &error,
+               clip::WorkStealingPool &pool = clip::WorkStealingPool::global());
+
+struct Options
+{
+    QSize size { 2048, 2048 };
+    int   tileSize = 1024;   // сторона плитки, пикселей
+    bool  grid = true;
+};
+
+// Сцена (окно и исходные примитивы) вписывается в рисунок с полями, Y
+// вверх. Рисунок делится на плитки tileSize × tileSize; плитки рисуются
+// параллельно в пуле, каждая своим QPainter прямо в свою часть общего
+// буфера. Примитивы раскладываются по плиткам один раз заранее, плитка
+// перебирает только задевающие её. Подписи сетки
+// наносятся в конце одним проходом в вызывающем потоке.
+QImage renderScene(const Scene &scene, const Options &options,
+                   clip::WorkStealingPool &pool = clip::WorkStealingPool::global());
+
+// пиксель рисунка размера size, куда renderScene() помещает логическую
+// точку p (для проверок отрисовки)
+QPointF imagePoint(const Scene &scene, const QSize &size, const QPointF &p);
+
+} // namespace render
@@ -0,0 +1,104 @@
+#include "workloads.h"
+#include <algorithm>
+#include <cmath>
+
+namespace workload {
+
+QPointF pointIn(std::mt19937 &rng, const QRectF &r)
+{
+    std::uniform_real_distribution<double> x(r.left(), r.right());
+    std::uniform_real_distribution<double> y(r.top(), r.bottom());
+    return QPointF(x(rng), y(rng));
+}
+
+QPointF pointOutside(std::mt19937 &rng, const QRectF &w)
+{
+    const QRectF ring = w.adjusted(-w.width(), -w.height(), w.width(), w.height());
+    for (;;) {
+        const QPointF p = pointIn(rng, ring);
+        if (!w.contains(p))
+            return p;
+    }
+}
+
+QVector<QLineF> randomSegments(std::mt19937 &rng, qsizetype n, const SegmentMix &mix,
+                               const QRectF &w)
+{
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    QVector<QLineF> out(n);
+    for (QLineF &s : out) {
+        const double kind = u(rng);
+        if (kind < mix.inside) {
+            s = QLineF(pointIn(rng, w), pointIn(rng, w));
+        } else if (kind < mix.inside + mix.outside) {
+            // обе точки за одной и той же гранью
+            const int side = int(u(rng) * 4) & 3;
+            const QRectF band = side == 0 ? QRectF(QPointF(w.left() - w.width(), w.top()), QPointF(w.left(), w.bottom()))
+                              : side == 1 ? QRectF(QPointF(w.right(), w.top()), QPointF(w.right() + w.width(), w.bottom()))
+                              : side == 2 ? QRectF(QPointF(w.left(), w.top() - w.height()), QPointF(w.right(), w.top()))
+                                          : QRectF(QPointF(w.left(), w.bottom()), QPointF(w.right(), w.bottom() + w.height()));
+            s = QLineF(pointIn(rng, band), pointIn(rng, band));
+        } else if (kind < mix.inside + mix.outside + mix.crossing) {
+            s = QLineF(pointIn(rng, w), pointOutside(rng, w));
+        } else {
+            const QRectF all = w.adjusted(-w.width(), -w.height(), w.width(), w.height());
+            s = QLineF(pointIn(rng, all), pointIn(rng, all));
+        }
+    }
+    return out;
+}
+
+QVector<QLineF> longDiagonals(std::mt19937 &rng, qsizetype n, const QRectF &w)
+{
+    std::uniform_real_distribution<double> angle(0.0, 2 * M_PI);
+    std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+    const double r = 20 * std::max(w.width(), w.height());
+    const QPointF c = w.center();
+    QVector<QLineF> out(n);
+    for (QLineF &s : out) {
+        const double a = angle(rng);
+        const double b = a + M_PI + jitter(rng);
+        s = QLineF(c + r * QPointF(std::cos(a), std::sin(a)),
+                   c + r * QPointF(std::cos(b), std::sin(b)));
+    }
+    return out;
+}
+
+QVector<QPointF> zigZagPolygon(std::mt19937 &rng, qsizetype teeth, const QRectF &w)
+{
+    std::uniform_real_distribution<double> wobble(0.9, 1.1);
+    const double half = std::min(w.width(), w.height()) / 2;
+    const QPointF c = w.center();
+    QVector<QPointF> out(2 * teeth);
+    for (qsizetype i = 0; i < out.size(); ++i) {
+        const double a = M_PI * i / teeth;
+        const double r = (i % 2 ? 0.4 : 1.6) * half * wobble(rng);
+        out[i] = c + r * QPointF(std::cos(a), std::sin(a));
+    }
+    return out;
+}
+
+QVector<QPointF> convexNgon(qsizetype n, const QRectF &w)
+{
+    const double r = 0.65 * std::max(w.width(), w.height());
+    const QPointF c = w.center();
+    QVector<QPointF> out(n);
+    for (qsizetype i = 0; i < n; ++i) {
+        const double a = 2 * M_PI * i / n;
+        out[i] = c + r * QPointF(std::cos(a), std::sin(a));
+    }
+    return out;
+}
+
+QVector<QPointF> hexagonWindow(const QRectF &w)
+{
+    QVector<QPointF> out;
+    for (int k = 0; k < 6; ++k) {
+        const double a = M_PI / 3 * k + 0.2;
+        out.append(w.center() + QPointF(w.width() / 2 * std::cos(a),
+                                        w.height() / 2 * std::sin(a)));
+    }
+    return out;
+}
+
+} // namespace workload
@@ -0,0 +1,42 @@
+#pragma once
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <random>
+
+// Синтетические данные для clip-bench и clip-perf. Всё порождается из
+// переданного генератора, так что одинаковый seed даёт одинаковые данные.
+
+namespace workload {
+
+// Доли отрезков: целиком внутри окна, целиком за одной гранью (тривиально
+// отбрасываются) и пересекающих границу; остальные — как выпадет.
+struct SegmentMix
+{
+    double inside, outside, crossing;
+};
+
+QPointF pointIn(std::mt19937 &rng, const QRectF &r);
+
+// точка снаружи окна в кольце шириной в размер окна
+QPointF pointOutside(std::mt19937 &rng, const QRectF &w);
+
+QVector<QLineF> randomSegments(std::mt19937 &rng, qsizetype n, const SegmentMix &mix,
+                               const QRectF &w);
+
+// длинные отрезки через окрестность центра окна под случайными углами
+QVector<QLineF> longDiagonals(std::mt19937 &rng, qsizetype n, const QRectF &w);
+
+// Зубчатый многоугольник вокруг центра окна: вершины попеременно на
+// внешнем (за окном) и внутреннем радиусе, так что каждый зуб дважды
+// пересекает границу.
+QVector<QPointF> zigZagPolygon(std::mt19937 &rng, qsizetype teeth, const QRectF &w);
+
+// выпуклый n-угольник, вписанный в окружность чуть больше окна
+QVector<QPointF> convexNgon(qsizetype n, const QRectF &w);
+
+// выпуклое окно-шестиугольник, вписанное в w
+QVector<QPointF> hexagonWindow(const QRectF &w);
+
+} // namespace workload